@@ -36,11 +36,13 @@ public class ComfyUIIntegration : ModuleRules
                 "InputCore",
                 "Json",
                 "HTTP",
+                "WebSockets",
                 "MeshDescription",
                 "StaticMeshDescription",
                 "Slate",
                 "SlateCore",
                 "ToolMenus",
+                "DirectoryWatcher",
             }
         );
 
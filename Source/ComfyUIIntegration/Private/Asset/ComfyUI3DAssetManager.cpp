@@ -16,6 +16,7 @@
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
 #include "MeshDescription.h"
 #include "StaticMeshAttributes.h"
 #include "StaticMeshOperations.h"
@@ -105,6 +106,69 @@ UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromGLTF(const TArray<uint8
 
     UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Created temp file: %s"), *TempFilePath);
 
+    UStaticMesh* ImportedMesh = ImportGLTFFile(TempFilePath, TempFileName);
+
+    // 清理临时文件
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (PlatformFile.FileExists(*TempFilePath))
+    {
+        if (PlatformFile.DeleteFile(*TempFilePath))
+        {
+            UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Cleaned up temp file: %s"), *TempFilePath);
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromGLTF: Failed to clean up temp file: %s"), *TempFilePath);
+        }
+    }
+
+    if (ImportedMesh)
+    {
+        LOG_AND_RETURN(Log, ImportedMesh, "CreateStaticMeshFromGLTF: Successfully imported glTF as StaticMesh");
+    }
+    else
+    {
+        // 作为后备方案，我们可以尝试将glTF解析为简单的几何体
+        UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromGLTF: Import failed, attempting fallback parsing"));
+        return CreateFallbackMeshFromGLTF(GLTFData);
+    }
+}
+
+UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromFile(const FString& FilePath, const FString& ModelFormat)
+{
+    if (!FPaths::FileExists(FilePath))
+        LOG_AND_RETURN(Error, nullptr, "CreateStaticMeshFromFile: File not found: %s", *FilePath);
+
+    const FString Format = ModelFormat.IsEmpty() ? FPaths::GetExtension(FilePath).ToLower() : ModelFormat.ToLower();
+
+    if (Format == TEXT("gltf") || Format == TEXT("glb"))
+    {
+        // 直接从下载的文件导入，不需要再写一份临时文件
+        UStaticMesh* ImportedMesh = ImportGLTFFile(FilePath, FGuid::NewGuid().ToString());
+        if (ImportedMesh)
+        {
+            LOG_AND_RETURN(Log, ImportedMesh, "CreateStaticMeshFromFile: Successfully imported glTF as StaticMesh");
+        }
+
+        UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromFile: Import failed, attempting fallback parsing"));
+        TArray<uint8> GLTFData;
+        if (!FFileHelper::LoadFileToArray(GLTFData, *FilePath))
+            LOG_AND_RETURN(Error, nullptr, "CreateStaticMeshFromFile: Failed to read file: %s", *FilePath);
+        return CreateFallbackMeshFromGLTF(GLTFData);
+    }
+    else if (Format == TEXT("obj"))
+    {
+        TArray<uint8> OBJData;
+        if (!FFileHelper::LoadFileToArray(OBJData, *FilePath))
+            LOG_AND_RETURN(Error, nullptr, "CreateStaticMeshFromFile: Failed to read file: %s", *FilePath);
+        return CreateStaticMeshFromOBJ(OBJData);
+    }
+
+    LOG_AND_RETURN(Error, nullptr, "CreateStaticMeshFromFile: Unsupported model format: %s", *Format);
+}
+
+UStaticMesh* UComfyUI3DAssetManager::ImportGLTFFile(const FString& FilePath, const FString& DestinationName)
+{
     UStaticMesh* ImportedMesh = nullptr;
 
     try
@@ -112,19 +176,19 @@ UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromGLTF(const TArray<uint8
         // 使用 AssetImportTask 进行导入
         UAssetImportTask* ImportTask = NewObject<UAssetImportTask>();
         if (!ImportTask)
-            LOG_AND_RETURN(Error, nullptr, "CreateStaticMeshFromGLTF: Failed to create AssetImportTask");
+            LOG_AND_RETURN(Error, nullptr, "ImportGLTFFile: Failed to create AssetImportTask");
 
         // 设置导入任务参数
-        ImportTask->Filename = TempFilePath;
+        ImportTask->Filename = FilePath;
         ImportTask->DestinationPath = TEXT("/Engine/Transient"); // 使用瞬态路径避免自动保存问题
-        ImportTask->DestinationName = TempFileName;
+        ImportTask->DestinationName = DestinationName;
         ImportTask->bReplaceExisting = true;
         ImportTask->bReplaceExistingSettings = true;
         ImportTask->bAutomated = true;
         // ImportTask->bSave = false; // 不保存到磁盘，只是临时导入
         ImportTask->bSave = true;
 
-        UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Starting import task for file: %s"), *TempFilePath);
+        UE_LOG(LogTemp, Log, TEXT("ImportGLTFFile: Starting import task for file: %s"), *FilePath);
 
         // 获取 AssetTools 模块并执行导入
         if (FModuleManager::Get().IsModuleLoaded("AssetTools"))
@@ -136,7 +200,7 @@ UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromGLTF(const TArray<uint8
             TArray<UAssetImportTask*> ImportTasks;
             ImportTasks.Add(ImportTask);
 
-            UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Executing import tasks"));
+            UE_LOG(LogTemp, Log, TEXT("ImportGLTFFile: Executing import tasks"));
 
             // 使用 IAssetTools::ImportAssetTasks 执行导入
             AssetTools.ImportAssetTasks(ImportTasks);
@@ -153,7 +217,7 @@ UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromGLTF(const TArray<uint8
                         StaticMesh->AddToRoot(); // 防止被垃圾回收
                         
                         ImportedMesh = StaticMesh;
-                        UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Successfully imported static mesh: %s"), 
+                        UE_LOG(LogTemp, Log, TEXT("ImportGLTFFile: Successfully imported static mesh: %s"), 
                                *StaticMesh->GetName());
                         break;
                     }
@@ -161,47 +225,24 @@ UStaticMesh* UComfyUI3DAssetManager::CreateStaticMeshFromGLTF(const TArray<uint8
             }
             else
             {
-                UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromGLTF: No objects were imported"));
+                UE_LOG(LogTemp, Warning, TEXT("ImportGLTFFile: No objects were imported"));
             }
         }
         else
         {
-            UE_LOG(LogTemp, Error, TEXT("CreateStaticMeshFromGLTF: AssetTools module not available"));
+            UE_LOG(LogTemp, Error, TEXT("ImportGLTFFile: AssetTools module not available"));
         }
     }
     catch (const std::exception& Exception)
     {
-        UE_LOG(LogTemp, Error, TEXT("CreateStaticMeshFromGLTF: std::exception during import: %hs"), Exception.what());
+        UE_LOG(LogTemp, Error, TEXT("ImportGLTFFile: std::exception during import: %hs"), Exception.what());
     }
     catch (...)
     {
-        UE_LOG(LogTemp, Error, TEXT("CreateStaticMeshFromGLTF: Unknown exception during import"));
+        UE_LOG(LogTemp, Error, TEXT("ImportGLTFFile: Unknown exception during import"));
     }
 
-    // 清理临时文件
-    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-    if (PlatformFile.FileExists(*TempFilePath))
-    {
-        if (PlatformFile.DeleteFile(*TempFilePath))
-        {
-            UE_LOG(LogTemp, Log, TEXT("CreateStaticMeshFromGLTF: Cleaned up temp file: %s"), *TempFilePath);
-        }
-        else
-        {
-            UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromGLTF: Failed to clean up temp file: %s"), *TempFilePath);
-        }
-    }
-
-    if (ImportedMesh)
-    {
-        LOG_AND_RETURN(Log, ImportedMesh, "CreateStaticMeshFromGLTF: Successfully imported glTF as StaticMesh");
-    }
-    else
-    {
-        // 作为后备方案，我们可以尝试将glTF解析为简单的几何体
-        UE_LOG(LogTemp, Warning, TEXT("CreateStaticMeshFromGLTF: Import failed, attempting fallback parsing"));
-        return CreateFallbackMeshFromGLTF(GLTFData);
-    }
+    return ImportedMesh;
 }
 
 bool UComfyUI3DAssetManager::Save3DModelToProject(UStaticMesh* StaticMesh, const FString& AssetName, const FString& PackagePath)
@@ -925,3 +966,23 @@ bool UComfyUI3DAssetManager::SaveOriginalModelData(const TArray<uint8>& Original
 
     LOG_AND_RETURN(Log, true, "SaveOriginalModelData: Successfully saved original data to %s", *FilePath);
 }
+
+bool UComfyUI3DAssetManager::CopyOriginalModelFile(const FString& SourceFilePath, const FString& FilePath)
+{
+    if (SourceFilePath.IsEmpty() || !FPaths::FileExists(SourceFilePath))
+        LOG_AND_RETURN(Error, false, "CopyOriginalModelFile: Source file not found: %s", *SourceFilePath);
+
+    if (FilePath.IsEmpty())
+        LOG_AND_RETURN(Error, false, "CopyOriginalModelFile: FilePath is empty");
+
+    // 确保目录存在
+    FString FileDirectory = FPaths::GetPath(FilePath);
+    if (!UComfyUIFileManager::EnsureDirectoryExists(FileDirectory))
+        LOG_AND_RETURN(Error, false, "CopyOriginalModelFile: Failed to create directory: %s", *FileDirectory);
+
+    // 文件到文件复制，不经过内存缓冲
+    if (IFileManager::Get().Copy(*FilePath, *SourceFilePath, true) != COPY_OK)
+        LOG_AND_RETURN(Error, false, "CopyOriginalModelFile: Failed to copy %s to %s", *SourceFilePath, *FilePath);
+
+    LOG_AND_RETURN(Log, true, "CopyOriginalModelFile: Successfully copied original model to %s", *FilePath);
+}
@@ -1,4 +1,6 @@
 #include "Client/ComfyUIClient.h"
+#include "Client/ComfyUIGameThreadDispatcher.h"
+#include "Network/ComfyUIHistoryScanner.h"
 #include "Utils/ComfyUIFileManager.h"
 #include "Workflow/ComfyUIWorkflowService.h"
 #include "Asset/ComfyUI3DAssetManager.h"
@@ -16,8 +18,10 @@
 #include "JsonObjectConverter.h"
 #include "Serialization/JsonSerializer.h"
 #include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
 #include "TimerManager.h"
 #include "HAL/PlatformFilemanager.h"
+#include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Containers/Ticker.h"
@@ -45,6 +49,22 @@ UComfyUIClient* UComfyUIClient::GetInstance()
 
 void UComfyUIClient::DestroyInstance()
 {
+    // 关闭事件通道，避免模块卸载后仍有回调
+    if (Instance)
+    {
+        Instance->CloseEventChannels();
+        
+        if (Instance->JobTickerHandle.IsValid())
+        {
+            FTSTicker::GetCoreTicker().RemoveTicker(Instance->JobTickerHandle);
+            Instance->JobTickerHandle.Reset();
+        }
+        Instance->JobTimers.Reset();
+        Instance->StatusCycleTimers.Reset();
+        Instance->PendingCancels.Reset();
+        Instance->HealthMonitorTimer = 0;
+    }
+    
     // 在插件环境中，不主动操作根引用
     // Instance 由 UE 的 GC 系统自动管理
     Instance = nullptr;
@@ -57,8 +77,7 @@ UComfyUIClient::UComfyUIClient()
     // 注意：在默认构造函数中不能创建默认子对象，需要使用带ObjectInitializer的构造函数
     NetworkManager = nullptr;
     ServerUrl = TEXT("http://192.168.2.169:8188");
-    LastPollTime = 0.0f;
-    bIsPolling = false;
+    ClientId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
 }
 
 UComfyUIClient::UComfyUIClient(const FObjectInitializer& ObjectInitializer)
@@ -68,8 +87,7 @@ UComfyUIClient::UComfyUIClient(const FObjectInitializer& ObjectInitializer)
     // 使用ObjectInitializer创建默认子对象
     NetworkManager = ObjectInitializer.CreateDefaultSubobject<UComfyUINetworkManager>(this, TEXT("NetworkManager"));
     ServerUrl = TEXT("http://192.168.2.169:8188");
-    LastPollTime = 0.0f;
-    bIsPolling = false;
+    ClientId = FGuid::NewGuid().ToString(EGuidFormats::DigitsWithHyphensLower);
 }
 
 void UComfyUIClient::EnsureNetworkManagerInitialized()
@@ -83,275 +101,634 @@ void UComfyUIClient::EnsureNetworkManagerInitialized()
 
 void UComfyUIClient::SetServerUrl(const FString& Url)
 {
-    ServerUrl = Url;
+    SetServerUrls({ Url });
+}
+
+void UComfyUIClient::SetServerUrls(const TArray<FString>& Urls)
+{
+    FComfyUIServerPool& Pool = GetServerPool();
+    Pool.SetServers(Urls);
+    
+    // 关闭不在新列表中的服务器的事件通道（仍有任务的服务器保留，直到任务结束后下次设置时关闭）
+    TArray<FString> ChannelUrls;
+    EventChannels.GetKeys(ChannelUrls);
+    for (const FString& ChannelUrl : ChannelUrls)
+    {
+        const bool bInPool = Pool.GetServers().ContainsByPredicate([&ChannelUrl](const FComfyUIServerStatus& Server) { return Server.Url == ChannelUrl; });
+        bool bHasJobs = false;
+        for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
+        {
+            bHasJobs |= Pair.Value->ServerUrl == ChannelUrl;
+        }
+        
+        if (!bInPool && !bHasJobs)
+        {
+            TSharedPtr<FComfyUIWebSocketChannel> Channel;
+            EventChannels.RemoveAndCopyValue(ChannelUrl, Channel);
+            Channel->OnServerEvent.Unbind();
+            Channel->OnStateChanged.Unbind();
+            Channel->Close();
+        }
+    }
+    
+    ServerUrl = Pool.GetPrimaryServer();
+    for (const FComfyUIServerStatus& Server : Pool.GetServers())
+    {
+        EnsureEventChannel(Server.Url);
+    }
+    
+    // 立即检查一次健康状态和负载（列表变化后健康快照已清空）
+    Pool.RefreshIfStale();
+}
+
+FComfyUIServerPool& UComfyUIClient::GetServerPool()
+{
+    if (!ServerPool.IsValid())
+    {
+        EnsureNetworkManagerInitialized();
+        ServerPool = MakeShared<FComfyUIServerPool>(NetworkManager);
+    }
+    return *ServerPool;
+}
+
+FString UComfyUIClient::SelectServer()
+{
+    const FString Selected = GetServerPool().PickServer();
+    return Selected.IsEmpty() ? ServerUrl : Selected;
+}
+
+const TArray<FComfyUIServerStatus>& UComfyUIClient::GetServerStatuses() const
+{
+    static const TArray<FComfyUIServerStatus> Empty;
+    return ServerPool.IsValid() ? ServerPool->GetServers() : Empty;
+}
+
+bool UComfyUIClient::HasHealthyServer() const
+{
+    return ServerPool.IsValid() && ServerPool->HasFreshHealthyServer();
+}
+
+void UComfyUIClient::StartHealthMonitor()
+{
+    if (HealthMonitorTimer != 0 && JobTimers.IsScheduled(HealthMonitorTimer))
+    {
+        return;
+    }
+    RunHealthMonitor();
+}
+
+void UComfyUIClient::RunHealthMonitor()
+{
+    // 快照仍然有效的服务器也重新检查，顺便保持连接
+    GetServerPool().RefreshHealth();
+    
+    HealthMonitorTimer = JobTimers.Schedule(FPlatformTime::Seconds(), HealthMonitorInterval, [this]()
+    {
+        RunHealthMonitor();
+    });
+    UpdateJobTicker();
+}
+
+bool UComfyUIClient::IsEventChannelConnected(const FString& InServerUrl) const
+{
+    const TSharedPtr<FComfyUIWebSocketChannel>* Channel = EventChannels.Find(
+        FComfyUIServerPool::NormalizeUrl(InServerUrl.IsEmpty() ? ServerUrl : InServerUrl));
+    return Channel && (*Channel)->IsConnected();
+}
+
+void UComfyUIClient::EnsureEventChannel(const FString& InServerUrl)
+{
+    const FString ChannelUrl = FComfyUIServerPool::NormalizeUrl(InServerUrl);
+    if (ChannelUrl.IsEmpty())
+    {
+        return;
+    }
+    
+    TSharedPtr<FComfyUIWebSocketChannel>& Channel = EventChannels.FindOrAdd(ChannelUrl);
+    if (!Channel.IsValid())
+    {
+        Channel = MakeShared<FComfyUIWebSocketChannel>(ChannelUrl, ClientId);
+        Channel->OnServerEvent.BindUObject(this, &UComfyUIClient::HandleServerEvent);
+        Channel->OnStateChanged.BindUObject(this, &UComfyUIClient::HandleEventChannelStateChanged, ChannelUrl);
+    }
+    Channel->Connect();
+}
+
+void UComfyUIClient::CloseEventChannels()
+{
+    for (TPair<FString, TSharedPtr<FComfyUIWebSocketChannel>>& Pair : EventChannels)
+    {
+        Pair.Value->OnServerEvent.Unbind();
+        Pair.Value->OnStateChanged.Unbind();
+        Pair.Value->Close();
+    }
+    EventChannels.Reset();
+}
+
+void UComfyUIClient::HandleEventChannelStateChanged(bool bConnected, FString ChannelServerUrl)
+{
+    // 事件通道断开说明服务器可能已经不可用，健康快照需要重新确认
+    if (!bConnected)
+    {
+        GetServerPool().Invalidate(ChannelServerUrl);
+    }
+    
+    TArray<TSharedPtr<FComfyUIJob>> ActiveJobs;
+    Jobs.GenerateValueArray(ActiveJobs);
+    
+    bool bNeedsStatusCheck = false;
+    for (const TSharedPtr<FComfyUIJob>& Job : ActiveJobs)
+    {
+        // 只处理这台服务器上的任务
+        if (!Job->IsActive() || Job->bOutputsReceived || Job->ServerUrl != ChannelServerUrl)
+        {
+            continue;
+        }
+        
+        if (bConnected)
+        {
+            // 通道恢复：停止回退轮询，并补查一次状态，防止断线期间错过完成事件
+            StopJobPolling(Job);
+            Job->bStatusCheckPending = true;
+            bNeedsStatusCheck = true;
+        }
+        else
+        {
+            // 通道断开：回退到 HTTP 轮询
+            UE_LOG(LogTemp, Warning, TEXT("Event channel lost, falling back to polling for prompt %s"), *Job->PromptId);
+            StartJobPolling(Job);
+        }
+    }
+    
+    // 所有任务的补查合并为一轮批量查询，而不是每个任务各查一次 /history
+    if (bNeedsStatusCheck)
+    {
+        RunStatusCycle(ChannelServerUrl);
+    }
+}
+
+void UComfyUIClient::HandleServerEvent(const FComfyUIServerEvent& Event)
+{
+    if (Event.Type == EComfyUIServerEventType::Status)
+    {
+        UE_LOG(LogTemp, VeryVerbose, TEXT("ComfyUI queue remaining: %d"), Event.QueueRemaining);
+        return;
+    }
+    
+    // 已取消的 prompt：用事件确认服务器端的取消
+    if (HandlePendingCancelEvent(Event))
+    {
+        return;
+    }
+    
+    // 按 prompt_id 分发到对应任务
+    TSharedPtr<FComfyUIJob> Job = FindJob(Event.PromptId);
+    if (!Job.IsValid() || !Job->IsActive() || Job->bOutputsReceived)
+    {
+        return;
+    }
+    
+    switch (Event.Type)
+    {
+    case EComfyUIServerEventType::ExecutionStart:
+        Job->QueuePosition = 0;
+        Job->ExecutionStartTime = FPlatformTime::Seconds();
+        Job->OnProgress.ExecuteIfBound(FComfyUIProgressInfo(0, 0.0f, TEXT(""), TEXT("正在执行..."), true));
+        break;
+        
+    case EComfyUIServerEventType::Executing:
+    case EComfyUIServerEventType::ExecutionSuccess:
+        if (Event.IsPromptFinished())
+        {
+            // 执行结束：停止回退轮询，拉取一次历史记录获取输出
+            StopJobPolling(Job);
+            PollGenerationStatus(Job);
+        }
+        else
+        {
+            Job->OnProgress.ExecuteIfBound(FComfyUIProgressInfo(0, 0.0f, Event.NodeId, TEXT("正在执行..."), true));
+        }
+        break;
+        
+    case EComfyUIServerEventType::Progress:
+        if (Event.ProgressMax > 0)
+        {
+            const float Percentage = FMath::Clamp((float)Event.ProgressValue / (float)Event.ProgressMax, 0.0f, 1.0f);
+            Job->OnProgress.ExecuteIfBound(FComfyUIProgressInfo(0, Percentage, Event.NodeId,
+                FString::Printf(TEXT("正在执行... (%d/%d)"), Event.ProgressValue, Event.ProgressMax), true));
+        }
+        break;
+        
+    case EComfyUIServerEventType::ExecutionError:
+    {
+        StopJobPolling(Job);
+        FComfyUIError Error(EComfyUIErrorType::ServerError,
+                            FString::Printf(TEXT("节点 %s 执行出错: %s"), *Event.NodeId, *Event.ErrorMessage),
+                            0, TEXT("检查工作流输入和服务器日志"), false);
+        HandleRequestError(Job, Error, [this, Job]() { RetryJob(Job); });
+        break;
+    }
+        
+    case EComfyUIServerEventType::ExecutionInterrupted:
+        UE_LOG(LogTemp, Log, TEXT("Prompt %s was interrupted on server"), *Job->PromptId);
+        break;
+        
+    default:
+        break;
+    }
+}
+
+FString UComfyUIClient::InjectClientId(const FString& WorkflowJson) const
+{
+    TSharedPtr<FJsonObject> RequestJson;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(WorkflowJson);
+    if (!FJsonSerializer::Deserialize(Reader, RequestJson) || !RequestJson.IsValid())
+    {
+        return WorkflowJson;
+    }
+    
+    // 已带有本客户端 ID 的请求原样提交，重新序列化会让超出 double 精度的整数（如随机种子）失真
+    FString RequestClientId;
+    if (RequestJson->TryGetStringField(TEXT("client_id"), RequestClientId) && RequestClientId == ClientId)
+    {
+        return WorkflowJson;
+    }
+    
+    RequestJson->SetStringField(TEXT("client_id"), ClientId);
+    
+    FString OutputString;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutputString);
+    FJsonSerializer::Serialize(RequestJson.ToSharedRef(), Writer);
+    return OutputString;
+}
+
+TSharedPtr<FComfyUIJob> UComfyUIClient::FindJob(const FString& PromptId) const
+{
+    if (PromptId.IsEmpty())
+    {
+        return nullptr;
+    }
+    
+    const TSharedPtr<FComfyUIJob>* Found = Jobs.Find(PromptId);
+    return Found ? *Found : nullptr;
+}
+
+int32 UComfyUIClient::GetActiveJobCount() const
+{
+    return Jobs.Num() + SubmittingJobs.Num();
 }
 
-void UComfyUIClient::PollGenerationStatus(const FString& PromptId)
+void UComfyUIClient::PollGenerationStatus(const TSharedPtr<FComfyUIJob>& Job)
 {
     // 使用 NetworkManager 进行状态轮询
     EnsureNetworkManagerInitialized();
     if (NetworkManager)
     {
-        NetworkManager->PollQueueStatus(ServerUrl, PromptId, 
-            [this](const FString& Response, bool bSuccess)
+        FComfyUIRequestGroupScope RequestGroup(NetworkManager, Job->GetRequestGroup());
+        NetworkManager->PollQueueStatus(Job->ServerUrl, Job->PromptId, 
+            [this, Job](const FComfyUIHttpPayload& Response, bool bSuccess)
             {
-                OnQueueStatusChecked(Response, bSuccess);
+                OnQueueStatusChecked(Job, Response, bSuccess);
             });
     }
     else
     {
         UE_LOG(LogTemp, Error, TEXT("NetworkManager not initialized"));
         FComfyUIError Error(EComfyUIErrorType::UnknownError, TEXT("NetworkManager 未初始化"), 0, TEXT("请检查插件初始化流程"), false);
-        HandleRequestError(Error, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, Error, [this, Job]() { RetryJob(Job); });
     }
 }
 
-void UComfyUIClient::PollGenerationStatus()
-{
-    PollGenerationStatus(CurrentPromptId);
-}
-#pragma optimize("", off)
-void UComfyUIClient::OnQueueStatusChecked(const FString& ResponseContent, bool bWasSuccessful)
+void UComfyUIClient::OnQueueStatusChecked(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHttpPayload& ResponseContent, bool bWasSuccessful)
 {
+    // 任务已取消、已结束或已经在处理输出时，忽略迟到的状态响应
+    if (!Job->IsActive() || Job->bOutputsReceived)
+    {
+        return;
+    }
+    
     if (!bWasSuccessful)
     {
-        StopAsyncPolling();
+        StopJobPolling(Job);
         FComfyUIError Error(EComfyUIErrorType::ConnectionFailed, TEXT("无法获取生成状态"), 0, TEXT("检查网络连接"), true);
-        HandleRequestError(Error, [this]() { PollGenerationStatus(CurrentPromptId); });
+        HandleRequestError(Job, Error, [this, Job]() { PollGenerationStatus(Job); });
         return;
     }
 
-    UE_LOG(LogTemp, VeryVerbose, TEXT("Queue status response: %s"), *ResponseContent);
+    UE_LOG(LogTemp, VeryVerbose, TEXT("History response: %d bytes"), ResponseContent.Num());
     
-    // 解析队列状态并更新进度
-    FComfyUIProgressInfo ProgressInfo = ParseQueueStatus(ResponseContent);
-    OnGenerationProgressCallback.ExecuteIfBound(ProgressInfo);
+    // 在工作线程扫描历史记录，游戏线程只处理提取出的状态和输出
+    struct FParseResult
+    {
+        FComfyUIHttpPayload Content;
+        TMap<FString, FComfyUIHistoryEntry> Entries;
+    };
+    TSharedRef<FParseResult> Result = MakeShared<FParseResult>();
+    Result->Content = ResponseContent;
+    
+    const FString PromptId = Job->PromptId;
+    TWeakObjectPtr<UComfyUIClient> WeakThis(this);
+    TSharedPtr<FComfyUIJob> JobPtr = Job;
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [Result, PromptId]()
+        {
+            FComfyUIHistoryScanner::Scan(Result->Content.GetView(), Result->Entries, PromptId);
+            Result->Content.Reset();
+        },
+        [WeakThis, JobPtr, Result]()
+        {
+            if (UComfyUIClient* Client = WeakThis.Get())
+            {
+                Client->OnJobHistoryParsed(JobPtr, Result->Entries.Find(JobPtr->PromptId));
+            }
+        });
+}
+
+void UComfyUIClient::OnJobHistoryParsed(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry* PromptHistory)
+{
+    if (!Job->IsActive() || Job->bOutputsReceived)
+    {
+        return;
+    }
     
-    // 如果任务被取消，停止处理
-    if (bIsCancelled) return;
+    // 有历史记录表示已完成
+    if (PromptHistory)
+    {
+        ProcessHistoryEntry(Job, *PromptHistory);
+        return;
+    }
     
-    // 解析响应检查是否完成
-    TSharedPtr<FJsonObject> JsonObject;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
+    // 生成未完成：事件通道在线时由推送事件驱动完成检测，仅在断线时加入批量轮询
+    if (IsEventChannelConnected(Job->ServerUrl))
+    {
+        UE_LOG(LogTemp, VeryVerbose, TEXT("Generation still in progress, waiting for server events..."));
+    }
+    else
+    {
+        UE_LOG(LogTemp, VeryVerbose, TEXT("Generation still in progress, continuing to poll..."));
+        StartJobPolling(Job);
+    }
+}
+
+void UComfyUIClient::ProcessHistoryEntry(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry& PromptHistory)
+{
+    if (!Job->IsActive() || Job->bOutputsReceived)
+    {
+        return;
+    }
     
-    bool bGenerationComplete = false;
+    // 生成完成，停止轮询
+    StopJobPolling(Job);
+    UE_LOG(LogTemp, Log, TEXT("Generation completed for prompt %s, stopped async polling"), *Job->PromptId);
     
-    if (FJsonSerializer::Deserialize(Reader, JsonObject))
+    // 服务器记录的执行状态为错误时直接报告
+    if (PromptHistory.IsError())
+    {
+        FComfyUIError ExecutionError(EComfyUIErrorType::ServerError, 
+                                   TEXT("工作流在服务器上执行出错"), 
+                                   0,
+                                   TEXT("检查工作流输入和服务器日志"), false);
+        HandleRequestError(Job, ExecutionError, [this, Job]() { RetryJob(Job); });
+        return;
+    }
+    
+    RecordExecutionTime(Job, PromptHistory);
+    
+    // 待下载的输出，先收集完再统一发起下载，保证计数在任何下载回调之前就绪
+    TArray<FComfyUIOutputRef> PendingOutputs;
+    Job->Result = FComfyUIWorkflowResult();
+    
+    // 每个输出节点的每个输出文件都要下载
+    for (const FComfyUIHistoryNodeOutput& Node : PromptHistory.Outputs)
     {
-        // 检查是否有历史记录（表示完成）
-        if (JsonObject->HasField(CurrentPromptId))
+        // 图像输出（SaveImage/PreviewImage 的批量输出）
+        for (int32 Index = 0; Index < Node.Images.Num(); ++Index)
+        {
+            const FComfyUIHistoryFile& Image = Node.Images[Index];
+            FComfyUIOutputRef& Output = PendingOutputs.AddDefaulted_GetRef();
+            Output.Type = EComfyUINodeOutputType::Image;
+            Output.NodeId = Node.NodeId;
+            Output.OutputIndex = Index;
+            Output.Filename = Image.Filename;
+            Output.Subfolder = Image.Subfolder;
+            Output.FolderType = Image.FolderType;
+            
+            UE_LOG(LogTemp, Log, TEXT("Found generated image: %s in %s"), *Output.Filename, *Output.Subfolder);
+        }
+        
+        // 文本输出：ShowText 节点输出的模型路径按模型下载，其他文本直接作为结果
+        bool bFoundMeshFromText = false;
+        for (int32 Index = 0; Index < Node.Texts.Num(); ++Index)
         {
-            bGenerationComplete = true;
+            const FString& TextOutput = Node.Texts[Index];
+            if (TextOutput.IsEmpty())
+            {
+                continue;
+            }
             
-            // 生成完成，获取输出信息
-            TSharedPtr<FJsonObject> PromptHistory = JsonObject->GetObjectField(CurrentPromptId);
-            if (PromptHistory.IsValid() && PromptHistory->HasField(TEXT("outputs")))
+            if (TextOutput.EndsWith(TEXT(".glb")) || TextOutput.EndsWith(TEXT(".gltf")))
             {
-                TSharedPtr<FJsonObject> Outputs = PromptHistory->GetObjectField(TEXT("outputs"));
-                UE_LOG(LogTemp, Log, TEXT("Generation completed with outputs: %s"), *ResponseContent);
+                // ShowText输出的是完整路径，通常不包含子文件夹
+                FComfyUIOutputRef& Output = PendingOutputs.AddDefaulted_GetRef();
+                Output.Type = EComfyUINodeOutputType::Mesh;
+                Output.NodeId = Node.NodeId;
+                Output.OutputIndex = Index;
+                Output.Filename = FPaths::GetCleanFilename(TextOutput);
+                bFoundMeshFromText = true;
                 
-                // 查找输出节点
-                bool bFoundOutput = false;
-                for (auto& OutputPair : Outputs->Values)
-                {
-                    TSharedPtr<FJsonObject> OutputNode = OutputPair.Value->AsObject();
-                    if (OutputNode.IsValid())
-                    {
-                        // 检查图像输出
-                        if (OutputNode->HasField(TEXT("images")))
-                        {
-                            const TArray<TSharedPtr<FJsonValue>>* ImagesArray;
-                            if (OutputNode->TryGetArrayField(TEXT("images"), ImagesArray) && ImagesArray->Num() > 0)
-                            {
-                                // 获取第一张图片的信息
-                                TSharedPtr<FJsonObject> ImageInfo = (*ImagesArray)[0]->AsObject();
-                                if (ImageInfo.IsValid())
-                                {
-                                    FString Filename = ImageInfo->GetStringField(TEXT("filename"));
-                                    FString Subfolder = ImageInfo->GetStringField(TEXT("subfolder"));
-                                    FString Type = ImageInfo->GetStringField(TEXT("type"));
-
-                                    UE_LOG(LogTemp, Log, TEXT("Found generated image: %s in %s"), *Filename, *Subfolder);
-
-                                    // 重置重试状态，因为状态检查成功
-                                    ResetRetryState();
-                                    // 下载图片
-                                    DownloadGeneratedImage(Filename, Subfolder, Type);
-                                    bFoundOutput = true;
-                                }
-                            }
-                        }
-                    
-                        // 检查3D模型输出
-                        FString MeshFilename;
-                        FString MeshSubfolder;
-                        
-                        // 检查文本输出（ShowText节点输出的文件路径）
-                        if (OutputNode->HasField(TEXT("text")))
-                        {
-                            const TArray<TSharedPtr<FJsonValue>>* TextArray;
-                            if (OutputNode->TryGetArrayField(TEXT("text"), TextArray) && TextArray->Num() > 0)
-                            {
-                                FString TextOutput = (*TextArray)[0]->AsString();
-                                if (!TextOutput.IsEmpty() && (TextOutput.EndsWith(TEXT(".glb")) || TextOutput.EndsWith(TEXT(".gltf"))))
-                                {
-                                    // 从文本输出中提取文件名
-                                    MeshFilename = FPaths::GetCleanFilename(TextOutput);
-                                    MeshSubfolder = TEXT(""); // ShowText输出的是完整路径，通常不包含子文件夹
-                                    
-                                    UE_LOG(LogTemp, Log, TEXT("Found 3D model path from text output: %s"), *TextOutput);
-                                }
-                            }
-                        }
-                        
-                        // 如果没有从文本输出找到，检查传统的3D模型输出格式
-                        if (MeshFilename.IsEmpty())
-                        {
-                            TArray<FString> MeshFieldNames = {TEXT("gltf"), TEXT("glb"), TEXT("meshes"), TEXT("mesh")};
-                            
-                            for (const FString& FieldName : MeshFieldNames)
-                            {
-                                if (OutputNode->HasField(FieldName))
-                                {
-                                    const TArray<TSharedPtr<FJsonValue>>* MeshArray;
-                                    if (OutputNode->TryGetArrayField(FieldName, MeshArray) && MeshArray->Num() > 0)
-                                    {
-                                        TSharedPtr<FJsonObject> MeshInfo = (*MeshArray)[0]->AsObject();
-                                        if (MeshInfo.IsValid())
-                                        {
-                                            MeshFilename = MeshInfo->GetStringField(TEXT("filename"));
-                                            MeshSubfolder = MeshInfo->GetStringField(TEXT("subfolder"));
-                                            break; // 找到第一个有效的就停止
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        
-                        if (!MeshFilename.IsEmpty())
-                        {
-                            UE_LOG(LogTemp, Log, TEXT("Found generated 3D model: %s in %s"), *MeshFilename, *MeshSubfolder);
-                            
-                            // 重置重试状态
-                            ResetRetryState();
-                            // 下载3D模型
-                            DownloadGenerated3DModel(MeshFilename, MeshSubfolder);
-                            bFoundOutput = true;
-                        }
-                    }
-                }
+                UE_LOG(LogTemp, Log, TEXT("Found 3D model path from text output: %s"), *TextOutput);
+            }
+            else
+            {
+                FComfyUIOutputItem& Item = Job->Result.Outputs.AddDefaulted_GetRef();
+                Item.Type = EComfyUINodeOutputType::Text;
+                Item.NodeId = Node.NodeId;
+                Item.OutputIndex = Index;
+                Item.Text = TextOutput;
+            }
+        }
+        
+        // 如果没有从文本输出找到，使用传统的3D模型输出格式
+        if (!bFoundMeshFromText)
+        {
+            for (int32 Index = 0; Index < Node.Meshes.Num(); ++Index)
+            {
+                const FComfyUIHistoryFile& Mesh = Node.Meshes[Index];
+                FComfyUIOutputRef& Output = PendingOutputs.AddDefaulted_GetRef();
+                Output.Type = EComfyUINodeOutputType::Mesh;
+                Output.NodeId = Node.NodeId;
+                Output.OutputIndex = Index;
+                Output.Filename = Mesh.Filename;
+                Output.Subfolder = Mesh.Subfolder;
                 
-                if (!bFoundOutput)
-                {
-                    // 如果没有找到任何输出，报告错误
-                    FComfyUIError OutputError(EComfyUIErrorType::ServerError, 
-                                            TEXT("生成完成但未找到输出"), 
-                                            0,
-                                            TEXT("检查工作流是否包含输出节点"), false);
-                    HandleRequestError(OutputError, [this]() { RetryCurrentOperation(); });
-                }
+                UE_LOG(LogTemp, Log, TEXT("Found generated 3D model: %s in %s"), *Output.Filename, *Output.Subfolder);
             }
         }
     }
-    else
+    
+    if (PendingOutputs.Num() == 0 && Job->Result.Outputs.Num() == 0)
     {
-        // JSON解析失败，但在生成过程中这可能是正常的（空响应）
-        UE_LOG(LogTemp, Log, TEXT("JSON parsing failed - this is normal during generation, continuing to poll"));
+        // 如果没有找到任何输出，报告错误
+        FComfyUIError OutputError(EComfyUIErrorType::ServerError, 
+                                TEXT("生成完成但未找到输出"), 
+                                0,
+                                TEXT("检查工作流是否包含输出节点"), false);
+        HandleRequestError(Job, OutputError, [this, Job]() { RetryJob(Job); });
+        return;
     }
     
-    // 无论JSON解析是否成功，只要生成未完成，就继续轮询
-    if (!bGenerationComplete)
+    // 重置重试状态，因为状态检查成功
+    Job->ResetRetryState();
+    Job->bOutputsReceived = true;
+    Job->PendingDownloads = PendingOutputs.Num();
+    
+    // 通知生成完成
+    Job->OnCompleted.ExecuteIfBound();
+    
+    // 只有文本输出时没有需要下载的内容
+    if (PendingOutputs.Num() == 0)
     {
-        UE_LOG(LogTemp, VeryVerbose, TEXT("Generation still in progress, continuing to poll..."));
-        
-        // 使用异步轮询代替计时器
-        if (!bIsPolling) StartAsyncPolling();
+        FinishJob(Job);
+        return;
     }
-    else
+    
+    // 所有下载同时发出，由网络调度器按每台服务器的并发上限排队
+    for (const FComfyUIOutputRef& Output : PendingOutputs)
     {
-        // 生成完成，停止轮询
-        StopAsyncPolling();
-        UE_LOG(LogTemp, Log, TEXT("Generation completed, stopped async polling"));
-        
-        // 重置重试状态
-        ResetRetryState();
+        if (!Job->IsActive())
+        {
+            break;
+        }
         
-        // 通知生成完成
-        OnGenerationCompletedCallback.ExecuteIfBound();
+        if (Output.Type == EComfyUINodeOutputType::Mesh)
+        {
+            DownloadGenerated3DModel(Job, Output);
+        }
+        else
+        {
+            DownloadGeneratedImage(Job, Output);
+        }
     }
 }
-#pragma optimize("", on)
-void UComfyUIClient::OnImageDownloaded(const TArray<uint8>& ImageData, bool bWasSuccessful)
+
+void UComfyUIClient::OnImageDownloaded(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output, const FComfyUIHttpPayload& ImageData, bool bWasSuccessful, TFunction<void()> RetryDownload)
 {
+    if (!Job->IsActive())
+    {
+        return;
+    }
+    
     if (!bWasSuccessful)
     {
         FComfyUIError DownloadError(EComfyUIErrorType::ImageDownloadFailed, 
                                   TEXT("图像下载失败"),
                                   0,
                                   TEXT("检查服务器状态，图像可能已生成但下载失败"), true);
-        HandleRequestError(DownloadError, [this]() { 
-            // 对于下载失败，重试整个操作
-            RetryCurrentOperation(); 
-        });
+        // 对于下载失败，只重新下载这一个输出
+        HandleRequestError(Job, DownloadError, RetryDownload, &Output);
         return;
     }
     
     UE_LOG(LogTemp, Log, TEXT("Downloaded image data: %d bytes"), ImageData.Num());
     
-    if (ImageData.Num() == 0)
+    if (ImageData.IsEmpty())
     {
         FComfyUIError EmptyImageError(EComfyUIErrorType::ImageDownloadFailed, 
                                     TEXT("下载的图像数据为空"), 
                                     0,
                                     TEXT("检查生成的图像是否有效"), true);
-        HandleRequestError(EmptyImageError, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, EmptyImageError, RetryDownload, &Output);
         return;
     }
     
-    // 创建纹理
-    UTexture2D* GeneratedTexture = UComfyUIFileManager::CreateTextureFromImageData(ImageData);
+    // 解码在任务线程上进行，多张图像同时解码；纹理只能在游戏线程创建
+    // 模块加载不是线程安全的，先在游戏线程确保已加载
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
     
-    if (GeneratedTexture)
-    {
-        UE_LOG(LogTemp, Log, TEXT("Successfully created texture: %dx%d"), 
-               GeneratedTexture->GetSizeX(), GeneratedTexture->GetSizeY());
-               
-        // 成功完成，重置重试状态
-        ResetRetryState();
-        
-        // 通知生成完成
-        // OnGenerationCompletedCallback.ExecuteIfBound();
-        
-        // 最后通知图像生成完成
-        OnImageGeneratedCallback.ExecuteIfBound(GeneratedTexture);
-    }
-    else
+    // 解码直接读取 HTTP 响应体；输出需要保留压缩数据，唯一的一次拷贝也在任务线程上完成
+    struct FDecodeState
     {
-        FComfyUIError TextureError(EComfyUIErrorType::ImageDownloadFailed, 
-                                 TEXT("无法从图像数据创建纹理"), 
-                                 0,
-                                 TEXT("检查图像格式是否支持，或尝试重新生成"), true);
-        HandleRequestError(TextureError, [this]() { RetryCurrentOperation(); });
-    }
+        FComfyUIHttpPayload Payload;
+        TArray<uint8> Compressed;
+        TArray<uint8> BGRA;
+        int32 Width = 0;
+        int32 Height = 0;
+        bool bDecoded = false;
+    };
+    TSharedRef<FDecodeState> State = MakeShared<FDecodeState>();
+    State->Payload = ImageData;
+    
+    TWeakObjectPtr<UComfyUIClient> WeakThis(this);
+    TSharedPtr<FComfyUIJob> JobPtr = Job;
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [State]()
+        {
+            State->bDecoded = UComfyUIFileManager::DecodeImageData(State->Payload.GetData(), State->BGRA, State->Width, State->Height);
+            if (State->bDecoded)
+            {
+                State->Compressed = State->Payload.CopyData();
+            }
+            State->Payload.Reset();
+        },
+        [WeakThis, JobPtr, Output, State, RetryDownload]()
+        {
+            UComfyUIClient* Client = WeakThis.Get();
+            if (!Client || !JobPtr->IsActive())
+            {
+                return;
+            }
+            
+            UTexture2D* GeneratedTexture = State->bDecoded
+                ? UComfyUIFileManager::CreateTextureFromBGRA(State->BGRA, State->Width, State->Height)
+                : nullptr;
+            if (!GeneratedTexture)
+            {
+                FComfyUIError TextureError(EComfyUIErrorType::ImageDownloadFailed, 
+                                         TEXT("无法从图像数据创建纹理"), 
+                                         0,
+                                         TEXT("检查图像格式是否支持，或尝试重新生成"), true);
+                Client->HandleRequestError(JobPtr, TextureError, RetryDownload, &Output);
+                return;
+            }
+            
+            UE_LOG(LogTemp, Log, TEXT("Successfully created texture: %dx%d"), 
+                   GeneratedTexture->GetSizeX(), GeneratedTexture->GetSizeY());
+            
+            FComfyUIOutputItem Item;
+            Item.Type = EComfyUINodeOutputType::Image;
+            Item.NodeId = Output.NodeId;
+            Item.OutputIndex = Output.OutputIndex;
+            Item.FileName = Output.Filename;
+            Item.RawData = MoveTemp(State->Compressed);
+            Item.ProcessedAsset = GeneratedTexture;
+            Client->AddJobOutput(JobPtr, MoveTemp(Item));
+            
+            // 该输出成功完成，只清除它自己的重试状态
+            JobPtr->OutputRetries.Remove(Output.GetKey());
+            
+            // 最后通知图像生成完成
+            JobPtr->OnImageGenerated.ExecuteIfBound(GeneratedTexture);
+            Client->OnJobOutputFinished(JobPtr);
+        });
 }
 
-void UComfyUIClient::DownloadGeneratedImage(const FString& Filename, const FString& Subfolder, const FString& Type)
+void UComfyUIClient::DownloadGeneratedImage(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output)
 {
     // 构建图片下载URL
-    FString ImageUrl = ServerUrl + TEXT("/view");
+    FString ImageUrl = Job->ServerUrl + TEXT("/view");
     
     // 添加查询参数
     TArray<FString> QueryParams;
-    QueryParams.Add(FString::Printf(TEXT("filename=%s"), *FGenericPlatformHttp::UrlEncode(Filename)));
+    QueryParams.Add(FString::Printf(TEXT("filename=%s"), *FGenericPlatformHttp::UrlEncode(Output.Filename)));
     
-    if (!Subfolder.IsEmpty())
+    if (!Output.Subfolder.IsEmpty())
     {
-        QueryParams.Add(FString::Printf(TEXT("subfolder=%s"), *FGenericPlatformHttp::UrlEncode(Subfolder)));
+        QueryParams.Add(FString::Printf(TEXT("subfolder=%s"), *FGenericPlatformHttp::UrlEncode(Output.Subfolder)));
     }
     
-    if (!Type.IsEmpty())
+    if (!Output.FolderType.IsEmpty())
     {
-        QueryParams.Add(FString::Printf(TEXT("type=%s"), *FGenericPlatformHttp::UrlEncode(Type)));
+        QueryParams.Add(FString::Printf(TEXT("type=%s"), *FGenericPlatformHttp::UrlEncode(Output.FolderType)));
     }
     
     if (QueryParams.Num() > 0)
@@ -365,17 +742,22 @@ void UComfyUIClient::DownloadGeneratedImage(const FString& Filename, const FStri
     EnsureNetworkManagerInitialized();
     if (NetworkManager)
     {
+        TFunction<void()> RetryDownload = [this, Job, Output]()
+        {
+            DownloadGeneratedImage(Job, Output);
+        };
+        FComfyUIRequestGroupScope RequestGroup(NetworkManager, Job->GetRequestGroup());
         NetworkManager->DownloadImage(ImageUrl, 
-            [this](const TArray<uint8>& ImageData, bool bSuccess)
+            [this, Job, Output, RetryDownload](const FComfyUIHttpPayload& ImageData, bool bSuccess)
             {
-                OnImageDownloaded(ImageData, bSuccess);
+                OnImageDownloaded(Job, Output, ImageData, bSuccess, RetryDownload);
             });
     }
     else
     {
         UE_LOG(LogTemp, Error, TEXT("NetworkManager not initialized"));
         FComfyUIError Error(EComfyUIErrorType::UnknownError, TEXT("NetworkManager 未初始化"), 0, TEXT("请检查插件初始化流程"), false);
-        HandleRequestError(Error, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, Error, [this, Job]() { RetryJob(Job); });
     }
 }
 
@@ -385,40 +767,91 @@ void UComfyUIClient::TestServerConnection(const FOnConnectionTested& OnComplete)
     EnsureNetworkManagerInitialized();
     if (NetworkManager)
     {
-        NetworkManager->TestServerConnection(ServerUrl, 
-            [OnComplete](bool bSuccess, const FString& ErrorMessage)
-            {
-                OnComplete.ExecuteIfBound(bSuccess, ErrorMessage);
-            });
-    }
-    else
-    {
-        OnComplete.ExecuteIfBound(false, TEXT("NetworkManager 未初始化"));
-    }
-}
-
-// ========== 错误处理和重试机制 ==========
-
-void UComfyUIClient::HandleRequestError(const FComfyUIError& Error, TFunction<void()> RetryFunction)
+        TArray<FString> Urls;
+        for (const FComfyUIServerStatus& Server : GetServerPool().GetServers())
+        {
+            Urls.Add(Server.Url);
+        }
+        if (Urls.Num() == 0)
+        {
+            Urls.Add(ServerUrl);
+        }
+        
+        // 服务器池中任意一台可用即视为连接成功，不可用的服务器不会再分配任务
+        struct FTestState
+        {
+            int32 Remaining = 0;
+            bool bAnySuccess = false;
+            FString LastError;
+        };
+        TSharedRef<FTestState> State = MakeShared<FTestState>();
+        State->Remaining = Urls.Num();
+        
+        for (const FString& Url : Urls)
+        {
+            NetworkManager->TestServerConnection(Url, 
+                [this, Url, State, OnComplete](bool bSuccess, const FString& ErrorMessage)
+                {
+                    if (bSuccess)
+                    {
+                        State->bAnySuccess = true;
+                    }
+                    else
+                    {
+                        GetServerPool().ReportFailure(Url);
+                        State->LastError = ErrorMessage;
+                    }
+                    
+                    if (--State->Remaining == 0)
+                    {
+                        OnComplete.ExecuteIfBound(State->bAnySuccess, State->bAnySuccess ? FString() : State->LastError);
+                    }
+                });
+        }
+    }
+    else
+    {
+        OnComplete.ExecuteIfBound(false, TEXT("NetworkManager 未初始化"));
+    }
+}
+
+// ========== 错误处理和重试机制 ==========
+
+void UComfyUIClient::HandleRequestError(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIError& Error, TFunction<void()> RetryFunction,
+                                        const FComfyUIOutputRef* Output)
 {
+    if (!Job->IsActive())
+    {
+        return;
+    }
+    
     EnsureNetworkManagerInitialized();
-    LastErrorType = Error.ErrorType;
-    LastErrorMessage = Error.ErrorMessage;
+    Job->LastError = Error;
     
-    UE_LOG(LogTemp, Error, TEXT("ComfyUI Request Error: %s (Type: %d, HTTP: %d)"), 
-           *Error.ErrorMessage, (int32)Error.ErrorType, Error.HttpStatusCode);
+    // 连接类错误立即使该服务器的健康快照失效，新任务不再跳过连接测试
+    if (Error.ErrorType == EComfyUIErrorType::ConnectionFailed || Error.ErrorType == EComfyUIErrorType::Timeout ||
+        Error.ErrorType == EComfyUIErrorType::ServerUnavailable)
+    {
+        GetServerPool().ReportFailure(Job->ServerUrl);
+    }
+    
+    UE_LOG(LogTemp, Error, TEXT("ComfyUI Request Error [%s]: %s (Type: %d, HTTP: %d)"), 
+           *Job->PromptId, *Error.ErrorMessage, (int32)Error.ErrorType, Error.HttpStatusCode);
            
-    if (NetworkManager->ShouldRetryRequest(Error, CurrentRetryCount, MaxRetryAttempts))
+    // 输出下载各自计数，其他输出的失败或成功不影响该输出的重试次数
+    const FString OutputKey = Output ? Output->GetKey() : FString();
+    int32& RetryCount = Output ? Job->OutputRetries.FindOrAdd(OutputKey).RetryCount : Job->RetryCount;
+    if (NetworkManager->ShouldRetryRequest(Error, RetryCount, MaxRetryAttempts))
     {
-        CurrentRetryCount++;
+        RetryCount++;
+        const int32 Attempt = RetryCount;
         
-        UE_LOG(LogTemp, Warning, TEXT("Retrying request... Attempt %d/%d"), 
-               CurrentRetryCount, MaxRetryAttempts);
+        UE_LOG(LogTemp, Warning, TEXT("Retrying request%s%s... Attempt %d/%d"), 
+               Output ? TEXT(" for output ") : TEXT(""), *OutputKey, Attempt, MaxRetryAttempts);
                
-        OnRetryAttemptCallback.ExecuteIfBound(CurrentRetryCount);
+        Job->OnRetryAttempt.ExecuteIfBound(Attempt);
         
-        // 使用异步重试代替计时器
-        StartAsyncRetry(RetryFunction, RetryDelaySeconds);
+        StartJobRetry(Job, RetryFunction, ComputeRetryDelay(Job, Error, Attempt), OutputKey);
     }
     else
     {
@@ -426,22 +859,32 @@ void UComfyUIClient::HandleRequestError(const FComfyUIError& Error, TFunction<vo
         FString UserFriendlyMessage = GetUserFriendlyErrorMessage(Error);
         
         UE_LOG(LogTemp, Error, TEXT("Final error after %d attempts: %s"), 
-               CurrentRetryCount, *UserFriendlyMessage);
+               RetryCount, *UserFriendlyMessage);
                
-        OnGenerationFailedCallback.ExecuteIfBound(Error, false);
-        OnImageGeneratedCallback.ExecuteIfBound(nullptr);
+        Job->OnFailed.ExecuteIfBound(Error, false);
+        Job->OnImageGenerated.ExecuteIfBound(nullptr);
         
-        StopAsyncPolling();
-        StopAsyncRetry();
-        ResetRetryState();
+        FinishJob(Job);
     }
 }
 
-void UComfyUIClient::ResetRetryState()
+float UComfyUIClient::ComputeRetryDelay(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIError& Error, int32 RetryCount) const
 {
-    CurrentRetryCount = 0;
-    LastErrorMessage.Empty();
-    LastErrorType = EComfyUIErrorType::None;
+    // 指数退避，在 [0.5, 1] 倍之间随机抖动，避免多个客户端同时重试
+    const float Backoff = FMath::Min(RetryDelaySeconds * FMath::Pow(2.0f, (float)FMath::Max(RetryCount - 1, 0)), MaxRetryDelaySeconds);
+    float Delay = Backoff * FMath::FRandRange(0.5f, 1.0f);
+    
+    // 服务器要求的 Retry-After 和熔断冷却时间是下限，再加一点抖动错开探测
+    float MinDelay = Error.RetryAfterSeconds;
+    if (NetworkManager)
+    {
+        MinDelay = FMath::Max(MinDelay, (float)NetworkManager->GetRetryDelay(Job->ServerUrl));
+    }
+    if (MinDelay > 0.0f)
+    {
+        Delay = FMath::Max(Delay, MinDelay + FMath::FRandRange(0.0f, 1.0f));
+    }
+    return Delay;
 }
 
 FString UComfyUIClient::GetUserFriendlyErrorMessage(const FComfyUIError& Error)
@@ -456,14 +899,40 @@ FString UComfyUIClient::GetUserFriendlyErrorMessage(const FComfyUIError& Error)
     return Error.ErrorMessage;
 }
 
+void UComfyUIClient::SubmitJob(const TSharedPtr<FComfyUIJob>& Job)
+{
+    // 发送工作流JSON到ComfyUI服务器
+    FString PromptEndpoint = Job->ServerUrl + TEXT("/prompt");
+    // 提交请求不归入任务的请求组：中途中止无法知道服务器是否已收到，取消后由响应中的 prompt_id 在服务器端取消
+    NetworkManager->SendRequest(PromptEndpoint, Job->RequestJson, [this, Job](const FString& Response, bool bSuccess) {
+        if (Job->IsActive())
+        {
+            OnPromptResponse(Job, Response, bSuccess);
+        }
+        else if (Job->bIsCancelled && bSuccess)
+        {
+            // 提交期间已取消：prompt 已进入服务器队列，从队列中删除
+            TSharedPtr<FJsonObject> JsonObject;
+            TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Response);
+            FString PromptId;
+            if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid() &&
+                JsonObject->TryGetStringField(TEXT("prompt_id"), PromptId) && !PromptId.IsEmpty())
+            {
+                CancelOnServer(Job->ServerUrl, PromptId, false);
+            }
+        }
+    });
+}
+
 // NetworkManager 回调：处理 Prompt 提交响应
-void UComfyUIClient::OnPromptResponse(const FString& ResponseContent, bool bSuccess)
+void UComfyUIClient::OnPromptResponse(const TSharedPtr<FComfyUIJob>& Job, const FString& ResponseContent, bool bSuccess)
 {
     if (!bSuccess)
     {
         UE_LOG(LogTemp, Error, TEXT("OnPromptResponse: 请求失败"));
+        GetServerPool().ReportFailure(Job->ServerUrl);
         FComfyUIError Error(EComfyUIErrorType::ConnectionFailed, TEXT("无法连接到 ComfyUI 服务器"), 0, TEXT("检查服务器URL和网络连接"), true);
-        HandleRequestError(Error, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, Error, [this, Job]() { RetryJob(Job); });
         return;
     }
     
@@ -474,17 +943,25 @@ void UComfyUIClient::OnPromptResponse(const FString& ResponseContent, bool bSucc
     TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
     if (FJsonSerializer::Deserialize(Reader, JsonObject))
     {
-        CurrentPromptId = JsonObject->GetStringField(TEXT("prompt_id"));
-        if (!CurrentPromptId.IsEmpty())
+        FString PromptId = JsonObject->GetStringField(TEXT("prompt_id"));
+        if (!PromptId.IsEmpty())
         {
+            // 登记到任务表，之后的事件和轮询都按 prompt_id 分发
+            Job->PromptId = PromptId;
+            SubmittingJobs.Remove(Job);
+            Jobs.Add(PromptId, Job);
+            
             // 重置重试状态，因为这一步成功了
-            ResetRetryState();
+            Job->ResetRetryState();
             
             // 通知生成开始
-            OnGenerationStartedCallback.ExecuteIfBound(CurrentPromptId);
+            Job->OnStarted.ExecuteIfBound(PromptId);
             
             // 开始轮询生成状态
-            PollGenerationStatus(CurrentPromptId);
+            if (Job->IsActive())
+            {
+                PollGenerationStatus(Job);
+            }
         }
         else
         {
@@ -492,7 +969,7 @@ void UComfyUIClient::OnPromptResponse(const FString& ResponseContent, bool bSucc
                                   TEXT("服务器响应中缺少prompt_id字段"), 
                                   0,
                                   TEXT("检查工作流是否正确配置"), false);
-            HandleRequestError(JsonError, [this]() { RetryCurrentOperation(); });
+            HandleRequestError(Job, JsonError, [this, Job]() { RetryJob(Job); });
         }
     }
     else
@@ -501,194 +978,859 @@ void UComfyUIClient::OnPromptResponse(const FString& ResponseContent, bool bSucc
                               TEXT("无法解析服务器响应JSON"),
                               0,
                               TEXT("检查服务器响应格式"), false);
-        HandleRequestError(JsonError, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, JsonError, [this, Job]() { RetryJob(Job); });
+    }
+}
+
+bool UComfyUIClient::CancelGeneration(const FString& PromptId)
+{
+    TSharedPtr<FComfyUIJob> Job = FindJob(PromptId);
+    if (!Job.IsValid())
+    {
+        return false;
+    }
+    
+    CancelJob(Job);
+    
+    UE_LOG(LogTemp, Log, TEXT("Generation cancelled: %s"), *PromptId);
+    return true;
+}
+
+bool UComfyUIClient::IsGenerationActive(const FString& PromptId) const
+{
+    const TSharedPtr<FComfyUIJob> Job = FindJob(PromptId);
+    return Job.IsValid() && Job->IsActive();
+}
+
+void UComfyUIClient::CancelCurrentGeneration()
+{
+    TArray<TSharedPtr<FComfyUIJob>> AllJobs = SubmittingJobs;
+    for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
+    {
+        AllJobs.Add(Pair.Value);
+    }
+    
+    for (const TSharedPtr<FComfyUIJob>& Job : AllJobs)
+    {
+        CancelJob(Job);
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("Generation cancelled (%d jobs)"), AllJobs.Num());
+}
+
+void UComfyUIClient::CancelJob(const TSharedPtr<FComfyUIJob>& Job)
+{
+    if (!Job->IsActive())
+    {
+        return;
+    }
+    
+    Job->bIsCancelled = true;
+    
+    // 输出已生成时服务器上没有需要取消的工作，只需中止下载
+    if (!Job->PromptId.IsEmpty() && !Job->bOutputsReceived)
+    {
+        CancelOnServer(Job->ServerUrl, Job->PromptId, Job->QueuePosition == 0 || Job->ExecutionStartTime > 0.0);
+    }
+    
+    FinishJob(Job);
+    
+    // 通知UI生成已完成（被取消），以便重新启用按钮
+    Job->OnCompleted.ExecuteIfBound();
+}
+
+void UComfyUIClient::CancelOnServer(const FString& InServerUrl, const FString& PromptId, bool bMayBeExecuting)
+{
+    EnsureNetworkManagerInitialized();
+    if (!NetworkManager)
+    {
+        return;
+    }
+    
+    FComfyUIPendingCancel& Pending = PendingCancels.FindOrAdd(PromptId);
+    Pending.ServerUrl = InServerUrl;
+    
+    // 删除对已开始执行的 prompt 无效，中断由确认流程在 /queue 显示其正在执行时发送
+    NetworkManager->DeleteQueuedPrompts(InServerUrl, { PromptId }, [PromptId](bool bSuccess)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("Queue delete for %s %s"), *PromptId, bSuccess ? TEXT("sent") : TEXT("failed"));
+    });
+    
+    // 本地记录的队列位置可能已经过时，可能在执行时立即查询，而不是直接中断
+    if (bMayBeExecuting)
+    {
+        VerifyServerCancel(PromptId);
+    }
+    else
+    {
+        ScheduleCancelVerify(PromptId);
+    }
+}
+
+void UComfyUIClient::SendCancelInterrupt(const FString& PromptId)
+{
+    FComfyUIPendingCancel* Pending = PendingCancels.Find(PromptId);
+    if (!Pending || Pending->bInterruptSent || !NetworkManager)
+    {
+        return;
+    }
+    
+    Pending->bInterruptSent = true;
+    UE_LOG(LogTemp, Log, TEXT("Interrupting cancelled prompt %s on %s"), *PromptId, *Pending->ServerUrl);
+    NetworkManager->InterruptPrompt(Pending->ServerUrl, PromptId, [this, PromptId](bool bSuccess)
+    {
+        // 中断请求失败时允许确认流程再次发送
+        FComfyUIPendingCancel* Failed = bSuccess ? nullptr : PendingCancels.Find(PromptId);
+        if (Failed)
+        {
+            Failed->bInterruptSent = false;
+        }
+    });
+}
+
+void UComfyUIClient::ScheduleCancelVerify(const FString& PromptId)
+{
+    FComfyUIPendingCancel* Pending = PendingCancels.Find(PromptId);
+    if (!Pending)
+    {
+        return;
+    }
+    
+    JobTimers.Cancel(Pending->VerifyTimer);
+    Pending->VerifyTimer = JobTimers.Schedule(FPlatformTime::Seconds(), CancelVerifyDelay, [this, PromptId]()
+    {
+        VerifyServerCancel(PromptId);
+    });
+    UpdateJobTicker();
+}
+
+void UComfyUIClient::VerifyServerCancel(const FString& PromptId)
+{
+    FComfyUIPendingCancel* Pending = PendingCancels.Find(PromptId);
+    if (!Pending || !NetworkManager || Pending->bVerifyInFlight)
+    {
+        return;
+    }
+    
+    JobTimers.Cancel(Pending->VerifyTimer);
+    Pending->VerifyTimer = 0;
+    if (++Pending->VerifyAttempts > MaxCancelVerifyAttempts)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Could not confirm cancellation of prompt %s on %s"), *PromptId, *Pending->ServerUrl);
+        PendingCancels.Remove(PromptId);
+        return;
+    }
+    
+    Pending->bVerifyInFlight = true;
+    TWeakObjectPtr<UComfyUIClient> WeakThis(this);
+    NetworkManager->FetchQueue(Pending->ServerUrl, [WeakThis, PromptId](const FString& Response, bool bSuccess)
+    {
+        if (!bSuccess)
+        {
+            UComfyUIClient* Client = WeakThis.Get();
+            if (FComfyUIPendingCancel* Failed = Client ? Client->PendingCancels.Find(PromptId) : nullptr)
+            {
+                Failed->bVerifyInFlight = false;
+                Client->ScheduleCancelVerify(PromptId);
+            }
+            return;
+        }
+        
+        // /queue 中包含所有排队的工作流，在工作线程解析
+        struct FParseResult
+        {
+            FString Content;
+            FComfyUIQueueSnapshot Snapshot;
+            bool bParsed = false;
+        };
+        TSharedRef<FParseResult> Result = MakeShared<FParseResult>();
+        Result->Content = Response;
+        FComfyUIGameThreadDispatcher::RunAsync(
+            [Result]()
+            {
+                Result->bParsed = FComfyUIStatusEngine::ParseQueueSnapshot(Result->Content, Result->Snapshot);
+                Result->Content.Empty();
+            },
+            [WeakThis, PromptId, Result]()
+            {
+                UComfyUIClient* Client = WeakThis.Get();
+                FComfyUIPendingCancel* Pending = Client ? Client->PendingCancels.Find(PromptId) : nullptr;
+                if (!Pending)
+                {
+                    // 等待期间已由事件通道确认
+                    return;
+                }
+                Pending->bVerifyInFlight = false;
+                
+                const int32 Position = Result->bParsed ? Result->Snapshot.GetPosition(PromptId) : INDEX_NONE;
+                if (Result->bParsed && Position == INDEX_NONE)
+                {
+                    Client->ConfirmServerCancel(PromptId, TEXT("no longer queued"));
+                    return;
+                }
+                
+                if (Position == 0)
+                {
+                    // 刚取得的快照显示该 prompt 正在执行（删除请求到达前已开始执行）
+                    Client->SendCancelInterrupt(PromptId);
+                }
+                else if (Position > 0)
+                {
+                    Client->NetworkManager->DeleteQueuedPrompts(Pending->ServerUrl, { PromptId }, [](bool) {});
+                }
+                Client->ScheduleCancelVerify(PromptId);
+            });
+    });
+}
+
+void UComfyUIClient::ConfirmServerCancel(const FString& PromptId, const TCHAR* Reason)
+{
+    FComfyUIPendingCancel Pending;
+    if (PendingCancels.RemoveAndCopyValue(PromptId, Pending))
+    {
+        JobTimers.Cancel(Pending.VerifyTimer);
+        UE_LOG(LogTemp, Log, TEXT("Cancellation of prompt %s confirmed (%s)"), *PromptId, Reason);
+    }
+}
+
+bool UComfyUIClient::HandlePendingCancelEvent(const FComfyUIServerEvent& Event)
+{
+    if (Event.PromptId.IsEmpty() || !PendingCancels.Contains(Event.PromptId))
+    {
+        return false;
+    }
+    
+    switch (Event.Type)
+    {
+    case EComfyUIServerEventType::ExecutionStart:
+    case EComfyUIServerEventType::Executing:
+    case EComfyUIServerEventType::Progress:
+        if (Event.IsPromptFinished())
+        {
+            ConfirmServerCancel(Event.PromptId, TEXT("execution finished"));
+        }
+        else if (!PendingCancels[Event.PromptId].bInterruptSent)
+        {
+            // 删除请求到达前可能已开始执行：立即查询 /queue，确认正在执行后再中断
+            VerifyServerCancel(Event.PromptId);
+        }
+        break;
+        
+    case EComfyUIServerEventType::ExecutionInterrupted:
+        ConfirmServerCancel(Event.PromptId, TEXT("interrupted"));
+        break;
+        
+    case EComfyUIServerEventType::ExecutionError:
+    case EComfyUIServerEventType::ExecutionSuccess:
+        ConfirmServerCancel(Event.PromptId, TEXT("execution finished"));
+        break;
+        
+    default:
+        break;
+    }
+    return true;
+}
+
+void UComfyUIClient::OnJobOutputFinished(const TSharedPtr<FComfyUIJob>& Job)
+{
+    Job->PendingDownloads--;
+    if (Job->PendingDownloads <= 0)
+    {
+        FinishJob(Job);
+    }
+}
+
+void UComfyUIClient::AddJobOutput(const TSharedPtr<FComfyUIJob>& Job, FComfyUIOutputItem&& Item)
+{
+    // 结果交付前资产只被任务持有，需要防止被垃圾回收
+    if (Item.ProcessedAsset)
+    {
+        RetainedOutputAssets.Add(Item.ProcessedAsset);
+    }
+    Job->Result.Outputs.Add(MoveTemp(Item));
+}
+
+void UComfyUIClient::FinishJob(const TSharedPtr<FComfyUIJob>& Job)
+{
+    const bool bWasFinished = Job->bIsFinished;
+    Job->bIsFinished = true;
+    StopJobPolling(Job);
+    StopJobRetry(Job);
+    
+    // 交付完整结果：输出按节点和索引排序，与下载完成的先后无关
+    if (!bWasFinished && !Job->bIsCancelled && (Job->OnWorkflowCompleted.IsBound() || !Job->ResultCacheKey.IsEmpty()))
+    {
+        FComfyUIWorkflowResult& Result = Job->Result;
+        Result.PromptId = Job->PromptId;
+        Result.bSuccess = Job->bOutputsReceived && Job->PendingDownloads <= 0;
+        Result.Status = Result.bSuccess ? EComfyUIExecutionStatus::Completed : EComfyUIExecutionStatus::Failed;
+        Result.ErrorMessage = Result.bSuccess ? FString() : Job->LastError.ErrorMessage;
+        if (Job->ExecutionStartTime > 0.0)
+        {
+            Result.ExecutionTime = (float)(FPlatformTime::Seconds() - Job->ExecutionStartTime);
+        }
+        Result.Outputs.Sort([](const FComfyUIOutputItem& A, const FComfyUIOutputItem& B)
+        {
+            return A.NodeId != B.NodeId ? A.NodeId < B.NodeId : A.OutputIndex < B.OutputIndex;
+        });
+        
+        if (Result.bSuccess && !Job->ResultCacheKey.IsEmpty())
+        {
+            GetResultCache().Store(Job->ResultCacheKey, Result);
+        }
+        
+        FOnComfyUIWorkflowCompleted Delegate = Job->OnWorkflowCompleted;
+        Job->OnWorkflowCompleted.Unbind();
+        Delegate.ExecuteIfBound(Result);
+    }
+    
+    for (const FComfyUIOutputItem& Item : Job->Result.Outputs)
+    {
+        if (Item.ProcessedAsset)
+        {
+            RetainedOutputAssets.RemoveSingleSwap(Item.ProcessedAsset);
+        }
+    }
+    
+    // 中止任务尚未结束的状态查询和下载（例如失败或取消时其他输出仍在下载）
+    if (NetworkManager)
+    {
+        NetworkManager->CancelRequestGroup(Job->GetRequestGroup());
+    }
+    
+    SubmittingJobs.Remove(Job);
+    if (!Job->PromptId.IsEmpty())
+    {
+        const TSharedPtr<FComfyUIJob>* Found = Jobs.Find(Job->PromptId);
+        if (Found && *Found == Job)
+        {
+            Jobs.Remove(Job->PromptId);
+        }
+    }
+}
+
+FComfyUIProgressInfo UComfyUIClient::MakeQueueProgress(int32 QueuePosition)
+{
+    FComfyUIProgressInfo ProgressInfo;
+    ProgressInfo.QueuePosition = QueuePosition;
+    
+    if (QueuePosition == 0)
+    {
+        ProgressInfo.bIsExecuting = true;
+        ProgressInfo.StatusMessage = TEXT("正在执行...");
+        ProgressInfo.ProgressPercentage = 0.5f; // 假设50%进度当正在执行时
+    }
+    else
+    {
+        ProgressInfo.bIsExecuting = false;
+        ProgressInfo.StatusMessage = FString::Printf(TEXT("队列等待中.. (位置: %d)"), QueuePosition);
+        ProgressInfo.ProgressPercentage = 0.0f;
+    }
+    return ProgressInfo;
+}
+
+void UComfyUIClient::RunStatusCycle(const FString& InServerUrl)
+{
+    EnsureNetworkManagerInitialized();
+    
+    int32 NumPolling = 0;
+    for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
+    {
+        const bool bIncluded = Pair.Value->bIsPolling || Pair.Value->bStatusCheckPending;
+        NumPolling += bIncluded && Pair.Value->ServerUrl == InServerUrl ? 1 : 0;
+    }
+    if (NumPolling == 0)
+    {
+        return;
+    }
+    
+    TSharedPtr<FComfyUIStatusEngine>& Engine = StatusEngines.FindOrAdd(InServerUrl);
+    if (!Engine.IsValid())
+    {
+        Engine = MakeShared<FComfyUIStatusEngine>(NetworkManager);
+    }
+    
+    // 上一轮尚未返回时由其完成回调安排下一轮，等待补查的任务由下一轮处理
+    if (Engine->IsCycleInFlight())
+    {
+        return;
+    }
+    
+    // 等待补查的任务从这一轮开始计入，之前发出的快照可能早于事件通道恢复
+    for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
+    {
+        if (Pair.Value->bStatusCheckPending && Pair.Value->ServerUrl == InServerUrl)
+        {
+            Pair.Value->bStatusCheckPending = false;
+            Pair.Value->bStatusCheckInCycle = true;
+        }
+    }
+    
+    // 历史窗口要覆盖所有轮询中的任务，并为其他客户端的提交留出余量
+    const int32 HistoryWindow = FMath::Max(MinHistoryWindow, NumPolling * 2);
+    UE_LOG(LogTemp, VeryVerbose, TEXT("Async poll: running batched status cycle for %s"), *InServerUrl);
+    Engine->RunCycle(InServerUrl, HistoryWindow,
+        FOnComfyUIStatusBatch::CreateUObject(this, &UComfyUIClient::OnStatusBatch, InServerUrl));
+}
+
+void UComfyUIClient::OnStatusBatch(const FComfyUIStatusBatch& Batch, bool bSuccess, FString BatchServerUrl)
+{
+    // 队列快照同时用于服务器池的负载统计
+    if (bSuccess)
+    {
+        GetServerPool().UpdateQueue(BatchServerUrl, Batch.Queue);
+    }
+    
+    TArray<TSharedPtr<FComfyUIJob>> PollingJobs;
+    bool bStatusCheckPending = false;
+    for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
+    {
+        if (Pair.Value->ServerUrl != BatchServerUrl)
+        {
+            continue;
+        }
+        if (Pair.Value->bIsPolling || Pair.Value->bStatusCheckInCycle)
+        {
+            Pair.Value->bStatusCheckInCycle = false;
+            PollingJobs.Add(Pair.Value);
+        }
+        bStatusCheckPending |= Pair.Value->bStatusCheckPending;
+    }
+    
+    int32 NumStragglers = 0;
+    for (const TSharedPtr<FComfyUIJob>& Job : PollingJobs)
+    {
+        if (!Job->IsActive() || Job->bOutputsReceived)
+        {
+            continue;
+        }
+        
+        if (!bSuccess)
+        {
+            // 重试时恢复原来的方式：轮询中的任务继续轮询，补查的任务重新等待一轮批量查询
+            const bool bWasPolling = Job->bIsPolling;
+            StopJobPolling(Job);
+            FComfyUIError Error(EComfyUIErrorType::ConnectionFailed, TEXT("无法获取生成状态"), 0, TEXT("检查网络连接"), true);
+            HandleRequestError(Job, Error, [this, Job, bWasPolling]()
+            {
+                if (bWasPolling)
+                {
+                    StartJobPolling(Job);
+                    return;
+                }
+                Job->bStatusCheckPending = true;
+                RunStatusCycle(Job->ServerUrl);
+            });
+            continue;
+        }
+        
+        // 仍在队列中：更新进度，位置不变时逐步放慢轮询
+        const int32 QueuePosition = Batch.Queue.GetPosition(Job->PromptId);
+        if (QueuePosition != INDEX_NONE)
+        {
+            Job->PollBackoffLevel = QueuePosition == Job->QueuePosition ? Job->PollBackoffLevel + 1 : 0;
+            if (QueuePosition == 0 && Job->ExecutionStartTime <= 0.0)
+            {
+                Job->ExecutionStartTime = FPlatformTime::Seconds();
+            }
+            Job->QueuePosition = QueuePosition;
+            Job->ResetRetryState();
+            Job->OnProgress.ExecuteIfBound(MakeQueueProgress(QueuePosition));
+            continue;
+        }
+        
+        // 已出队且在历史窗口内：处理输出
+        if (const FComfyUIHistoryEntry* HistoryEntry = Batch.FindHistoryEntry(Job->PromptId))
+        {
+            ProcessHistoryEntry(Job, *HistoryEntry);
+            continue;
+        }
+        
+        // 既不在队列也不在历史窗口内（窗口被其他提交挤出），单独补查
+        ++NumStragglers;
+        PollGenerationStatus(Job);
+    }
+    
+    if (NumStragglers > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Status cycle: %d prompts outside history window (%d), queried individually"),
+               NumStragglers, Batch.HistoryWindow);
+    }
+    
+    // 本轮进行中又有任务等待补查时立即再查一轮，否则按剩余任务的状态安排下一轮
+    if (bStatusCheckPending)
+    {
+        RunStatusCycle(BatchServerUrl);
+    }
+    ScheduleStatusCycle(BatchServerUrl);
+}
+
+void UComfyUIClient::RetryJob(const TSharedPtr<FComfyUIJob>& Job)
+{
+    if (!Job->PromptId.IsEmpty())
+    {
+        // 已拿到提示ID，继续查询状态
+        PollGenerationStatus(Job);
+    }
+    else
+    {
+        // 没有提示ID，说明提交失败了，用保存的请求重新提交
+        SubmitJob(Job);
+    }
+}
+
+void UComfyUIClient::ExecuteWorkflow(const FString& WorkflowJson, 
+                                   const FOnGenerationStarted& OnStarted,
+                                   const FOnGenerationProgress& OnProgress,
+                                   const FOnImageGenerated& OnImageGenerated,
+                                   const FOnMeshGenerated& OnMeshGenerated,
+                                   const FOnGenerationFailed& OnFailed,
+                                   const FOnGenerationCompleted& OnCompleted,
+                                   const FString& TargetServerUrl,
+                                   const FOnComfyUIWorkflowCompleted& OnWorkflowCompleted,
+                                   const FString& ResultCacheKey)
+{
+    // 每次执行创建独立任务，多个任务可以同时进行
+    TSharedPtr<FComfyUIJob> Job = MakeShared<FComfyUIJob>();
+    Job->OnStarted = OnStarted;
+    Job->OnProgress = OnProgress;
+    Job->OnImageGenerated = OnImageGenerated;
+    Job->OnMeshGenerated = OnMeshGenerated;
+    Job->OnFailed = OnFailed;
+    Job->OnCompleted = OnCompleted;
+    Job->OnWorkflowCompleted = OnWorkflowCompleted;
+    Job->ResultCacheKey = ResultCacheKey;
+    Job->RequestJson = InjectClientId(WorkflowJson);
+    Job->WorkflowKey = MakeWorkflowKey(WorkflowJson);
+    SubmittingJobs.Add(Job);
+    
+    // 相同请求已有缓存的结果时在工作线程加载，不经过服务器；加载失败时再提交到服务器
+    if (!Job->ResultCacheKey.IsEmpty() && CompleteJobFromResultCache(Job, TargetServerUrl))
+    {
+        return;
+    }
+    
+    StartJobOnServer(Job, TargetServerUrl);
+}
+
+void UComfyUIClient::StartJobOnServer(const TSharedPtr<FComfyUIJob>& Job, const FString& TargetServerUrl)
+{
+    // 确保NetworkManager已初始化
+    EnsureNetworkManagerInitialized();
+    
+    // 任务固定在一台服务器上：调用方已上传输入时沿用其服务器，否则从服务器池中选择
+    Job->ServerUrl = FComfyUIServerPool::NormalizeUrl(TargetServerUrl.IsEmpty() ? SelectServer() : TargetServerUrl);
+    
+    // 确保事件通道已连接（未连接时会回退到轮询）
+    EnsureEventChannel(Job->ServerUrl);
+    
+    // 触发开始回调
+    if (Job->OnStarted.IsBound())
+    {
+        Job->OnStarted.ExecuteIfBound(TEXT("workflow_execution_started"));
     }
+    
+    SubmitJob(Job);
 }
 
-void UComfyUIClient::CancelCurrentGeneration()
+void UComfyUIClient::UploadImage(TArray<uint8> ImageData, const FString& FileName, 
+                                TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback,
+                                const FString& TargetServerUrl)
 {
-    bIsCancelled = true;
-    
-    // 停止异步轮询和重试
-    StopAsyncPolling();
-    StopAsyncRetry();
+    // 确保NetworkManager已初始化
+    EnsureNetworkManagerInitialized();
     
-    // 取消当前HTTP请求
-    if (CurrentRequest.IsValid())
-    {
-        CurrentRequest->CancelRequest();
-        CurrentRequest.Reset();
-    }
+    // 数据只保存一份，由哈希和上传共用；上传最多发起一次，发起时移交给请求体
+    TSharedRef<TArray<uint8>> Data = MakeShared<TArray<uint8>>(MoveTemp(ImageData));
     
-    // 重置状态
-    CurrentPromptId.Empty();
-    ResetRetryState();
+    // 相同内容已上传过时复用服务器上的文件
+    const FString ContentHash = FComfyUIUploadCache::HashData(*Data);
+    const FString UploadServerUrl = TargetServerUrl.IsEmpty() ? ServerUrl : TargetServerUrl;
+    UploadWithCache(UploadServerUrl, ContentHash, Data->Num(),
+        [this, UploadServerUrl, Data, FileName](TFunction<void(const FString&, bool)> OnUploaded)
+        {
+            NetworkManager->UploadImage(UploadServerUrl, MoveTemp(*Data), FileName, OnUploaded);
+        },
+        Callback);
+}
+
+void UComfyUIClient::UploadModel(TArray<uint8> ModelData, const FString& FileName, 
+                                TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback,
+                                const FString& TargetServerUrl)
+{
+    // 确保NetworkManager已初始化
+    EnsureNetworkManagerInitialized();
     
-    // 通知UI生成已完成（被取消），以便重新启用按钮
-    OnGenerationCompletedCallback.ExecuteIfBound();
+    // 数据只保存一份，由哈希和上传共用；上传最多发起一次，发起时移交给请求体
+    TSharedRef<TArray<uint8>> Data = MakeShared<TArray<uint8>>(MoveTemp(ModelData));
     
-    UE_LOG(LogTemp, Log, TEXT("Generation cancelled"));
+    // 相同内容已上传过时复用服务器上的文件
+    const FString ContentHash = FComfyUIUploadCache::HashData(*Data);
+    const FString UploadServerUrl = TargetServerUrl.IsEmpty() ? ServerUrl : TargetServerUrl;
+    UploadWithCache(UploadServerUrl, ContentHash, Data->Num(),
+        [this, UploadServerUrl, Data, FileName](TFunction<void(const FString&, bool)> OnUploaded)
+        {
+            NetworkManager->UploadModel(UploadServerUrl, MoveTemp(*Data), FileName, OnUploaded);
+        },
+        Callback);
 }
 
-FComfyUIProgressInfo UComfyUIClient::ParseQueueStatus(const FString& ResponseContent)
+void UComfyUIClient::UploadModelFile(const FString& FilePath, const FString& FileName, 
+                                    TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback,
+                                    const FString& TargetServerUrl)
 {
-    FComfyUIProgressInfo ProgressInfo;
+    // 确保NetworkManager已初始化
+    EnsureNetworkManagerInitialized();
     
-    // 检查是否被取消
-    if (bIsCancelled)
+    // 文件哈希按 (路径, 大小, 修改时间) 缓存，未修改的文件不会重新读取
+    const FString ContentHash = GetUploadCache().HashFile(FilePath);
+    const FString UploadServerUrl = TargetServerUrl.IsEmpty() ? ServerUrl : TargetServerUrl;
+    UploadWithCache(UploadServerUrl, ContentHash, IFileManager::Get().FileSize(*FilePath),
+        [this, UploadServerUrl, FilePath, FileName](TFunction<void(const FString&, bool)> OnUploaded)
+        {
+            // 使用NetworkManager从磁盘流式上传3D模型
+            NetworkManager->UploadModelFile(UploadServerUrl, FilePath, FileName, OnUploaded);
+        },
+        Callback);
+}
+
+FComfyUIUploadCache& UComfyUIClient::GetUploadCache()
+{
+    if (!UploadCache.IsValid())
     {
-        ProgressInfo.StatusMessage = TEXT("已取消");
-        return ProgressInfo;
+        UploadCache = MakeShared<FComfyUIUploadCache>(UComfyUIFileManager::GetCacheDirectory() / TEXT("UploadCache.json"));
+        UploadCache->Load();
     }
-    
-    TSharedPtr<FJsonObject> JsonObject;
-    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
-    if (!FJsonSerializer::Deserialize(Reader, JsonObject))
+    return *UploadCache;
+}
+
+FString UComfyUIClient::HashInputFile(const FString& FilePath)
+{
+    return GetUploadCache().HashFile(FilePath);
+}
+
+FComfyUIResultCache& UComfyUIClient::GetResultCache()
+{
+    if (!ResultCache.IsValid())
     {
-        ProgressInfo.StatusMessage = TEXT("解析状态响应失败");
-        return ProgressInfo;
+        ResultCache = MakeShared<FComfyUIResultCache>(UComfyUIFileManager::GetCacheDirectory() / TEXT("ResultCache"));
+        ResultCache->Load();
     }
+    return *ResultCache;
+}
 
-    // 检查是否在队列中运行
-    if (JsonObject->HasField(TEXT("queue_running")))
+bool UComfyUIClient::HasCachedResult(const FString& ResultCacheKey)
+{
+    return !ResultCacheKey.IsEmpty() && GetResultCache().Find(ResultCacheKey) != nullptr;
+}
+
+bool UComfyUIClient::CompleteJobFromResultCache(const TSharedPtr<FComfyUIJob>& Job, const FString& TargetServerUrl)
+{
+    const FComfyUIResultCacheEntry* Entry = GetResultCache().Find(Job->ResultCacheKey);
+    if (!Entry)
+    {
+        return false;
+    }
+    
+    // 读取文件和解码图像在工作线程进行，与下载的结果一样；纹理和网格只能在游戏线程创建
+    struct FCachedOutput
+    {
+        FComfyUIOutputItem Item;
+        FString CachedPath;
+        TArray<uint8> BGRA;
+        int32 Width = 0;
+        int32 Height = 0;
+    };
+    struct FLoadState
     {
-        const TArray<TSharedPtr<FJsonValue>>* QueueRunningArray;
-        if (JsonObject->TryGetArrayField(TEXT("queue_running"), QueueRunningArray))
+        TArray<FCachedOutput> Outputs;
+        bool bLoaded = true;
+    };
+    TSharedRef<FLoadState> State = MakeShared<FLoadState>();
+    for (const FComfyUIResultCacheOutput& Output : Entry->Outputs)
+    {
+        FCachedOutput& Cached = State->Outputs.AddDefaulted_GetRef();
+        Cached.Item.Type = Output.Type;
+        Cached.Item.NodeId = Output.NodeId;
+        Cached.Item.OutputIndex = Output.OutputIndex;
+        Cached.Item.FileName = Output.FileName;
+        Cached.Item.Text = Output.Text;
+        if (!Output.CachedFile.IsEmpty())
+        {
+            Cached.CachedPath = GetResultCache().GetCachedFilePath(Job->ResultCacheKey, Output);
+        }
+    }
+    
+    // 模块加载不是线程安全的，先在游戏线程确保已加载
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+    
+    TWeakObjectPtr<UComfyUIClient> WeakThis(this);
+    TSharedPtr<FComfyUIJob> JobPtr = Job;
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [State]()
         {
-            for (int32 i = 0; i < QueueRunningArray->Num(); ++i)
+            // 先加载全部输出，任何一个无法加载时按未命中处理，回调不会只收到部分结果
+            for (FCachedOutput& Cached : State->Outputs)
             {
-                TSharedPtr<FJsonObject> QueueItem = (*QueueRunningArray)[i]->AsObject();
-                if (QueueItem.IsValid() && QueueItem->HasField(TEXT("1")))
+                if (Cached.CachedPath.IsEmpty())
+                {
+                    // 图像和网格必须有缓存文件
+                    State->bLoaded = Cached.Item.Type != EComfyUINodeOutputType::Image && Cached.Item.Type != EComfyUINodeOutputType::Mesh;
+                }
+                else if (Cached.Item.Type == EComfyUINodeOutputType::Mesh)
                 {
-                    FString QueuePromptId = QueueItem->GetStringField(TEXT("1"));
-                    if (QueuePromptId == CurrentPromptId)
+                    // 网格由导入器按路径读取
+                    Cached.Item.LocalFilePath = Cached.CachedPath;
+                    State->bLoaded = IFileManager::Get().FileExists(*Cached.CachedPath);
+                }
+                else if (FFileHelper::LoadFileToArray(Cached.Item.RawData, *Cached.CachedPath))
+                {
+                    if (Cached.Item.Type == EComfyUINodeOutputType::Image)
                     {
-                        ProgressInfo.QueuePosition = 0; // 正在执行
-                        ProgressInfo.bIsExecuting = true;
-                        ProgressInfo.StatusMessage = TEXT("正在执行...");
-                        ProgressInfo.ProgressPercentage = 0.5f; // 假设50%进度当正在执行时
-                        return ProgressInfo;
+                        State->bLoaded = UComfyUIFileManager::DecodeImageData(Cached.Item.RawData, Cached.BGRA, Cached.Width, Cached.Height);
                     }
                 }
+                else
+                {
+                    State->bLoaded = Cached.Item.Type != EComfyUINodeOutputType::Image;
+                }
+                
+                if (!State->bLoaded)
+                {
+                    break;
+                }
             }
-        }
-    }
-
-    // 检查是否在等待队列中
-    if (JsonObject->HasField(TEXT("queue_pending")))
-    {
-        const TArray<TSharedPtr<FJsonValue>>* QueuePendingArray;
-        if (JsonObject->TryGetArrayField(TEXT("queue_pending"), QueuePendingArray))
+        },
+        [WeakThis, JobPtr, State, TargetServerUrl]()
         {
-            for (int32 i = 0; i < QueuePendingArray->Num(); ++i)
+            UComfyUIClient* Client = WeakThis.Get();
+            if (!Client || !JobPtr->IsActive())
+            {
+                return;
+            }
+            
+            for (int32 Index = 0; Index < State->Outputs.Num() && State->bLoaded; ++Index)
             {
-                TSharedPtr<FJsonObject> QueueItem = (*QueuePendingArray)[i]->AsObject();
-                if (QueueItem.IsValid() && QueueItem->HasField(TEXT("1")))
+                FCachedOutput& Cached = State->Outputs[Index];
+                if (Cached.Item.Type == EComfyUINodeOutputType::Image && !Cached.CachedPath.IsEmpty())
                 {
-                    FString QueuePromptId = QueueItem->GetStringField(TEXT("1"));
-                    if (QueuePromptId == CurrentPromptId)
-                    {
-                        ProgressInfo.QueuePosition = i + 1; // 队列位置从1开始
-                        ProgressInfo.bIsExecuting = false;
-                        ProgressInfo.StatusMessage = FString::Printf(TEXT("队列等待中.. (位置: %d)"), ProgressInfo.QueuePosition);
-                        ProgressInfo.ProgressPercentage = 0.0f;
-                        return ProgressInfo;
-                    }
+                    Cached.Item.ProcessedAsset = UComfyUIFileManager::CreateTextureFromBGRA(Cached.BGRA, Cached.Width, Cached.Height);
+                    Cached.BGRA.Empty();
                 }
+                else if (Cached.Item.Type == EComfyUINodeOutputType::Mesh && !Cached.CachedPath.IsEmpty())
+                {
+                    Cached.Item.ProcessedAsset = UComfyUI3DAssetManager::CreateStaticMeshFromFile(Cached.CachedPath, FPaths::GetExtension(Cached.Item.FileName).ToLower());
+                }
+                else
+                {
+                    continue;
+                }
+                State->bLoaded = Cached.Item.ProcessedAsset != nullptr;
             }
-        }
-    }
-
-    // 如果都没找到，可能已经完成或出错
-    ProgressInfo.StatusMessage = TEXT("检查完成状态..");
-    ProgressInfo.ProgressPercentage = 0.8f;
-    return ProgressInfo;
+            
+            const FString Key = JobPtr->ResultCacheKey;
+            if (!State->bLoaded)
+            {
+                // 按未命中处理，任务仍在提交中，结果保存后重新写入缓存
+                UE_LOG(LogTemp, Warning, TEXT("Result cache entry %s could not be loaded, executing on server"), *Key);
+                Client->GetResultCache().Remove(Key);
+                Client->GetResultCache().Save();
+                Client->StartJobOnServer(JobPtr, TargetServerUrl);
+                return;
+            }
+            
+            UE_LOG(LogTemp, Log, TEXT("Result cache hit: %s (%d outputs)"), *Key, State->Outputs.Num());
+            
+            // 缓存的结果不需要再保存；输出先登记到任务上，交付前不会被回收
+            JobPtr->ResultCacheKey.Empty();
+            JobPtr->bOutputsReceived = true;
+            for (FCachedOutput& Cached : State->Outputs)
+            {
+                Client->AddJobOutput(JobPtr, MoveTemp(Cached.Item));
+            }
+            
+            JobPtr->OnStarted.ExecuteIfBound(TEXT("result_cache"));
+            JobPtr->OnCompleted.ExecuteIfBound();
+            
+            // 回调中可能取消任务，每个输出交付前重新检查
+            for (int32 Index = 0; Index < JobPtr->Result.Outputs.Num() && JobPtr->IsActive(); ++Index)
+            {
+                const FComfyUIOutputItem& Item = JobPtr->Result.Outputs[Index];
+                if (Item.Type == EComfyUINodeOutputType::Image)
+                {
+                    JobPtr->OnImageGenerated.ExecuteIfBound(Cast<UTexture2D>(Item.ProcessedAsset));
+                }
+                else if (Item.Type == EComfyUINodeOutputType::Mesh)
+                {
+                    JobPtr->OnMeshGenerated.ExecuteIfBound(Cast<UStaticMesh>(Item.ProcessedAsset), Item.LocalFilePath,
+                                                           FPaths::GetExtension(Item.FileName).ToLower());
+                }
+            }
+            
+            if (WeakThis.IsValid() && JobPtr->IsActive())
+            {
+                Client->FinishJob(JobPtr);
+            }
+        });
+    return true;
 }
-void UComfyUIClient::RetryCurrentOperation()
+
+void UComfyUIClient::UploadWithCache(const FString& TargetServerUrl, const FString& ContentHash, int64 Size,
+                                     TFunction<void(TFunction<void(const FString& UploadedName, bool bSuccess)>)> DoUpload,
+                                     TFunction<void(const FString& UploadedName, bool bSuccess)> Callback)
 {
-    // 重新提交当前的提示请求
-    // 注意：这是一个简化的重试实现，应该根据实际的操作类型来决定重试逻辑
-    if (!CurrentPromptId.IsEmpty())
+    // 上传成功后记录到缓存（记录按上传的目标服务器）
+    const FString UploadServerUrl = TargetServerUrl;
+    TFunction<void(const FString&, bool)> OnUploaded = [this, ContentHash, Size, UploadServerUrl, Callback](const FString& UploadedName, bool bSuccess)
     {
-        // 如果有当前的提示ID，继续轮询状态
-        PollGenerationStatus(CurrentPromptId);
-    }
-    else
+        if (bSuccess && !UploadedName.IsEmpty())
+        {
+            GetUploadCache().Add(UploadServerUrl, ContentHash, UploadedName, Size);
+            GetUploadCache().Save();
+        }
+        Callback(UploadedName, bSuccess);
+    };
+    
+    FComfyUIUploadCacheEntry* Cached = GetUploadCache().Find(UploadServerUrl, ContentHash);
+    if (!Cached)
     {
-        // 如果没有提示ID，说明可能是提交提示失败了
-        // 这里应该重新提交提示，但需要更多上下文信息
-        // 暂时记录错误并调用失败回调
-        UE_LOG(LogTemp, Warning, TEXT("RetryCurrentOperation called but no operation context available"));
-        
-        FComfyUIError Error;
-        Error.ErrorType = EComfyUIErrorType::UnknownError;
-        Error.ErrorMessage = TEXT("No operation context for retry");
-        
-        OnGenerationFailedCallback.ExecuteIfBound(Error, false);
+        DoUpload(OnUploaded);
+        return;
     }
-}
-
-void UComfyUIClient::ExecuteWorkflow(const FString& WorkflowJson, 
-                                   const FOnGenerationStarted& OnStarted,
-                                   const FOnGenerationProgress& OnProgress,
-                                   const FOnImageGenerated& OnImageGenerated,
-                                   const FOnMeshGenerated& OnMeshGenerated,
-                                   const FOnGenerationFailed& OnFailed,
-                                   const FOnGenerationCompleted& OnCompleted)
-{
-    // 设置回调
-    OnGenerationStartedCallback = OnStarted;
-    OnGenerationProgressCallback = OnProgress;
-    OnImageGeneratedCallback = OnImageGenerated;
-    OnMeshGeneratedCallback = OnMeshGenerated;
-    OnGenerationFailedCallback = OnFailed;
-    OnGenerationCompletedCallback = OnCompleted;
-    
-    // 重置状态
-    ResetRetryState();
-    bIsCancelled = false;
     
-    // 确保NetworkManager已初始化
-    EnsureNetworkManagerInitialized();
+    const FString CachedName = Cached->UploadedName;
     
-    // 触发开始回调
-    if (OnGenerationStartedCallback.IsBound())
+    // 刚确认过存在的记录直接复用
+    if (Cached->LastVerifiedTime >= 0.0 && FPlatformTime::Seconds() - Cached->LastVerifiedTime < FComfyUIUploadCache::VerifyIntervalSeconds)
     {
-        OnGenerationStartedCallback.ExecuteIfBound(TEXT("workflow_execution_started"));
+        UE_LOG(LogTemp, Log, TEXT("Upload cache hit: %s (%lld bytes skipped)"), *CachedName, Size);
+        Callback(CachedName, true);
+        return;
     }
     
-    // 发送工作流JSON到ComfyUI服务器
-    FString PromptEndpoint = ServerUrl + TEXT("/prompt");
-    NetworkManager->SendRequest(PromptEndpoint, WorkflowJson, [this](const FString& Response, bool bSuccess) {
-        if (!bIsCancelled)
+    // 服务器的 input 目录可能已被清理，复用前确认文件仍然存在
+    NetworkManager->CheckInputExists(UploadServerUrl, CachedName,
+        [this, ContentHash, Size, UploadServerUrl, CachedName, DoUpload, OnUploaded, Callback](bool bExists)
         {
-            OnPromptResponse(Response, bSuccess);
-        }
-    });
-}
-
-void UComfyUIClient::UploadImage(const TArray<uint8>& ImageData, const FString& FileName, 
-                                TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback)
-{
-    // 确保NetworkManager已初始化
-    EnsureNetworkManagerInitialized();
-    
-    // 使用NetworkManager上传图像
-    NetworkManager->UploadImage(ServerUrl, ImageData, FileName, Callback);
-}
-
-void UComfyUIClient::UploadModel(const TArray<uint8>& ModelData, const FString& FileName, 
-                                TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback)
-{
-    // 确保NetworkManager已初始化
-    EnsureNetworkManagerInitialized();
-    
-    // 使用NetworkManager上传3D模型
-    NetworkManager->UploadModel(ServerUrl, ModelData, FileName, Callback);
+            if (bExists)
+            {
+                if (FComfyUIUploadCacheEntry* Entry = GetUploadCache().Find(UploadServerUrl, ContentHash))
+                {
+                    Entry->LastVerifiedTime = FPlatformTime::Seconds();
+                }
+                UE_LOG(LogTemp, Log, TEXT("Upload cache hit: %s (%lld bytes skipped)"), *CachedName, Size);
+                Callback(CachedName, true);
+                return;
+            }
+            
+            UE_LOG(LogTemp, Log, TEXT("Upload cache entry no longer on server, re-uploading: %s"), *CachedName);
+            GetUploadCache().Remove(UploadServerUrl, ContentHash);
+            DoUpload(OnUploaded);
+        });
 }
 
 void UComfyUIClient::DownloadModel(const FString& Url, 
-                                  TFunction<void(const TArray<uint8>& ModelData, bool bSuccess)> Callback)
+                                  TFunction<void(const FComfyUIHttpPayload& ModelData, bool bSuccess)> Callback)
 {
     // 确保NetworkManager已初始化
     EnsureNetworkManagerInitialized();
@@ -697,17 +1839,17 @@ void UComfyUIClient::DownloadModel(const FString& Url,
     NetworkManager->DownloadModel(Url, Callback);
 }
 
-void UComfyUIClient::DownloadGenerated3DModel(const FString& Filename, const FString& Subfolder)
+void UComfyUIClient::DownloadGenerated3DModel(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output)
 {
     // 构建3D模型下载URL
-    FString ModelUrl = ServerUrl + TEXT("/view");
+    FString ModelUrl = Job->ServerUrl + TEXT("/view");
     
     // 添加查询参数
     TArray<FString> QueryParams;
-    QueryParams.Add(FString::Printf(TEXT("filename=%s"), *Filename));
-    if (!Subfolder.IsEmpty())
+    QueryParams.Add(FString::Printf(TEXT("filename=%s"), *Output.Filename));
+    if (!Output.Subfolder.IsEmpty())
     {
-        QueryParams.Add(FString::Printf(TEXT("subfolder=%s"), *Subfolder));
+        QueryParams.Add(FString::Printf(TEXT("subfolder=%s"), *Output.Subfolder));
     }
     QueryParams.Add(TEXT("type=output"));
     
@@ -722,9 +1864,35 @@ void UComfyUIClient::DownloadGenerated3DModel(const FString& Filename, const FSt
     EnsureNetworkManagerInitialized();
     if (NetworkManager)
     {
-        NetworkManager->DownloadModel(ModelUrl, [this, Filename](const TArray<uint8>& ModelData, bool bSuccess) {
-            On3DModelDownloaded(ModelData, bSuccess, Filename);
-        });
+        TFunction<void()> RetryDownload = [this, Job, Output]()
+        {
+            DownloadGenerated3DModel(Job, Output);
+        };
+        // 模型直接写入下载目录，按 prompt_id 分目录避免同名输出互相覆盖
+        const FString DestFilePath = UComfyUIFileManager::GetDownloadsDirectory() / Job->PromptId / FPaths::GetCleanFilename(Output.Filename);
+        
+        TFunction<void(int64, int64)> OnBytesReceived = [Job](int64 BytesReceived, int64 BytesTotal)
+        {
+            if (!Job->IsActive())
+            {
+                return;
+            }
+            FComfyUIProgressInfo ProgressInfo;
+            ProgressInfo.StatusMessage = TEXT("正在下载3D模型...");
+            ProgressInfo.BytesReceived = BytesReceived;
+            ProgressInfo.BytesTotal = BytesTotal;
+            if (BytesTotal > 0)
+            {
+                ProgressInfo.ProgressPercentage = (float)((double)BytesReceived / (double)BytesTotal);
+            }
+            Job->OnProgress.ExecuteIfBound(ProgressInfo);
+        };
+        
+        FComfyUIRequestGroupScope RequestGroup(NetworkManager, Job->GetRequestGroup());
+        NetworkManager->DownloadToFile(ModelUrl, DestFilePath, OnBytesReceived,
+            [this, Job, Output, RetryDownload](const FString& FilePath, bool bSuccess) {
+                On3DModelDownloaded(Job, Output, FilePath, bSuccess, RetryDownload);
+            });
     }
     else
     {
@@ -732,43 +1900,55 @@ void UComfyUIClient::DownloadGenerated3DModel(const FString& Filename, const FSt
                                  TEXT("NetworkManager未初始化"), 
                                  0,
                                  TEXT("请检查插件初始化流程"), false);
-        HandleRequestError(NetworkError, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, NetworkError, [this, Job]() { RetryJob(Job); });
     }
 }
 
-void UComfyUIClient::On3DModelDownloaded(const TArray<uint8>& ModelData, bool bWasSuccessful, const FString& Filename)
+void UComfyUIClient::On3DModelDownloaded(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output, const FString& FilePath, bool bWasSuccessful, TFunction<void()> RetryDownload)
 {
-    if (!bWasSuccessful || ModelData.Num() == 0)
+    if (!Job->IsActive())
+    {
+        return;
+    }
+    
+    if (!bWasSuccessful)
     {
         FComfyUIError DownloadError(EComfyUIErrorType::ServerError, 
                                   TEXT("无法下载3D模型文件"), 
                                   0,
                                   TEXT("检查网络连接和文件权限"), true);
-        HandleRequestError(DownloadError, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, DownloadError, RetryDownload, &Output);
         return;
     }
     
-    UE_LOG(LogTemp, Log, TEXT("Successfully downloaded 3D model: %d bytes"), ModelData.Num());
+    UE_LOG(LogTemp, Log, TEXT("Successfully downloaded 3D model: %s"), *FilePath);
     
     // 从文件名判断格式
-    FString FileExtension = FPaths::GetExtension(Filename).ToLower();
+    FString FileExtension = FPaths::GetExtension(Output.Filename).ToLower();
     
     // 使用3D资产管理器创建StaticMesh
     UComfyUI3DAssetManager* AssetManager = NewObject<UComfyUI3DAssetManager>();
-    UStaticMesh* GeneratedMesh = AssetManager->CreateStaticMeshFromData(ModelData, FileExtension);
+    UStaticMesh* GeneratedMesh = AssetManager->CreateStaticMeshFromFile(FilePath, FileExtension);
     
     if (GeneratedMesh)
     {
-        UE_LOG(LogTemp, Log, TEXT("Successfully created 3D mesh from downloaded data"));
+        UE_LOG(LogTemp, Log, TEXT("Successfully created 3D mesh from downloaded file"));
         
-        // 成功完成，重置重试状态
-        ResetRetryState();
+        FComfyUIOutputItem Item;
+        Item.Type = EComfyUINodeOutputType::Mesh;
+        Item.NodeId = Output.NodeId;
+        Item.OutputIndex = Output.OutputIndex;
+        Item.FileName = Output.Filename;
+        Item.LocalFilePath = FilePath;
+        Item.ProcessedAsset = GeneratedMesh;
+        AddJobOutput(Job, MoveTemp(Item));
         
-        // 通知生成完成
-        // OnGenerationCompletedCallback.ExecuteIfBound();
+        // 该输出成功完成，只清除它自己的重试状态
+        Job->OutputRetries.Remove(Output.GetKey());
         
         // 最后通知3D模型生成完成
-        OnMeshGeneratedCallback.ExecuteIfBound(GeneratedMesh, ModelData, FileExtension);
+        Job->OnMeshGenerated.ExecuteIfBound(GeneratedMesh, FilePath, FileExtension);
+        OnJobOutputFinished(Job);
     }
     else
     {
@@ -776,104 +1956,289 @@ void UComfyUIClient::On3DModelDownloaded(const TArray<uint8>& ModelData, bool bW
                               TEXT("无法从3D模型数据创建StaticMesh"), 
                               0,
                               TEXT("检查模型格式是否支持，或尝试重新生成"), true);
-        HandleRequestError(MeshError, [this]() { RetryCurrentOperation(); });
+        HandleRequestError(Job, MeshError, RetryDownload, &Output);
     }
 }
 
-// 异步轮询相关方法实现
-void UComfyUIClient::StartAsyncPolling()
+// ========== 任务计时器 ==========
+
+void UComfyUIClient::StartJobPolling(const TSharedPtr<FComfyUIJob>& Job)
 {
-    if (!bIsPolling)
+    if (!Job->bIsPolling)
     {
-        bIsPolling = true;
-        LastPollTime = FPlatformTime::Seconds();
-        
-        // 使用 FTSTicker 进行异步轮询
-        TickerHandle = FTSTicker::GetCoreTicker().AddTicker(
-            FTickerDelegate::CreateUObject(this, &UComfyUIClient::HandleAsyncPoll),
-            0.0f  // 每帧检查
-        );
+        Job->bIsPolling = true;
+        Job->PollBackoffLevel = 0;
+        ScheduleStatusCycle(Job->ServerUrl);
         
-        UE_LOG(LogTemp, VeryVerbose, TEXT("Started async polling"));
+        UE_LOG(LogTemp, VeryVerbose, TEXT("Started async polling for prompt %s"), *Job->PromptId);
     }
 }
 
-void UComfyUIClient::StopAsyncPolling()
+void UComfyUIClient::StopJobPolling(const TSharedPtr<FComfyUIJob>& Job)
 {
-    if (bIsPolling)
+    if (Job->bIsPolling)
     {
-        bIsPolling = false;
-        
-        if (TickerHandle.IsValid())
+        // 已安排的查询轮到时发现没有轮询中的任务会直接跳过
+        Job->bIsPolling = false;
+        UE_LOG(LogTemp, VeryVerbose, TEXT("Stopped async polling for prompt %s"), *Job->PromptId);
+    }
+}
+
+void UComfyUIClient::StartJobRetry(const TSharedPtr<FComfyUIJob>& Job, TFunction<void()> RetryFunction, float DelaySeconds, const FString& OutputKey)
+{
+    // 只替换同一个重试对象（任务本身或某个输出）的计时器，其他输出已安排的重试保持不变
+    uint64& RetryTimer = OutputKey.IsEmpty() ? Job->RetryTimer : Job->OutputRetries.FindOrAdd(OutputKey).RetryTimer;
+    if (RetryTimer != 0)
+    {
+        JobTimers.Cancel(RetryTimer);
+    }
+    
+    TWeakPtr<FComfyUIJob> WeakJob = Job;
+    RetryTimer = JobTimers.Schedule(FPlatformTime::Seconds(), DelaySeconds, [WeakJob, RetryFunction, OutputKey]()
+    {
+        TSharedPtr<FComfyUIJob> PinnedJob = WeakJob.Pin();
+        if (PinnedJob.IsValid() && PinnedJob->IsActive())
         {
-            FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
-            TickerHandle.Reset();
+            if (OutputKey.IsEmpty())
+            {
+                PinnedJob->RetryTimer = 0;
+            }
+            else if (FComfyUIOutputRetry* OutputRetry = PinnedJob->OutputRetries.Find(OutputKey))
+            {
+                OutputRetry->RetryTimer = 0;
+            }
+            UE_LOG(LogTemp, VeryVerbose, TEXT("Async retry: executing retry function"));
+            RetryFunction();
         }
-        
-        UE_LOG(LogTemp, VeryVerbose, TEXT("Stopped async polling"));
+    });
+    UpdateJobTicker();
+    
+    UE_LOG(LogTemp, VeryVerbose, TEXT("Started async retry with delay %.2f seconds"), DelaySeconds);
+}
+
+void UComfyUIClient::StopJobRetry(const TSharedPtr<FComfyUIJob>& Job)
+{
+    bool bCancelled = false;
+    if (Job->RetryTimer != 0)
+    {
+        JobTimers.Cancel(Job->RetryTimer);
+        Job->RetryTimer = 0;
+        bCancelled = true;
+    }
+    for (TPair<FString, FComfyUIOutputRetry>& OutputRetry : Job->OutputRetries)
+    {
+        if (OutputRetry.Value.RetryTimer != 0)
+        {
+            JobTimers.Cancel(OutputRetry.Value.RetryTimer);
+            OutputRetry.Value.RetryTimer = 0;
+            bCancelled = true;
+        }
+    }
+    if (bCancelled)
+    {
+        UpdateJobTicker();
     }
 }
 
-bool UComfyUIClient::HandleAsyncPoll(float DeltaTime)
+void UComfyUIClient::ScheduleStatusCycle(const FString& InServerUrl)
 {
-    if (!bIsPolling || bIsCancelled)
+    const double Now = FPlatformTime::Seconds();
+    
+    // 取该服务器上所有轮询中任务的最短期望间隔
+    float Delay = -1.0f;
+    for (const TPair<FString, TSharedPtr<FComfyUIJob>>& Pair : Jobs)
     {
-        return false; // 停止 ticker
+        const TSharedPtr<FComfyUIJob>& Job = Pair.Value;
+        if (Job->bIsPolling && Job->IsActive() && !Job->bOutputsReceived && Job->ServerUrl == InServerUrl)
+        {
+            const float JobDelay = ComputeJobPollDelay(*Job, Now);
+            Delay = Delay < 0.0f ? JobDelay : FMath::Min(Delay, JobDelay);
+        }
     }
     
-    float CurrentTime = FPlatformTime::Seconds();
-    if (CurrentTime - LastPollTime >= PollInterval)
+    FComfyUITimerWheel::FHandle* Existing = StatusCycleTimers.Find(InServerUrl);
+    if (Delay < 0.0f)
     {
-        LastPollTime = CurrentTime;
-        
-        // 执行轮询逻辑
-        UE_LOG(LogTemp, VeryVerbose, TEXT("Async poll: checking generation status"));
-        PollGenerationStatus();
+        if (Existing)
+        {
+            JobTimers.Cancel(*Existing);
+            StatusCycleTimers.Remove(InServerUrl);
+            UpdateJobTicker();
+        }
+        return;
+    }
+    
+    // 已安排的查询不晚于期望时间时保留，否则提前
+    if (Existing)
+    {
+        if (JobTimers.GetDeadline(*Existing) <= Now + Delay)
+        {
+            return;
+        }
+        JobTimers.Cancel(*Existing);
     }
     
-    return true; // 继续 ticker
+    // 查询进行中时由其完成回调安排下一轮
+    const TSharedPtr<FComfyUIStatusEngine>* Engine = StatusEngines.Find(InServerUrl);
+    if (Engine && Engine->IsValid() && (*Engine)->IsCycleInFlight())
+    {
+        StatusCycleTimers.Remove(InServerUrl);
+        UpdateJobTicker();
+        return;
+    }
+    
+    const FString CycleServerUrl = InServerUrl;
+    StatusCycleTimers.Add(InServerUrl, JobTimers.Schedule(Now, Delay, [this, CycleServerUrl]()
+    {
+        StatusCycleTimers.Remove(CycleServerUrl);
+        RunStatusCycle(CycleServerUrl);
+    }));
+    UpdateJobTicker();
+    
+    UE_LOG(LogTemp, VeryVerbose, TEXT("Next status cycle for %s in %.2f seconds"), *InServerUrl, Delay);
 }
 
-// 异步重试相关方法实现
-void UComfyUIClient::StartAsyncRetry(TFunction<void()> RetryFunction, float DelaySeconds)
+float UComfyUIClient::ComputeJobPollDelay(const FComfyUIJob& Job, double Now) const
 {
-    PendingRetryFunction = RetryFunction;
-    RetryStartTime = FPlatformTime::Seconds();
+    // 刚提交或状态未知：基础间隔
+    if (Job.QueuePosition == INDEX_NONE)
+    {
+        return PollInterval;
+    }
     
-    // 使用 FTSTicker 进行异步重试
-    RetryTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
-        FTickerDelegate::CreateUObject(this, &UComfyUIClient::HandleAsyncRetry),
-        0.0f  // 每帧检查
-    );
+    const float Backoff = FMath::Pow(2.0f, (float)FMath::Min(Job.PollBackoffLevel, 8));
     
-    UE_LOG(LogTemp, VeryVerbose, TEXT("Started async retry with delay %.2f seconds"), DelaySeconds);
+    if (Job.QueuePosition == 0)
+    {
+        // 执行中：有同类工作流的历史耗时时，离预计完成越近查询越频繁
+        const double* Estimate = ExecutionTimeEstimates.Find(Job.WorkflowKey);
+        const double Elapsed = Job.ExecutionStartTime > 0.0 ? Now - Job.ExecutionStartTime : 0.0;
+        if (Estimate && *Estimate > Elapsed)
+        {
+            return FMath::Clamp((float)((*Estimate - Elapsed) * 0.5), MinPollInterval, MaxPollInterval);
+        }
+        
+        // 没有估计或已超出估计：从较短的间隔开始退避
+        return FMath::Min(MinPollInterval * Backoff, MaxPollInterval);
+    }
+    
+    // 排队中：位置越靠后、位置越久不变，间隔越长
+    return FMath::Min(PollInterval * FMath::Min(Job.QueuePosition, 4) * Backoff, MaxPollInterval);
 }
 
-void UComfyUIClient::StopAsyncRetry()
+void UComfyUIClient::RecordExecutionTime(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry& PromptHistory)
 {
-    if (RetryTickerHandle.IsValid())
+    if (Job->WorkflowKey.IsEmpty())
+    {
+        return;
+    }
+    
+    // 优先使用服务器记录的执行开始/结束时间戳（毫秒），其次使用本地观察到的开始时间
+    const double StartTimestamp = PromptHistory.ExecutionStartTimestamp;
+    const double EndTimestamp = PromptHistory.ExecutionEndTimestamp;
+    
+    double Duration = 0.0;
+    if (StartTimestamp > 0.0 && EndTimestamp > StartTimestamp)
+    {
+        Duration = (EndTimestamp - StartTimestamp) / 1000.0;
+    }
+    else if (Job->ExecutionStartTime > 0.0)
+    {
+        Duration = FPlatformTime::Seconds() - Job->ExecutionStartTime;
+    }
+    
+    if (Duration <= 0.0)
+    {
+        return;
+    }
+    
+    double* Estimate = ExecutionTimeEstimates.Find(Job->WorkflowKey);
+    if (Estimate)
+    {
+        *Estimate = *Estimate * (1.0 - ExecutionEstimateWeight) + Duration * ExecutionEstimateWeight;
+    }
+    else
     {
-        FTSTicker::GetCoreTicker().RemoveTicker(RetryTickerHandle);
-        RetryTickerHandle.Reset();
-        PendingRetryFunction = nullptr;
+        Estimate = &ExecutionTimeEstimates.Add(Job->WorkflowKey, Duration);
     }
+    
+    UE_LOG(LogTemp, Verbose, TEXT("Execution took %.1fs, estimate for workflow %s is now %.1fs"),
+           Duration, *Job->WorkflowKey, *Estimate);
 }
 
-bool UComfyUIClient::HandleAsyncRetry(float DeltaTime)
+FString UComfyUIClient::MakeWorkflowKey(const FString& WorkflowJson)
 {
-    float CurrentTime = FPlatformTime::Seconds();
-    if (CurrentTime - RetryStartTime >= RetryDelaySeconds)
+    TSharedPtr<FJsonObject> RequestJson;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(WorkflowJson);
+    if (!FJsonSerializer::Deserialize(Reader, RequestJson) || !RequestJson.IsValid())
+    {
+        return FString();
+    }
+    
+    // 提交格式为 {"prompt": {节点}}，也接受直接的节点表
+    TSharedPtr<FJsonObject> Nodes = RequestJson;
+    const TSharedPtr<FJsonObject>* PromptObject = nullptr;
+    if (RequestJson->TryGetObjectField(TEXT("prompt"), PromptObject) && PromptObject && PromptObject->IsValid())
+    {
+        Nodes = *PromptObject;
+    }
+    
+    TArray<FString> ClassTypes;
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Nodes->Values)
     {
-        // 时间到了，执行重试
-        if (PendingRetryFunction)
+        const TSharedPtr<FJsonObject>* Node = nullptr;
+        FString ClassType;
+        if (Pair.Value.IsValid() && Pair.Value->TryGetObject(Node) && Node &&
+            (*Node)->TryGetStringField(TEXT("class_type"), ClassType))
         {
-            UE_LOG(LogTemp, VeryVerbose, TEXT("Async retry: executing retry function"));
-            PendingRetryFunction();
-            PendingRetryFunction = nullptr;
+            ClassTypes.Add(ClassType);
         }
-        
-        return false; // 停止 ticker
     }
+    if (ClassTypes.Num() == 0)
+    {
+        return FString();
+    }
+    
+    ClassTypes.Sort();
+    return FString::Printf(TEXT("%08x"), FCrc::StrCrc32(*FString::Join(ClassTypes, TEXT(","))));
+}
+
+void UComfyUIClient::UpdateJobTicker()
+{
+    // ticker 只在最早的计时器到期时触发，没有计时器时不注册
+    const double NextDeadline = JobTimers.GetNextDeadline();
+    if (JobTickerHandle.IsValid() && NextDeadline == JobTickerDeadline)
+    {
+        return;
+    }
+    
+    if (JobTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(JobTickerHandle);
+        JobTickerHandle.Reset();
+    }
+    
+    JobTickerDeadline = NextDeadline;
+    if (NextDeadline < 0.0)
+    {
+        return;
+    }
+    
+    const float Delay = (float)FMath::Max(NextDeadline - FPlatformTime::Seconds(), 0.0);
+    JobTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateUObject(this, &UComfyUIClient::HandleJobTimers),
+        Delay
+    );
+}
+
+bool UComfyUIClient::HandleJobTimers(float DeltaTime)
+{
+    // 每个 ticker 只触发一次，之后按下一个到期时间重新注册
+    JobTickerHandle.Reset();
+    JobTickerDeadline = -1.0;
+    
+    JobTimers.Advance(FPlatformTime::Seconds());
     
-    return true; // 继续等待
+    UpdateJobTicker();
+    return false;
 }
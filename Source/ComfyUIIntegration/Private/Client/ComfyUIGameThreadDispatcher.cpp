@@ -0,0 +1,76 @@
+#include "Client/ComfyUIGameThreadDispatcher.h"
+#include "Async/Async.h"
+
+TQueue<TFunction<void()>, EQueueMode::Mpsc> FComfyUIGameThreadDispatcher::Tasks;
+FTSTicker::FDelegateHandle FComfyUIGameThreadDispatcher::TickerHandle;
+std::atomic<bool> FComfyUIGameThreadDispatcher::bInitialized { false };
+double FComfyUIGameThreadDispatcher::FrameBudgetSeconds = 0.004;
+
+void FComfyUIGameThreadDispatcher::Initialize()
+{
+    check(IsInGameThread());
+    if (bInitialized)
+    {
+        return;
+    }
+
+    TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&FComfyUIGameThreadDispatcher::Drain));
+    bInitialized = true;
+}
+
+void FComfyUIGameThreadDispatcher::Shutdown()
+{
+    check(IsInGameThread());
+    if (!bInitialized)
+    {
+        return;
+    }
+
+    bInitialized = false;
+    FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    TickerHandle.Reset();
+
+    // 模块卸载后不再执行回调
+    TFunction<void()> Task;
+    while (Tasks.Dequeue(Task))
+    {
+    }
+}
+
+void FComfyUIGameThreadDispatcher::Enqueue(TFunction<void()> Task)
+{
+    if (!bInitialized)
+    {
+        AsyncTask(ENamedThreads::GameThread, MoveTemp(Task));
+        return;
+    }
+    Tasks.Enqueue(MoveTemp(Task));
+}
+
+void FComfyUIGameThreadDispatcher::RunAsync(TFunction<void()> Work, TFunction<void()> OnGameThread)
+{
+    Async(EAsyncExecution::TaskGraph, [Work = MoveTemp(Work), OnGameThread = MoveTemp(OnGameThread)]() mutable
+    {
+        Work();
+        Enqueue(MoveTemp(OnGameThread));
+    });
+}
+
+bool FComfyUIGameThreadDispatcher::Drain(float DeltaTime)
+{
+    const double StartTime = FPlatformTime::Seconds();
+
+    // 至少处理一个任务，避免预算过小时队列永远不前进
+    TFunction<void()> Task;
+    while (Tasks.Dequeue(Task))
+    {
+        Task();
+        Task = nullptr;
+
+        if (FPlatformTime::Seconds() - StartTime >= FrameBudgetSeconds)
+        {
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,342 @@
+#include "Client/ComfyUIResultCache.h"
+#include "Client/ComfyUIGameThreadDispatcher.h"
+#include "Utils/ComfyUIFileManager.h"
+#include "Hash/xxhash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+    /** 索引格式和键的版本，变化时旧的记录全部失效 */
+    constexpr int32 ResultCacheVersion = 1;
+
+    /** 等待写入的输出：图像的压缩数据或模型文件的本地路径 */
+    struct FPendingOutput
+    {
+        FComfyUIResultCacheOutput Output;
+        TArray<uint8> Data;
+        FString SourceFile;
+    };
+}
+
+FComfyUIResultCache::FComfyUIResultCache(const FString& InCacheDirectory)
+    : CacheDirectory(InCacheDirectory)
+    , IndexFilePath(InCacheDirectory / TEXT("Index.json"))
+{
+}
+
+FString FComfyUIResultCache::MakeKey(const FString& PromptJson)
+{
+    const FTCHARToUTF8 Utf8(*PromptJson);
+    FXxHash64Builder Builder;
+    Builder.Update(&ResultCacheVersion, sizeof(ResultCacheVersion));
+    Builder.Update(Utf8.Get(), Utf8.Length());
+    return FString::Printf(TEXT("%016llx"), Builder.Finalize().Hash);
+}
+
+FString FComfyUIResultCache::GetEntryDirectory(const FString& Key) const
+{
+    return CacheDirectory / Key;
+}
+
+FString FComfyUIResultCache::GetCachedFilePath(const FString& Key, const FComfyUIResultCacheOutput& Output) const
+{
+    return GetEntryDirectory(Key) / Output.CachedFile;
+}
+
+const FComfyUIResultCacheEntry* FComfyUIResultCache::Find(const FString& Key)
+{
+    FComfyUIResultCacheEntry* Entry = Key.IsEmpty() ? nullptr : Entries.Find(Key);
+    if (!Entry)
+    {
+        return nullptr;
+    }
+
+    for (const FComfyUIResultCacheOutput& Output : Entry->Outputs)
+    {
+        if (!Output.CachedFile.IsEmpty() && !FPaths::FileExists(GetCachedFilePath(Key, Output)))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("ResultCache: cached file missing for %s, dropping entry"), *Key);
+            Remove(Key);
+            Save();
+            return nullptr;
+        }
+    }
+
+    Entry->LastUsed = FDateTime::UtcNow();
+    return Entry;
+}
+
+void FComfyUIResultCache::Store(const FString& Key, const FComfyUIWorkflowResult& Result)
+{
+    // 已有记录或同一个键正在写入时不重复保存
+    if (Key.IsEmpty() || !Result.bSuccess || Result.Outputs.Num() == 0 || Entries.Contains(Key) || PendingKeys.Contains(Key))
+    {
+        return;
+    }
+
+    TSharedRef<TArray<FPendingOutput>> Pending = MakeShared<TArray<FPendingOutput>>();
+    Pending->Reserve(Result.Outputs.Num());
+    for (int32 Index = 0; Index < Result.Outputs.Num(); ++Index)
+    {
+        const FComfyUIOutputItem& Item = Result.Outputs[Index];
+        FPendingOutput& Output = Pending->AddDefaulted_GetRef();
+        Output.Output.Type = Item.Type;
+        Output.Output.NodeId = Item.NodeId;
+        Output.Output.OutputIndex = Item.OutputIndex;
+        Output.Output.FileName = Item.FileName;
+
+        if (Item.RawData.Num() > 0)
+        {
+            Output.Data = Item.RawData;
+        }
+        else if (!Item.LocalFilePath.IsEmpty())
+        {
+            Output.SourceFile = Item.LocalFilePath;
+        }
+        else if (Item.Type == EComfyUINodeOutputType::Text)
+        {
+            Output.Output.Text = Item.Text;
+            continue;
+        }
+        else
+        {
+            // 只有资产、没有数据的输出无法从缓存恢复，整个结果不缓存
+            return;
+        }
+
+        const FString CleanName = FPaths::GetCleanFilename(Item.FileName);
+        Output.Output.CachedFile = FString::Printf(TEXT("%d_%s"), Index, CleanName.IsEmpty() ? TEXT("output") : *CleanName);
+    }
+
+    PendingKeys.Add(Key);
+    const FString EntryDirectory = GetEntryDirectory(Key);
+    TSharedRef<FComfyUIResultCacheEntry> Entry = MakeShared<FComfyUIResultCacheEntry>();
+    TSharedRef<bool> bWritten = MakeShared<bool>(false);
+    TWeakPtr<FComfyUIResultCache> WeakThis = AsShared();
+
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [Pending, EntryDirectory, Entry, bWritten]()
+        {
+            IFileManager& FileManager = IFileManager::Get();
+            FileManager.DeleteDirectory(*EntryDirectory, false, true);
+            if (!FileManager.MakeDirectory(*EntryDirectory, true))
+            {
+                return;
+            }
+
+            for (FPendingOutput& Output : *Pending)
+            {
+                if (!Output.Output.CachedFile.IsEmpty())
+                {
+                    const FString CachedPath = EntryDirectory / Output.Output.CachedFile;
+                    const bool bSaved = Output.SourceFile.IsEmpty()
+                        ? FFileHelper::SaveArrayToFile(Output.Data, *CachedPath)
+                        : FileManager.Copy(*CachedPath, *Output.SourceFile) == COPY_OK;
+                    if (!bSaved)
+                    {
+                        FileManager.DeleteDirectory(*EntryDirectory, false, true);
+                        return;
+                    }
+                    Entry->Size += FileManager.FileSize(*CachedPath);
+                }
+                Entry->Outputs.Add(MoveTemp(Output.Output));
+            }
+            *bWritten = true;
+        },
+        [WeakThis, Key, Entry, bWritten]()
+        {
+            TSharedPtr<FComfyUIResultCache> Cache = WeakThis.Pin();
+            if (!Cache.IsValid())
+            {
+                return;
+            }
+
+            Cache->PendingKeys.Remove(Key);
+            if (*bWritten)
+            {
+                Cache->AddEntry(Key, MoveTemp(*Entry));
+            }
+            else
+            {
+                UE_LOG(LogTemp, Warning, TEXT("ResultCache: failed to write outputs for %s"), *Key);
+            }
+        });
+}
+
+void FComfyUIResultCache::AddEntry(const FString& Key, FComfyUIResultCacheEntry&& Entry)
+{
+    Entry.LastUsed = FDateTime::UtcNow();
+    TotalSize += Entry.Size;
+    UE_LOG(LogTemp, Log, TEXT("ResultCache: stored %s (%d outputs, %lld bytes)"), *Key, Entry.Outputs.Num(), Entry.Size);
+    Entries.Add(Key, MoveTemp(Entry));
+
+    Prune();
+    Save();
+}
+
+void FComfyUIResultCache::Remove(const FString& Key)
+{
+    FComfyUIResultCacheEntry Removed;
+    if (Entries.RemoveAndCopyValue(Key, Removed))
+    {
+        TotalSize -= Removed.Size;
+        IFileManager::Get().DeleteDirectory(*GetEntryDirectory(Key), false, true);
+    }
+}
+
+void FComfyUIResultCache::Prune()
+{
+    if (TotalSize <= MaxTotalSize)
+    {
+        return;
+    }
+
+    Entries.ValueSort([](const FComfyUIResultCacheEntry& A, const FComfyUIResultCacheEntry& B)
+    {
+        return A.LastUsed < B.LastUsed;
+    });
+
+    TArray<FString> Keys;
+    Entries.GetKeys(Keys);
+    for (const FString& Key : Keys)
+    {
+        if (TotalSize <= MaxTotalSize)
+        {
+            break;
+        }
+        Remove(Key);
+    }
+}
+
+void FComfyUIResultCache::Load()
+{
+    Entries.Reset();
+    TotalSize = 0;
+
+    FString JsonContent;
+    if (!FPaths::FileExists(IndexFilePath) || !FFileHelper::LoadFileToString(JsonContent, *IndexFilePath))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonContent);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ResultCache: failed to parse %s, starting empty"), *IndexFilePath);
+        return;
+    }
+
+    int32 Version = 0;
+    if (!Root->TryGetNumberField(TEXT("version"), Version) || Version != ResultCacheVersion)
+    {
+        return;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* EntryArray = nullptr;
+    if (Root->TryGetArrayField(TEXT("entries"), EntryArray) && EntryArray)
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *EntryArray)
+        {
+            const TSharedPtr<FJsonObject>* Object = nullptr;
+            FString Key, LastUsed;
+            // 目录已被删除的记录不再保留
+            if (!Value.IsValid() || !Value->TryGetObject(Object) || !Object ||
+                !(*Object)->TryGetStringField(TEXT("key"), Key) || !FPaths::DirectoryExists(GetEntryDirectory(Key)))
+            {
+                continue;
+            }
+
+            FComfyUIResultCacheEntry Entry;
+            (*Object)->TryGetNumberField(TEXT("size"), Entry.Size);
+            if ((*Object)->TryGetStringField(TEXT("last_used"), LastUsed))
+            {
+                FDateTime::ParseIso8601(*LastUsed, Entry.LastUsed);
+            }
+
+            const TArray<TSharedPtr<FJsonValue>>* OutputArray = nullptr;
+            if ((*Object)->TryGetArrayField(TEXT("outputs"), OutputArray) && OutputArray)
+            {
+                for (const TSharedPtr<FJsonValue>& OutputValue : *OutputArray)
+                {
+                    const TSharedPtr<FJsonObject>* OutputObject = nullptr;
+                    if (!OutputValue.IsValid() || !OutputValue->TryGetObject(OutputObject) || !OutputObject)
+                    {
+                        continue;
+                    }
+
+                    FComfyUIResultCacheOutput& Output = Entry.Outputs.AddDefaulted_GetRef();
+                    int32 Type = (int32)EComfyUINodeOutputType::Unknown;
+                    (*OutputObject)->TryGetNumberField(TEXT("type"), Type);
+                    Output.Type = (EComfyUINodeOutputType)Type;
+                    (*OutputObject)->TryGetStringField(TEXT("node"), Output.NodeId);
+                    (*OutputObject)->TryGetNumberField(TEXT("index"), Output.OutputIndex);
+                    (*OutputObject)->TryGetStringField(TEXT("file_name"), Output.FileName);
+                    (*OutputObject)->TryGetStringField(TEXT("cached_file"), Output.CachedFile);
+                    (*OutputObject)->TryGetStringField(TEXT("text"), Output.Text);
+                }
+            }
+
+            TotalSize += Entry.Size;
+            Entries.Add(Key, MoveTemp(Entry));
+        }
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("ResultCache: loaded %d entries (%lld bytes) from %s"), Entries.Num(), TotalSize, *IndexFilePath);
+}
+
+void FComfyUIResultCache::Save() const
+{
+    TSharedPtr<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetNumberField(TEXT("version"), ResultCacheVersion);
+
+    TArray<TSharedPtr<FJsonValue>> EntryArray;
+    for (const TPair<FString, FComfyUIResultCacheEntry>& Pair : Entries)
+    {
+        TArray<TSharedPtr<FJsonValue>> OutputArray;
+        for (const FComfyUIResultCacheOutput& Output : Pair.Value.Outputs)
+        {
+            TSharedPtr<FJsonObject> OutputObject = MakeShared<FJsonObject>();
+            OutputObject->SetNumberField(TEXT("type"), (int32)Output.Type);
+            OutputObject->SetStringField(TEXT("node"), Output.NodeId);
+            OutputObject->SetNumberField(TEXT("index"), Output.OutputIndex);
+            OutputObject->SetStringField(TEXT("file_name"), Output.FileName);
+            if (!Output.CachedFile.IsEmpty())
+            {
+                OutputObject->SetStringField(TEXT("cached_file"), Output.CachedFile);
+            }
+            if (!Output.Text.IsEmpty())
+            {
+                OutputObject->SetStringField(TEXT("text"), Output.Text);
+            }
+            OutputArray.Add(MakeShared<FJsonValueObject>(OutputObject));
+        }
+
+        TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetStringField(TEXT("key"), Pair.Key);
+        Object->SetNumberField(TEXT("size"), (double)Pair.Value.Size);
+        Object->SetStringField(TEXT("last_used"), Pair.Value.LastUsed.ToIso8601());
+        Object->SetArrayField(TEXT("outputs"), OutputArray);
+        EntryArray.Add(MakeShared<FJsonValueObject>(Object));
+    }
+    Root->SetArrayField(TEXT("entries"), EntryArray);
+
+    FString JsonContent;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonContent);
+    if (!FJsonSerializer::Serialize(Root.ToSharedRef(), Writer))
+    {
+        return;
+    }
+
+    UComfyUIFileManager::EnsureDirectoryExists(CacheDirectory);
+    if (!FFileHelper::SaveStringToFile(JsonContent, *IndexFilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ResultCache: failed to save %s"), *IndexFilePath);
+    }
+}
@@ -0,0 +1,111 @@
+#include "Client/ComfyUITimerWheel.h"
+
+FComfyUITimerWheel::FComfyUITimerWheel(double InResolution, int32 InNumSlots)
+    : Resolution(FMath::Max(InResolution, 0.001))
+{
+    Slots.SetNum(FMath::Max(InNumSlots, 1));
+}
+
+FComfyUITimerWheel::FHandle FComfyUITimerWheel::Schedule(double Now, double DelaySeconds, TFunction<void()> Callback)
+{
+    const double Deadline = Now + FMath::Max(DelaySeconds, 0.0);
+    if (CurrentTick == INDEX_NONE)
+    {
+        CurrentTick = ToTick(Now) - 1;
+    }
+
+    // 已经处理完的 tick 不会再访问，到期时间落在其中的计时器放到下一个 tick
+    const int64 Tick = FMath::Max(ToTick(Deadline), CurrentTick + 1);
+    const int32 Slot = ToSlot(Tick);
+
+    const FHandle Handle = NextHandle++;
+    FTimer& Timer = Slots[Slot].AddDefaulted_GetRef();
+    Timer.Handle = Handle;
+    Timer.Deadline = Deadline;
+    Timer.Callback = MoveTemp(Callback);
+
+    Locations.Add(Handle, { Slot, Deadline });
+    return Handle;
+}
+
+bool FComfyUITimerWheel::Cancel(FHandle Handle)
+{
+    FLocation Location;
+    if (!Locations.RemoveAndCopyValue(Handle, Location))
+    {
+        return false;
+    }
+
+    Slots[Location.Slot].RemoveAllSwap([Handle](const FTimer& Timer) { return Timer.Handle == Handle; });
+    return true;
+}
+
+double FComfyUITimerWheel::GetDeadline(FHandle Handle) const
+{
+    const FLocation* Location = Locations.Find(Handle);
+    return Location ? Location->Deadline : -1.0;
+}
+
+int32 FComfyUITimerWheel::Advance(double Now)
+{
+    const int64 NowTick = ToTick(Now);
+    if (CurrentTick == INDEX_NONE || Locations.Num() == 0)
+    {
+        CurrentTick = NowTick - 1;
+        return 0;
+    }
+
+    // 经过的 tick 超过一圈时每个槽只需访问一次
+    const int64 NumTicks = FMath::Min<int64>(NowTick - CurrentTick, Slots.Num());
+    if (NumTicks <= 0)
+    {
+        return 0;
+    }
+
+    // 先取出所有到期的计时器再触发，回调中修改轮不会影响本次遍历
+    TArray<FTimer> DueTimers;
+    for (int64 Offset = 1; Offset <= NumTicks; ++Offset)
+    {
+        TArray<FTimer>& Slot = Slots[ToSlot(CurrentTick + Offset)];
+        for (int32 Index = Slot.Num() - 1; Index >= 0; --Index)
+        {
+            if (Slot[Index].Deadline <= Now)
+            {
+                Locations.Remove(Slot[Index].Handle);
+                DueTimers.Add(MoveTemp(Slot[Index]));
+                Slot.RemoveAtSwap(Index);
+            }
+        }
+    }
+    // 当前 tick 中尚未到期的计时器下次还要检查
+    CurrentTick = NowTick - 1;
+
+    DueTimers.Sort([](const FTimer& A, const FTimer& B) { return A.Deadline < B.Deadline; });
+    for (FTimer& Timer : DueTimers)
+    {
+        Timer.Callback();
+    }
+    return DueTimers.Num();
+}
+
+double FComfyUITimerWheel::GetNextDeadline() const
+{
+    double Earliest = -1.0;
+    for (const TPair<FHandle, FLocation>& Pair : Locations)
+    {
+        if (Earliest < 0.0 || Pair.Value.Deadline < Earliest)
+        {
+            Earliest = Pair.Value.Deadline;
+        }
+    }
+    return Earliest;
+}
+
+void FComfyUITimerWheel::Reset()
+{
+    for (TArray<FTimer>& Slot : Slots)
+    {
+        Slot.Reset();
+    }
+    Locations.Reset();
+}
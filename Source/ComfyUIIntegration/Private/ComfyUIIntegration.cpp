@@ -3,6 +3,7 @@
 #include "ComfyUIIntegrationCommands.h"
 #include "Workflow/ComfyUIWorkflowService.h"
 #include "Client/ComfyUIClient.h"
+#include "Client/ComfyUIGameThreadDispatcher.h"
 #include "LevelEditor.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "Widgets/Layout/SBox.h"
@@ -47,8 +48,11 @@ void FComfyUIIntegrationModule::StartupModule()
         .SetDisplayName(LOCTEXT("FComfyUIIntegrationTabTitle", "ComfyUI 集成"))
         .SetMenuType(ETabSpawnerMenuType::Hidden);
         
-    // 初始化 ComfyUI 客户端单例
-    UComfyUIClient::GetInstance();
+    // 工作线程处理完的响应经由此队列回到游戏线程
+    FComfyUIGameThreadDispatcher::Initialize();
+    
+    // 初始化 ComfyUI 客户端单例，并在后台预先检查服务器，第一次生成时无需等待连接测试
+    UComfyUIClient::GetInstance()->StartHealthMonitor();
 }
 
 void FComfyUIIntegrationModule::ShutdownModule()
@@ -57,6 +61,7 @@ void FComfyUIIntegrationModule::ShutdownModule()
     
     // 销毁 ComfyUI 客户端单例
     UComfyUIClient::DestroyInstance();
+    FComfyUIGameThreadDispatcher::Shutdown();
     
     // 注销Tab生成器
     FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(ComfyUIIntegrationTabName);
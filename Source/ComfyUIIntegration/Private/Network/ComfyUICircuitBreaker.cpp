@@ -0,0 +1,187 @@
+#include "Network/ComfyUICircuitBreaker.h"
+#include "Network/ComfyUIRequestScheduler.h"
+
+FString FComfyUICircuitBreaker::GetEndpointKey(const FString& Url)
+{
+    // 只保留第一段路径：/history/{prompt_id} 与 /history 属于同一端点
+    const FString HostKey = FComfyUIRequestScheduler::GetHostKey(Url);
+    FString Path = Url.Mid(HostKey.Len());
+    int32 SegmentEnd = INDEX_NONE;
+    for (int32 Index = 1; Index < Path.Len(); ++Index)
+    {
+        if (Path[Index] == TEXT('/') || Path[Index] == TEXT('?') || Path[Index] == TEXT('#'))
+        {
+            SegmentEnd = Index;
+            break;
+        }
+    }
+    if (SegmentEnd != INDEX_NONE)
+    {
+        Path.LeftInline(SegmentEnd);
+    }
+    return HostKey + Path.ToLower();
+}
+
+bool FComfyUICircuitBreaker::IsFailure(FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    if (!bWasSuccessful || !Response.IsValid())
+    {
+        return true;
+    }
+
+    const int32 StatusCode = Response->GetResponseCode();
+    return StatusCode >= 500 || StatusCode == 429;
+}
+
+double FComfyUICircuitBreaker::ParseRetryAfter(FHttpResponsePtr Response)
+{
+    if (!Response.IsValid())
+    {
+        return 0.0;
+    }
+
+    const FString Header = Response->GetHeader(TEXT("Retry-After")).TrimStartAndEnd();
+    if (Header.IsEmpty())
+    {
+        return 0.0;
+    }
+
+    if (Header.IsNumeric())
+    {
+        return FMath::Max(0.0, FCString::Atod(*Header));
+    }
+
+    FDateTime RetryDate;
+    if (FDateTime::ParseHttpDate(Header, RetryDate))
+    {
+        return FMath::Max(0.0, (RetryDate - FDateTime::UtcNow()).GetTotalSeconds());
+    }
+    return 0.0;
+}
+
+bool FComfyUICircuitBreaker::AllowRequest(const FString& Url)
+{
+    FComfyUIEndpointHealth* Health = Endpoints.Find(GetEndpointKey(Url));
+    if (!Health)
+    {
+        return true;
+    }
+
+    switch (Health->State)
+    {
+    case EComfyUICircuitState::Closed:
+        // 服务器要求的 Retry-After 期间不再发出
+        return FPlatformTime::Seconds() >= Health->RetryAfterUntil;
+
+    case EComfyUICircuitState::Open:
+        if (FPlatformTime::Seconds() < Health->OpenUntil)
+        {
+            return false;
+        }
+        // 冷却结束：半开，放行这一个探测请求
+        Health->State = EComfyUICircuitState::HalfOpen;
+        Health->bProbeInFlight = true;
+        Health->ProbeStartTime = FPlatformTime::Seconds();
+        UE_LOG(LogTemp, Log, TEXT("CircuitBreaker: probing %s"), *GetEndpointKey(Url));
+        return true;
+
+    case EComfyUICircuitState::HalfOpen:
+        // 探测请求丢失（例如被调度器丢弃）时不应永远阻塞
+        if (Health->bProbeInFlight && FPlatformTime::Seconds() - Health->ProbeStartTime < MaxOpenSeconds)
+        {
+            return false;
+        }
+        Health->bProbeInFlight = true;
+        Health->ProbeStartTime = FPlatformTime::Seconds();
+        return true;
+    }
+    return true;
+}
+
+void FComfyUICircuitBreaker::Trip(FComfyUIEndpointHealth& Health, double Now)
+{
+    Health.TripCount++;
+
+    // 冷却时间按熔断次数加倍，并在 [0.75, 1.25] 倍之间抖动
+    const double OpenSeconds = FMath::Min(BaseOpenSeconds * FMath::Pow(2.0, (double)FMath::Min(Health.TripCount - 1, 8)), MaxOpenSeconds);
+    Health.State = EComfyUICircuitState::Open;
+    Health.OpenUntil = FMath::Max(Now + OpenSeconds * FMath::FRandRange(0.75, 1.25), Health.RetryAfterUntil);
+    Health.bProbeInFlight = false;
+}
+
+void FComfyUICircuitBreaker::RecordResult(const FString& Url, FHttpResponsePtr Response, bool bWasSuccessful)
+{
+    const FString Key = GetEndpointKey(Url);
+    const double Now = FPlatformTime::Seconds();
+
+    if (!IsFailure(Response, bWasSuccessful))
+    {
+        FComfyUIEndpointHealth* Health = Endpoints.Find(Key);
+        if (Health && Health->State != EComfyUICircuitState::Closed)
+        {
+            UE_LOG(LogTemp, Log, TEXT("CircuitBreaker: %s recovered"), *Key);
+        }
+        // 正常的端点不保留状态
+        Endpoints.Remove(Key);
+        return;
+    }
+
+    FComfyUIEndpointHealth& Health = Endpoints.FindOrAdd(Key);
+    Health.ConsecutiveFailures++;
+
+    const double RetryAfter = ParseRetryAfter(Response);
+    if (RetryAfter > 0.0)
+    {
+        Health.RetryAfterUntil = FMath::Max(Health.RetryAfterUntil, Now + RetryAfter);
+    }
+
+    if (Health.State == EComfyUICircuitState::HalfOpen)
+    {
+        // 探测失败，重新熔断
+        Trip(Health, Now);
+        UE_LOG(LogTemp, Warning, TEXT("CircuitBreaker: probe to %s failed, open for %.1fs"), *Key, Health.OpenUntil - Now);
+    }
+    else if (Health.State == EComfyUICircuitState::Closed && Health.ConsecutiveFailures >= FailureThreshold)
+    {
+        Trip(Health, Now);
+        UE_LOG(LogTemp, Warning, TEXT("CircuitBreaker: %s failed %d times, open for %.1fs"),
+               *Key, Health.ConsecutiveFailures, Health.OpenUntil - Now);
+    }
+}
+
+void FComfyUICircuitBreaker::RecordCancelled(const FString& Url)
+{
+    FComfyUIEndpointHealth* Health = Endpoints.Find(GetEndpointKey(Url));
+    if (Health && Health->State == EComfyUICircuitState::HalfOpen)
+    {
+        Health->bProbeInFlight = false;
+    }
+}
+
+EComfyUICircuitState FComfyUICircuitBreaker::GetState(const FString& Url) const
+{
+    const FComfyUIEndpointHealth* Health = Endpoints.Find(GetEndpointKey(Url));
+    return Health ? Health->State : EComfyUICircuitState::Closed;
+}
+
+double FComfyUICircuitBreaker::GetRetryDelay(const FString& ServerUrl) const
+{
+    const FString HostKey = FComfyUIRequestScheduler::GetHostKey(ServerUrl);
+    const double Now = FPlatformTime::Seconds();
+
+    double Delay = 0.0;
+    for (const TPair<FString, FComfyUIEndpointHealth>& Pair : Endpoints)
+    {
+        if (FComfyUIRequestScheduler::GetHostKey(Pair.Key) != HostKey)
+        {
+            continue;
+        }
+
+        Delay = FMath::Max(Delay, Pair.Value.RetryAfterUntil - Now);
+        if (Pair.Value.State == EComfyUICircuitState::Open)
+        {
+            Delay = FMath::Max(Delay, Pair.Value.OpenUntil - Now);
+        }
+    }
+    return Delay;
+}
@@ -0,0 +1,667 @@
+#include "Network/ComfyUIHistoryScanner.h"
+
+namespace
+{
+    /** 解码后的 UTF-8 字符串缓冲，键名通常很短，放在栈上 */
+    using FUtf8Buffer = TArray<UTF8CHAR, TInlineAllocator<64>>;
+
+    /**
+     * UTF-8 JSON 游标：只提供扫描历史记录需要的操作，跳过的值不做任何分配
+     */
+    class FJsonCursor
+    {
+    public:
+        FJsonCursor(const uint8* InBegin, const uint8* InEnd)
+            : Pos(InBegin)
+            , End(InEnd)
+        {
+            // 跳过 BOM
+            if (End - Pos >= 3 && Pos[0] == 0xEF && Pos[1] == 0xBB && Pos[2] == 0xBF)
+            {
+                Pos += 3;
+            }
+        }
+
+        bool HasError() const { return bError; }
+
+        void Fail() { bError = true; Pos = End; }
+
+        void SkipWhitespace()
+        {
+            while (Pos < End && (*Pos == ' ' || *Pos == '\t' || *Pos == '\n' || *Pos == '\r'))
+            {
+                ++Pos;
+            }
+        }
+
+        /** 下一个非空白字符，到达末尾时返回 0 */
+        uint8 Peek()
+        {
+            SkipWhitespace();
+            return Pos < End ? *Pos : 0;
+        }
+
+        bool Consume(uint8 Expected)
+        {
+            if (Peek() == Expected)
+            {
+                ++Pos;
+                return true;
+            }
+            return false;
+        }
+
+        bool Expect(uint8 Expected)
+        {
+            if (!Consume(Expected))
+            {
+                Fail();
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * 遍历对象的键：BeginObject 后反复调用 NextKey，返回 false 时对象结束。
+         * 每次 NextKey 返回 true 后调用方必须读取或跳过对应的值
+         */
+        bool BeginObject() { return Expect('{'); }
+
+        bool NextKey(FUtf8Buffer& OutKey, bool& bFirst)
+        {
+            if (bError)
+            {
+                return false;
+            }
+            if (Consume('}'))
+            {
+                return false;
+            }
+            if (!bFirst && !Expect(','))
+            {
+                return false;
+            }
+            bFirst = false;
+
+            if (!ReadString(OutKey) || !Expect(':'))
+            {
+                Fail();
+                return false;
+            }
+            return true;
+        }
+
+        /** 数组同理：BeginArray 后反复调用 NextElement */
+        bool BeginArray() { return Expect('['); }
+
+        bool NextElement(bool& bFirst)
+        {
+            if (bError)
+            {
+                return false;
+            }
+            if (Consume(']'))
+            {
+                return false;
+            }
+            if (!bFirst && !Expect(','))
+            {
+                return false;
+            }
+            bFirst = false;
+            return true;
+        }
+
+        /** 读取字符串并解码转义，结果为 UTF-8 */
+        bool ReadString(FUtf8Buffer& Out)
+        {
+            Out.Reset();
+            if (!Expect('"'))
+            {
+                return false;
+            }
+
+            while (Pos < End)
+            {
+                const uint8 Char = *Pos++;
+                if (Char == '"')
+                {
+                    return true;
+                }
+                if (Char != '\\')
+                {
+                    Out.Add((UTF8CHAR)Char);
+                    continue;
+                }
+
+                if (Pos >= End)
+                {
+                    break;
+                }
+                const uint8 Escape = *Pos++;
+                switch (Escape)
+                {
+                case '"':  Out.Add((UTF8CHAR)'"');  break;
+                case '\\': Out.Add((UTF8CHAR)'\\'); break;
+                case '/':  Out.Add((UTF8CHAR)'/');  break;
+                case 'b':  Out.Add((UTF8CHAR)'\b'); break;
+                case 'f':  Out.Add((UTF8CHAR)'\f'); break;
+                case 'n':  Out.Add((UTF8CHAR)'\n'); break;
+                case 'r':  Out.Add((UTF8CHAR)'\r'); break;
+                case 't':  Out.Add((UTF8CHAR)'\t'); break;
+                case 'u':
+                {
+                    uint32 CodePoint = 0;
+                    if (!ReadHex4(CodePoint))
+                    {
+                        Fail();
+                        return false;
+                    }
+                    // 代理对
+                    if (CodePoint >= 0xD800 && CodePoint <= 0xDBFF && End - Pos >= 6 && Pos[0] == '\\' && Pos[1] == 'u')
+                    {
+                        Pos += 2;
+                        uint32 Low = 0;
+                        if (!ReadHex4(Low))
+                        {
+                            Fail();
+                            return false;
+                        }
+                        CodePoint = 0x10000 + ((CodePoint - 0xD800) << 10) + (Low - 0xDC00);
+                    }
+                    AppendCodePoint(Out, CodePoint);
+                    break;
+                }
+                default:
+                    Fail();
+                    return false;
+                }
+            }
+
+            Fail();
+            return false;
+        }
+
+        /** 读取字符串并转换为 FString，值不是字符串时跳过并返回 false */
+        bool ReadStringValue(FString& Out)
+        {
+            if (Peek() != '"')
+            {
+                SkipValue();
+                return false;
+            }
+
+            FUtf8Buffer Buffer;
+            if (!ReadString(Buffer))
+            {
+                return false;
+            }
+            Out = ToString(Buffer);
+            return true;
+        }
+
+        /** 读取数字，值不是数字时跳过并返回 false */
+        bool ReadNumber(double& Out)
+        {
+            const uint8 First = Peek();
+            if (First != '-' && (First < '0' || First > '9'))
+            {
+                SkipValue();
+                return false;
+            }
+
+            ANSICHAR Buffer[64];
+            int32 Length = 0;
+            while (Pos < End && Length < UE_ARRAY_COUNT(Buffer) - 1 &&
+                   ((*Pos >= '0' && *Pos <= '9') || *Pos == '-' || *Pos == '+' || *Pos == '.' || *Pos == 'e' || *Pos == 'E'))
+            {
+                Buffer[Length++] = (ANSICHAR)*Pos++;
+            }
+            Buffer[Length] = 0;
+            Out = FCStringAnsi::Atod(Buffer);
+            return true;
+        }
+
+        /** 读取布尔值，值不是布尔值时跳过并返回 false */
+        bool ReadBool(bool& Out)
+        {
+            const uint8 First = Peek();
+            if (First == 't' && MatchLiteral("true"))
+            {
+                Out = true;
+                return true;
+            }
+            if (First == 'f' && MatchLiteral("false"))
+            {
+                Out = false;
+                return true;
+            }
+            SkipValue();
+            return false;
+        }
+
+        /** 跳过任意值，不解码字符串 */
+        void SkipValue()
+        {
+            int32 Depth = 0;
+            do
+            {
+                const uint8 Char = Peek();
+                switch (Char)
+                {
+                case '{':
+                case '[':
+                    ++Depth;
+                    ++Pos;
+                    break;
+                case '}':
+                case ']':
+                    --Depth;
+                    ++Pos;
+                    break;
+                case ',':
+                case ':':
+                    // 容器内部的分隔符
+                    if (Depth == 0)
+                    {
+                        Fail();
+                        return;
+                    }
+                    ++Pos;
+                    break;
+                case '"':
+                    SkipString();
+                    break;
+                case 0:
+                    Fail();
+                    return;
+                default:
+                    // 数字和字面量
+                    while (Pos < End && *Pos != ',' && *Pos != '}' && *Pos != ']' && *Pos != ':' &&
+                           *Pos != ' ' && *Pos != '\t' && *Pos != '\n' && *Pos != '\r')
+                    {
+                        ++Pos;
+                    }
+                    break;
+                }
+            }
+            while (Depth > 0 && !bError);
+
+            if (Depth < 0)
+            {
+                Fail();
+            }
+        }
+
+        static bool Equals(const FUtf8Buffer& Buffer, const ANSICHAR* Literal)
+        {
+            const int32 Length = FCStringAnsi::Strlen(Literal);
+            return Buffer.Num() == Length && FMemory::Memcmp(Buffer.GetData(), Literal, Length) == 0;
+        }
+
+        static FString ToString(const FUtf8Buffer& Buffer)
+        {
+            return Buffer.Num() > 0 ? FString(FUTF8ToTCHAR(Buffer.GetData(), Buffer.Num())) : FString();
+        }
+
+    private:
+        void SkipString()
+        {
+            ++Pos;
+            while (Pos < End)
+            {
+                const uint8 Char = *Pos++;
+                if (Char == '\\')
+                {
+                    ++Pos;
+                }
+                else if (Char == '"')
+                {
+                    return;
+                }
+            }
+            Fail();
+        }
+
+        bool MatchLiteral(const ANSICHAR* Literal)
+        {
+            const int32 Length = FCStringAnsi::Strlen(Literal);
+            if (End - Pos < Length || FMemory::Memcmp(Pos, Literal, Length) != 0)
+            {
+                return false;
+            }
+            Pos += Length;
+            return true;
+        }
+
+        bool ReadHex4(uint32& Out)
+        {
+            if (End - Pos < 4)
+            {
+                return false;
+            }
+            Out = 0;
+            for (int32 Index = 0; Index < 4; ++Index)
+            {
+                const uint8 Char = *Pos++;
+                Out <<= 4;
+                if (Char >= '0' && Char <= '9')      Out |= Char - '0';
+                else if (Char >= 'a' && Char <= 'f') Out |= Char - 'a' + 10;
+                else if (Char >= 'A' && Char <= 'F') Out |= Char - 'A' + 10;
+                else return false;
+            }
+            return true;
+        }
+
+        static void AppendCodePoint(FUtf8Buffer& Out, uint32 CodePoint)
+        {
+            if (CodePoint < 0x80)
+            {
+                Out.Add((UTF8CHAR)CodePoint);
+            }
+            else if (CodePoint < 0x800)
+            {
+                Out.Add((UTF8CHAR)(0xC0 | (CodePoint >> 6)));
+                Out.Add((UTF8CHAR)(0x80 | (CodePoint & 0x3F)));
+            }
+            else if (CodePoint < 0x10000)
+            {
+                Out.Add((UTF8CHAR)(0xE0 | (CodePoint >> 12)));
+                Out.Add((UTF8CHAR)(0x80 | ((CodePoint >> 6) & 0x3F)));
+                Out.Add((UTF8CHAR)(0x80 | (CodePoint & 0x3F)));
+            }
+            else
+            {
+                Out.Add((UTF8CHAR)(0xF0 | (CodePoint >> 18)));
+                Out.Add((UTF8CHAR)(0x80 | ((CodePoint >> 12) & 0x3F)));
+                Out.Add((UTF8CHAR)(0x80 | ((CodePoint >> 6) & 0x3F)));
+                Out.Add((UTF8CHAR)(0x80 | (CodePoint & 0x3F)));
+            }
+        }
+
+        const uint8* Pos;
+        const uint8* End;
+        bool bError = false;
+    };
+
+    void ScanFile(FJsonCursor& Cursor, TArray<FComfyUIHistoryFile>& OutFiles)
+    {
+        if (Cursor.Peek() != '{')
+        {
+            Cursor.SkipValue();
+            return;
+        }
+
+        FComfyUIHistoryFile File;
+        FUtf8Buffer Key;
+        bool bFirst = true;
+        Cursor.BeginObject();
+        while (Cursor.NextKey(Key, bFirst))
+        {
+            if (FJsonCursor::Equals(Key, "filename"))
+            {
+                Cursor.ReadStringValue(File.Filename);
+            }
+            else if (FJsonCursor::Equals(Key, "subfolder"))
+            {
+                Cursor.ReadStringValue(File.Subfolder);
+            }
+            else if (FJsonCursor::Equals(Key, "type"))
+            {
+                Cursor.ReadStringValue(File.FolderType);
+            }
+            else
+            {
+                Cursor.SkipValue();
+            }
+        }
+
+        if (!File.Filename.IsEmpty())
+        {
+            OutFiles.Add(MoveTemp(File));
+        }
+    }
+
+    void ScanFileArray(FJsonCursor& Cursor, TArray<FComfyUIHistoryFile>& OutFiles)
+    {
+        if (Cursor.Peek() != '[')
+        {
+            Cursor.SkipValue();
+            return;
+        }
+
+        bool bFirst = true;
+        Cursor.BeginArray();
+        while (Cursor.NextElement(bFirst))
+        {
+            ScanFile(Cursor, OutFiles);
+        }
+    }
+
+    void ScanNodeOutput(FJsonCursor& Cursor, FComfyUIHistoryNodeOutput& OutNode)
+    {
+        FUtf8Buffer Key;
+        bool bFirst = true;
+        Cursor.BeginObject();
+        while (Cursor.NextKey(Key, bFirst))
+        {
+            if (FJsonCursor::Equals(Key, "images"))
+            {
+                ScanFileArray(Cursor, OutNode.Images);
+            }
+            else if (FJsonCursor::Equals(Key, "gltf") || FJsonCursor::Equals(Key, "glb") ||
+                     FJsonCursor::Equals(Key, "meshes") || FJsonCursor::Equals(Key, "mesh"))
+            {
+                ScanFileArray(Cursor, OutNode.Meshes);
+            }
+            else if (FJsonCursor::Equals(Key, "text") && Cursor.Peek() == '[')
+            {
+                bool bFirstText = true;
+                Cursor.BeginArray();
+                while (Cursor.NextElement(bFirstText))
+                {
+                    FString Text;
+                    if (Cursor.ReadStringValue(Text))
+                    {
+                        OutNode.Texts.Add(MoveTemp(Text));
+                    }
+                }
+            }
+            else
+            {
+                Cursor.SkipValue();
+            }
+        }
+    }
+
+    void ScanOutputs(FJsonCursor& Cursor, FComfyUIHistoryEntry& OutEntry)
+    {
+        if (Cursor.Peek() != '{')
+        {
+            Cursor.SkipValue();
+            return;
+        }
+
+        FUtf8Buffer Key;
+        bool bFirst = true;
+        Cursor.BeginObject();
+        while (Cursor.NextKey(Key, bFirst))
+        {
+            if (Cursor.Peek() != '{')
+            {
+                Cursor.SkipValue();
+                continue;
+            }
+
+            FComfyUIHistoryNodeOutput Node;
+            Node.NodeId = FJsonCursor::ToString(Key);
+            ScanNodeOutput(Cursor, Node);
+            if (Node.Images.Num() > 0 || Node.Texts.Num() > 0 || Node.Meshes.Num() > 0)
+            {
+                OutEntry.Outputs.Add(MoveTemp(Node));
+            }
+        }
+    }
+
+    /** status.messages: [["execution_start", {"timestamp": ...}], ...] */
+    void ScanMessages(FJsonCursor& Cursor, FComfyUIHistoryEntry& OutEntry)
+    {
+        if (Cursor.Peek() != '[')
+        {
+            Cursor.SkipValue();
+            return;
+        }
+
+        FUtf8Buffer MessageType;
+        bool bFirst = true;
+        Cursor.BeginArray();
+        while (Cursor.NextElement(bFirst))
+        {
+            if (Cursor.Peek() != '[')
+            {
+                Cursor.SkipValue();
+                continue;
+            }
+
+            MessageType.Reset();
+            double* Target = nullptr;
+            int32 Index = 0;
+            bool bFirstField = true;
+            Cursor.BeginArray();
+            while (Cursor.NextElement(bFirstField))
+            {
+                if (Index == 0 && Cursor.Peek() == '"')
+                {
+                    Cursor.ReadString(MessageType);
+                    if (FJsonCursor::Equals(MessageType, "execution_start"))
+                    {
+                        Target = &OutEntry.ExecutionStartTimestamp;
+                    }
+                    else if (FJsonCursor::Equals(MessageType, "execution_success"))
+                    {
+                        Target = &OutEntry.ExecutionEndTimestamp;
+                    }
+                }
+                else if (Index == 1 && Target && Cursor.Peek() == '{')
+                {
+                    FUtf8Buffer Key;
+                    bool bFirstKey = true;
+                    Cursor.BeginObject();
+                    while (Cursor.NextKey(Key, bFirstKey))
+                    {
+                        if (FJsonCursor::Equals(Key, "timestamp"))
+                        {
+                            Cursor.ReadNumber(*Target);
+                        }
+                        else
+                        {
+                            Cursor.SkipValue();
+                        }
+                    }
+                }
+                else
+                {
+                    Cursor.SkipValue();
+                }
+                ++Index;
+            }
+        }
+    }
+
+    void ScanStatus(FJsonCursor& Cursor, FComfyUIHistoryEntry& OutEntry)
+    {
+        if (Cursor.Peek() != '{')
+        {
+            Cursor.SkipValue();
+            return;
+        }
+
+        FUtf8Buffer Key;
+        bool bFirst = true;
+        Cursor.BeginObject();
+        while (Cursor.NextKey(Key, bFirst))
+        {
+            if (FJsonCursor::Equals(Key, "status_str"))
+            {
+                Cursor.ReadStringValue(OutEntry.StatusStr);
+            }
+            else if (FJsonCursor::Equals(Key, "completed"))
+            {
+                Cursor.ReadBool(OutEntry.bCompleted);
+            }
+            else if (FJsonCursor::Equals(Key, "messages"))
+            {
+                ScanMessages(Cursor, OutEntry);
+            }
+            else
+            {
+                Cursor.SkipValue();
+            }
+        }
+    }
+
+    void ScanEntry(FJsonCursor& Cursor, FComfyUIHistoryEntry& OutEntry)
+    {
+        FUtf8Buffer Key;
+        bool bFirst = true;
+        Cursor.BeginObject();
+        while (Cursor.NextKey(Key, bFirst))
+        {
+            // prompt 字段包含整个工作流，是响应中最大的部分，直接跳过
+            if (FJsonCursor::Equals(Key, "status"))
+            {
+                ScanStatus(Cursor, OutEntry);
+            }
+            else if (FJsonCursor::Equals(Key, "outputs"))
+            {
+                ScanOutputs(Cursor, OutEntry);
+            }
+            else
+            {
+                Cursor.SkipValue();
+            }
+        }
+    }
+}
+
+bool FComfyUIHistoryScanner::Scan(TArrayView<const uint8> Utf8Content, TMap<FString, FComfyUIHistoryEntry>& OutEntries, const FString& OnlyPromptId)
+{
+    FJsonCursor Cursor(Utf8Content.GetData(), Utf8Content.GetData() + Utf8Content.Num());
+    if (Cursor.Peek() != '{')
+    {
+        return false;
+    }
+
+    // 只需要一个 prompt 时按 UTF-8 比较键，不转换其他键
+    FUtf8Buffer OnlyKey;
+    if (!OnlyPromptId.IsEmpty())
+    {
+        FTCHARToUTF8 Converter(*OnlyPromptId);
+        OnlyKey.Append(reinterpret_cast<const UTF8CHAR*>(Converter.Get()), Converter.Length());
+    }
+
+    FUtf8Buffer Key;
+    bool bFirst = true;
+    Cursor.BeginObject();
+    while (Cursor.NextKey(Key, bFirst))
+    {
+        const bool bWanted = OnlyKey.Num() == 0 ||
+            (Key.Num() == OnlyKey.Num() && FMemory::Memcmp(Key.GetData(), OnlyKey.GetData(), Key.Num()) == 0);
+        if (!bWanted || Cursor.Peek() != '{')
+        {
+            Cursor.SkipValue();
+            continue;
+        }
+
+        FComfyUIHistoryEntry Entry;
+        Entry.PromptId = FJsonCursor::ToString(Key);
+        ScanEntry(Cursor, Entry);
+        if (Cursor.HasError())
+        {
+            break;
+        }
+        OutEntries.Add(Entry.PromptId, MoveTemp(Entry));
+    }
+
+    return !Cursor.HasError();
+}
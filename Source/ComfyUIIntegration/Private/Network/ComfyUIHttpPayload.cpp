@@ -0,0 +1,7 @@
+#include "Network/ComfyUIHttpPayload.h"
+
+const TArray<uint8>& FComfyUIHttpPayload::GetData() const
+{
+    static const TArray<uint8> Empty;
+    return Response.IsValid() ? Response->GetContent() : Empty;
+}
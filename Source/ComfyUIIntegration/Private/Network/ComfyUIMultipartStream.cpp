@@ -0,0 +1,224 @@
+#include "Network/ComfyUIMultipartStream.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+FComfyUIMultipartFormStream::FComfyUIMultipartFormStream()
+{
+    SetIsLoading(true);
+    SetIsPersistent(false);
+    Boundary = FString::Printf(TEXT("----UnrealEngineFormBoundary%s"), *FGuid::NewGuid().ToString(EGuidFormats::Digits));
+}
+
+FComfyUIMultipartFormStream::~FComfyUIMultipartFormStream()
+{
+    Close();
+}
+
+FString FComfyUIMultipartFormStream::GetContentType() const
+{
+    return FString::Printf(TEXT("multipart/form-data; boundary=%s"), *Boundary);
+}
+
+FString FComfyUIMultipartFormStream::GetContentTypeForFile(const FString& FileName)
+{
+    const FString Extension = FPaths::GetExtension(FileName).ToLower();
+    if (Extension == TEXT("png"))  return TEXT("image/png");
+    if (Extension == TEXT("jpg") || Extension == TEXT("jpeg")) return TEXT("image/jpeg");
+    if (Extension == TEXT("webp")) return TEXT("image/webp");
+    if (Extension == TEXT("glb"))  return TEXT("model/gltf-binary");
+    if (Extension == TEXT("gltf")) return TEXT("model/gltf+json");
+    if (Extension == TEXT("obj"))  return TEXT("text/plain");
+    return TEXT("application/octet-stream");
+}
+
+void FComfyUIMultipartFormStream::AppendText(const FString& Text)
+{
+    // 按 UTF-8 字节长度写入，非 ASCII 文件名不会被截断
+    FTCHARToUTF8 Converter(*Text);
+    FSegment Segment;
+    Segment.Bytes.Append(reinterpret_cast<const uint8*>(Converter.Get()), Converter.Length());
+    Segment.Size = Segment.Bytes.Num();
+    AppendSegment(MoveTemp(Segment));
+}
+
+void FComfyUIMultipartFormStream::AppendSegment(FSegment&& Segment)
+{
+    const int64 SegmentSize = Segment.Size;
+    if (SegmentSize <= 0)
+    {
+        return;
+    }
+
+    // 相邻的内存段合并，减少读取时的分段
+    if (Segment.bMergeable && Segments.Num() > 0 && Segments.Last().bMergeable)
+    {
+        FSegment& Last = Segments.Last();
+        Last.Bytes.Append(Segment.Bytes);
+        Last.Size = Last.Bytes.Num();
+    }
+    else
+    {
+        Segment.Offset = TotalBytes;
+        Segments.Add(MoveTemp(Segment));
+    }
+    TotalBytes += SegmentSize;
+}
+
+void FComfyUIMultipartFormStream::AddField(const FString& Name, const FString& Value)
+{
+    check(!bFinalized);
+    AppendText(FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"%s\"\r\n\r\n%s\r\n"), *Boundary, *Name, *Value));
+}
+
+bool FComfyUIMultipartFormStream::AddFile(const FString& FieldName, const FString& FileName, const FString& ContentType, const FString& FilePath)
+{
+    check(!bFinalized);
+    const int64 FileSize = IFileManager::Get().FileSize(*FilePath);
+    if (FileSize < 0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Multipart: file not found: %s"), *FilePath);
+        return false;
+    }
+
+    AppendText(FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\nContent-Type: %s\r\n\r\n"),
+                               *Boundary, *FieldName, *FileName, *ContentType));
+
+    FSegment FileSegment;
+    FileSegment.FilePath = FilePath;
+    FileSegment.Size = FileSize;
+    FileSegment.bMergeable = false;
+    AppendSegment(MoveTemp(FileSegment));
+
+    AppendText(TEXT("\r\n"));
+    return true;
+}
+
+void FComfyUIMultipartFormStream::AddFileData(const FString& FieldName, const FString& FileName, const FString& ContentType, TArray<uint8>&& Data)
+{
+    check(!bFinalized);
+    AppendText(FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"%s\"; filename=\"%s\"\r\nContent-Type: %s\r\n\r\n"),
+                               *Boundary, *FieldName, *FileName, *ContentType));
+
+    // 数据段单独保存，不与前后的文本段合并，避免再拷贝一次
+    FSegment DataSegment;
+    DataSegment.Size = Data.Num();
+    DataSegment.Bytes = MoveTemp(Data);
+    DataSegment.bMergeable = false;
+    AppendSegment(MoveTemp(DataSegment));
+
+    AppendText(TEXT("\r\n"));
+}
+
+void FComfyUIMultipartFormStream::Finalize()
+{
+    if (!bFinalized)
+    {
+        AppendText(FString::Printf(TEXT("--%s--\r\n"), *Boundary));
+        bFinalized = true;
+    }
+}
+
+int32 FComfyUIMultipartFormStream::FindSegment(int64 InPos) const
+{
+    // 段数很少（通常不超过5段），线性查找即可
+    for (int32 Index = 0; Index < Segments.Num(); ++Index)
+    {
+        const FSegment& Segment = Segments[Index];
+        if (InPos >= Segment.Offset && InPos < Segment.Offset + Segment.Size)
+        {
+            return Index;
+        }
+    }
+    return INDEX_NONE;
+}
+
+FArchive* FComfyUIMultipartFormStream::OpenFileSegment(int32 SegmentIndex)
+{
+    if (OpenSegmentIndex != SegmentIndex)
+    {
+        FileReader.Reset();
+        OpenSegmentIndex = INDEX_NONE;
+
+        FileReader.Reset(IFileManager::Get().CreateFileReader(*Segments[SegmentIndex].FilePath));
+        if (!FileReader.IsValid())
+        {
+            UE_LOG(LogTemp, Error, TEXT("Multipart: failed to open %s"), *Segments[SegmentIndex].FilePath);
+            return nullptr;
+        }
+
+        // 文件在构建请求后被修改，Content-Length 已经不正确
+        if (FileReader->TotalSize() != Segments[SegmentIndex].Size)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Multipart: %s changed size during upload"), *Segments[SegmentIndex].FilePath);
+            FileReader.Reset();
+            return nullptr;
+        }
+        OpenSegmentIndex = SegmentIndex;
+    }
+    return FileReader.Get();
+}
+
+void FComfyUIMultipartFormStream::Serialize(void* Data, int64 Length)
+{
+    uint8* Dest = static_cast<uint8*>(Data);
+    while (Length > 0)
+    {
+        const int32 SegmentIndex = FindSegment(Position);
+        if (SegmentIndex == INDEX_NONE)
+        {
+            SetError();
+            return;
+        }
+
+        const FSegment& Segment = Segments[SegmentIndex];
+        const int64 SegmentOffset = Position - Segment.Offset;
+        const int64 BytesToCopy = FMath::Min(Length, Segment.Size - SegmentOffset);
+
+        if (Segment.IsFile())
+        {
+            FArchive* Reader = OpenFileSegment(SegmentIndex);
+            if (!Reader)
+            {
+                SetError();
+                return;
+            }
+            if (Reader->Tell() != SegmentOffset)
+            {
+                Reader->Seek(SegmentOffset);
+            }
+            Reader->Serialize(Dest, BytesToCopy);
+            if (Reader->IsError())
+            {
+                SetError();
+                return;
+            }
+
+            // 文件读完后立即关闭句柄
+            if (SegmentOffset + BytesToCopy >= Segment.Size)
+            {
+                FileReader.Reset();
+                OpenSegmentIndex = INDEX_NONE;
+            }
+        }
+        else
+        {
+            FMemory::Memcpy(Dest, Segment.Bytes.GetData() + SegmentOffset, BytesToCopy);
+        }
+
+        Dest += BytesToCopy;
+        Position += BytesToCopy;
+        Length -= BytesToCopy;
+    }
+}
+
+void FComfyUIMultipartFormStream::Seek(int64 InPos)
+{
+    Position = FMath::Clamp<int64>(InPos, 0, TotalBytes);
+}
+
+bool FComfyUIMultipartFormStream::Close()
+{
+    FileReader.Reset();
+    OpenSegmentIndex = INDEX_NONE;
+    return !IsError();
+}
@@ -1,15 +1,139 @@
 #include "Network/ComfyUINetworkManager.h"
+#include "Network/ComfyUIMultipartStream.h"
+#include "Network/ComfyUIRangeDownload.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
 #include "HttpModule.h"
 #include "Interfaces/IHttpRequest.h"
 #include "Interfaces/IHttpResponse.h"
+#include "GenericPlatform/GenericPlatformHttp.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Policies/CondensedJsonPrintPolicy.h"
 
 UComfyUINetworkManager::UComfyUINetworkManager()
 {
     HttpModule = &FHttpModule::Get();
 }
 
+void UComfyUINetworkManager::ProcessRequest(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request, EComfyUIRequestPriority Priority)
+{
+    if (!CircuitBreaker.IsValid())
+    {
+        CircuitBreaker = MakeShared<FComfyUICircuitBreaker>();
+    }
+    
+    FHttpRequestCompleteDelegate OriginalCallback = Request->OnProcessRequestComplete();
+    
+    // 端点已熔断：不发出请求，下一帧以失败结束（请求状态保持 NotStarted），避免在调用方栈内重入
+    if (!CircuitBreaker->AllowRequest(Request->GetURL()))
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("NetworkManager: circuit open, failing fast for %s"), *Request->GetURL());
+        FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+            [Request, OriginalCallback](float DeltaTime)
+            {
+                OriginalCallback.ExecuteIfBound(Request, nullptr, false);
+                return false;
+            }));
+        return;
+    }
+    
+    // 记录结果后再执行原回调；本地取消的请求不代表端点故障，不记录
+    TWeakPtr<FComfyUICircuitBreaker> WeakBreaker = CircuitBreaker;
+    TWeakObjectPtr<UComfyUINetworkManager> WeakThis(this);
+    Request->OnProcessRequestComplete().BindLambda(
+        [WeakBreaker, WeakThis, OriginalCallback](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
+        {
+            const bool bCancelled = WeakThis.IsValid() && WeakThis->CancelledRequests.Remove(Req.Get()) > 0;
+            TSharedPtr<FComfyUICircuitBreaker> Breaker = WeakBreaker.Pin();
+            if (Breaker.IsValid())
+            {
+                if (bCancelled)
+                {
+                    Breaker->RecordCancelled(Req->GetURL());
+                }
+                else
+                {
+                    Breaker->RecordResult(Req->GetURL(), Resp, bSuccess);
+                }
+            }
+            OriginalCallback.ExecuteIfBound(Req, Resp, bSuccess);
+        }
+    );
+    
+    // 登记到当前请求组，顺便清理组中已结束的请求
+    if (!CurrentRequestGroup.IsEmpty())
+    {
+        TArray<TWeakPtr<IHttpRequest, ESPMode::ThreadSafe>>& GroupRequests = RequestGroups.FindOrAdd(CurrentRequestGroup);
+        GroupRequests.RemoveAll([](const TWeakPtr<IHttpRequest, ESPMode::ThreadSafe>& Weak) { return !Weak.IsValid(); });
+        GroupRequests.Add(Request);
+    }
+    
+    // 所有请求经过调度器发出，按服务器限制并发并按优先级排队
+    if (!Scheduler.IsValid())
+    {
+        Scheduler = MakeShared<FComfyUIRequestScheduler>();
+    }
+    Scheduler->Enqueue(Request, Priority);
+}
+
+void UComfyUINetworkManager::CancelRequestGroup(const FString& Group)
+{
+    TArray<TWeakPtr<IHttpRequest, ESPMode::ThreadSafe>> GroupRequests;
+    if (!RequestGroups.RemoveAndCopyValue(Group, GroupRequests))
+    {
+        return;
+    }
+    
+    int32 NumCancelled = 0;
+    for (const TWeakPtr<IHttpRequest, ESPMode::ThreadSafe>& Weak : GroupRequests)
+    {
+        TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> Request = Weak.Pin();
+        if (!Request.IsValid())
+        {
+            continue;
+        }
+        
+        // 尚未发出：从调度队列移除即可
+        if (Scheduler.IsValid() && Scheduler->Remove(Request.ToSharedRef()))
+        {
+            if (CircuitBreaker.IsValid())
+            {
+                CircuitBreaker->RecordCancelled(Request->GetURL());
+            }
+            ++NumCancelled;
+            continue;
+        }
+        
+        // 已发出：中止传输，完成回调以失败触发并释放调度名额
+        if (Request->GetStatus() == EHttpRequestStatus::Processing)
+        {
+            CancelledRequests.Add(Request.Get());
+            Request->CancelRequest();
+            ++NumCancelled;
+        }
+    }
+    
+    if (NumCancelled > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("NetworkManager: cancelled %d requests in group %s"), NumCancelled, *Group);
+    }
+}
+
+FComfyUIRequestSchedulerStats UComfyUINetworkManager::GetSchedulerStats(const FString& ServerUrl) const
+{
+    return Scheduler.IsValid() ? Scheduler->GetStats(ServerUrl) : FComfyUIRequestSchedulerStats();
+}
+
+double UComfyUINetworkManager::GetRetryDelay(const FString& ServerUrl) const
+{
+    return CircuitBreaker.IsValid() ? CircuitBreaker->GetRetryDelay(ServerUrl) : 0.0;
+}
+
 void UComfyUINetworkManager::SendRequest(const FString& Url, const FString& Payload, TFunction<void(const FString& Response, bool bSuccess)> Callback)
 {
     // 构建HTTP请求
@@ -38,10 +162,10 @@ void UComfyUINetworkManager::SendRequest(const FString& Url, const FString& Payl
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, EComfyUIRequestPriority::Submit);
 }
 
-void UComfyUINetworkManager::SendGetRequest(const FString& Url, TFunction<void(const FString& Response, bool bSuccess)> Callback, float TimeoutSeconds)
+void UComfyUINetworkManager::SendGetRequest(const FString& Url, TFunction<void(const FString& Response, bool bSuccess)> Callback, float TimeoutSeconds, EComfyUIRequestPriority Priority)
 {
     if (!HttpModule) HttpModule = &FHttpModule::Get();
     
@@ -69,17 +193,17 @@ void UComfyUINetworkManager::SendGetRequest(const FString& Url, TFunction<void(c
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, Priority);
 }
 
-void UComfyUINetworkManager::DownloadImage(const FString& Url, TFunction<void(const TArray<uint8>& ImageData, bool bSuccess)> Callback)
+void UComfyUINetworkManager::SendGetRequestRaw(const FString& Url, TFunction<void(const FComfyUIHttpPayload& Content, bool bSuccess)> Callback, float TimeoutSeconds, EComfyUIRequestPriority Priority)
 {
     if (!HttpModule) HttpModule = &FHttpModule::Get();
     
     TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
     Request->SetURL(Url);
     Request->SetVerb(TEXT("GET"));
-    Request->SetTimeout(30.0f);
+    Request->SetTimeout(TimeoutSeconds);
 
     Request->OnProcessRequestComplete().BindLambda(
         [this, Callback](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
@@ -88,178 +212,185 @@ void UComfyUINetworkManager::DownloadImage(const FString& Url, TFunction<void(co
             
             if (Error.ErrorType == EComfyUIErrorType::None)
             {
-                TArray<uint8> ImageData = Resp->GetContent();
-                Callback(ImageData, true);
+                // 响应体保持 UTF-8 原样交给调用方
+                Callback(FComfyUIHttpPayload(Resp), true);
             }
             else
             {
-                UE_LOG(LogTemp, Warning, TEXT("NetworkManager Image Download failed: %s"), *Error.ErrorMessage);
-                TArray<uint8> EmptyData;
-                Callback(EmptyData, false);
+                UE_LOG(LogTemp, Warning, TEXT("NetworkManager GET Request failed: %s"), *Error.ErrorMessage);
+                Callback(FComfyUIHttpPayload(), false);
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, Priority);
 }
-#pragma optimize("", off)
-void UComfyUINetworkManager::UploadImage(const FString& ServerUrl, const TArray<uint8>& ImageData, const FString& FileName, TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback)
+
+void UComfyUINetworkManager::DownloadImage(const FString& Url, TFunction<void(const FComfyUIHttpPayload& ImageData, bool bSuccess)> Callback)
 {
     if (!HttpModule) HttpModule = &FHttpModule::Get();
     
-    // 构建上传URL
-    FString UploadUrl = ServerUrl;
-    if (!UploadUrl.EndsWith(TEXT("/"))) UploadUrl += TEXT("/"); 
-    UploadUrl += TEXT("upload/image");
-    
     TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
-    Request->SetURL(UploadUrl);
-    Request->SetVerb(TEXT("POST"));
-    Request->SetTimeout(60.0f); // 图片上传需要更长时间
-    
-    // 创建multipart/form-data格式的内容
-    FString Boundary = FString::Printf(TEXT("----UnrealEngine4FormBoundary%d"), FMath::Rand());
-    FString ContentType = FString::Printf(TEXT("multipart/form-data; boundary=%s"), *Boundary);
-    Request->SetHeader(TEXT("Content-Type"), ContentType);
-    
-    // 构建multipart内容
-    TArray<uint8> FormData;
-    
-    // 添加文件字段
-    FString FileHeader = FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\nContent-Type: image/png\r\n\r\n"), *Boundary, *FileName);
-    FormData.Append((uint8*)TCHAR_TO_UTF8(*FileHeader), FileHeader.Len());
-    FormData.Append(ImageData);
-    
-    // 添加结束边界
-    FString EndBoundary = FString::Printf(TEXT("\r\n--%s--\r\n"), *Boundary);
-    FormData.Append((uint8*)TCHAR_TO_UTF8(*EndBoundary), EndBoundary.Len());
-    
-    Request->SetContent(FormData);
+    Request->SetURL(Url);
+    Request->SetVerb(TEXT("GET"));
+    Request->SetTimeout(30.0f);
 
     Request->OnProcessRequestComplete().BindLambda(
         [this, Callback](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
         {
-            // 分析HTTP错误
             FComfyUIError Error = AnalyzeHttpError(Req, Resp, bSuccess);
             
             if (Error.ErrorType == EComfyUIErrorType::None)
             {
-                // 解析响应JSON获取上传的图片名称
-                FString ResponseContent = Resp->GetContentAsString();
-                TSharedPtr<FJsonObject> JsonObject;
-                TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
-                
-                if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid())
-                {
-                    FString UploadedImageName;
-                    if (JsonObject->TryGetStringField(TEXT("name"), UploadedImageName))
-                    {
-                        UE_LOG(LogTemp, Log, TEXT("Image uploaded successfully: %s"), *UploadedImageName);
-                        Callback(UploadedImageName, true);
-                        return;
-                    }
-                }
-                
-                UE_LOG(LogTemp, Warning, TEXT("Image uploaded but failed to parse response: %s"), *ResponseContent);
-                Callback(TEXT(""), false);
+                Callback(FComfyUIHttpPayload(Resp), true);
             }
             else
             {
-                // 请求失败，记录错误
-                UE_LOG(LogTemp, Warning, TEXT("NetworkManager Image Upload failed: %s"), *Error.ErrorMessage);
-                Callback(TEXT(""), false);
+                UE_LOG(LogTemp, Warning, TEXT("NetworkManager Image Download failed: %s"), *Error.ErrorMessage);
+                Callback(FComfyUIHttpPayload(), false);
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, EComfyUIRequestPriority::Download);
 }
 
-void UComfyUINetworkManager::UploadModel(const FString& ServerUrl, const TArray<uint8>& ModelData, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback)
+void UComfyUINetworkManager::UploadImage(const FString& ServerUrl, TArray<uint8> ImageData, const FString& FileName, TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback)
 {
-    if (!HttpModule) HttpModule = &FHttpModule::Get();
+    // 构建multipart内容，图像数据移交给请求体，不再复制
+    TSharedRef<FComfyUIMultipartFormStream, ESPMode::ThreadSafe> FormStream = MakeShared<FComfyUIMultipartFormStream, ESPMode::ThreadSafe>();
+    FormStream->AddFileData(TEXT("image"), FileName, TEXT("image/png"), MoveTemp(ImageData));
+    FormStream->Finalize();
     
-    // 使用通用的 /upload/image 端点，指定 type=input 将文件上传到 input 目录
-    FString UploadUrl = ServerUrl;
-    if (!UploadUrl.EndsWith(TEXT("/"))) UploadUrl += TEXT("/");
-    UploadUrl += TEXT("upload/image");
+    // 图片上传需要更长时间
+    SendMultipartUpload(ServerUrl, FormStream, 60.0f, TEXT("Image"), Callback);
+}
+
+void UComfyUINetworkManager::UploadModel(const FString& ServerUrl, TArray<uint8> ModelData, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback)
+{
+    TSharedRef<FComfyUIMultipartFormStream, ESPMode::ThreadSafe> FormStream = MakeShared<FComfyUIMultipartFormStream, ESPMode::ThreadSafe>();
     
-    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
-    Request->SetURL(UploadUrl);
-    Request->SetVerb(TEXT("POST"));
-    Request->SetTimeout(120.0f);
+    // 添加type字段，指定为input目录
+    FormStream->AddField(TEXT("type"), TEXT("input"));
     
-    // 创建multipart/form-data格式的内容
-    FString Boundary = FString::Printf(TEXT("----UnrealEngine4FormBoundary%d"), FMath::Rand());
-    FString ContentType = FString::Printf(TEXT("multipart/form-data; boundary=%s"), *Boundary);
-    Request->SetHeader(TEXT("Content-Type"), ContentType);
+    // 添加文件字段 - 注意使用"image"作为字段名（ComfyUI的通用上传字段）
+    FormStream->AddFileData(TEXT("image"), FileName, FComfyUIMultipartFormStream::GetContentTypeForFile(FileName), MoveTemp(ModelData));
+    FormStream->Finalize();
     
-    // 构建multipart内容
-    TArray<uint8> FormData;
+    SendMultipartUpload(ServerUrl, FormStream, 120.0f, TEXT("Model"), Callback);
+}
+
+void UComfyUINetworkManager::UploadModelFile(const FString& ServerUrl, const FString& FilePath, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback)
+{
+    TSharedRef<FComfyUIMultipartFormStream, ESPMode::ThreadSafe> FormStream = MakeShared<FComfyUIMultipartFormStream, ESPMode::ThreadSafe>();
     
     // 添加type字段，指定为input目录
-    FString TypeField = FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"type\"\r\n\r\ninput\r\n"), *Boundary);
-    FormData.Append((uint8*)TCHAR_TO_UTF8(*TypeField), TypeField.Len());
-    
-    // 根据文件扩展名确定Content-Type
-    FString ModelContentType = TEXT("application/octet-stream");
-    if (FileName.EndsWith(TEXT(".glb")))
-        ModelContentType = TEXT("model/gltf-binary");
-    else if (FileName.EndsWith(TEXT(".gltf")))
-        ModelContentType = TEXT("model/gltf+json");
-    else if (FileName.EndsWith(TEXT(".obj")))
-        ModelContentType = TEXT("text/plain");
-    else if (FileName.EndsWith(TEXT(".ply")))
-        ModelContentType = TEXT("application/octet-stream");
+    FormStream->AddField(TEXT("type"), TEXT("input"));
     
-    // 添加文件字段 - 注意使用"image"作为字段名（ComfyUI的通用上传字段）
-    FString FileHeader = FString::Printf(TEXT("--%s\r\nContent-Disposition: form-data; name=\"image\"; filename=\"%s\"\r\nContent-Type: %s\r\n\r\n"), 
-                                        *Boundary, *FileName, *ModelContentType);
-    FormData.Append((uint8*)TCHAR_TO_UTF8(*FileHeader), FileHeader.Len());
-    FormData.Append(ModelData);
+    // 文件内容在发送时按块从磁盘读取
+    if (!FormStream->AddFile(TEXT("image"), FileName, FComfyUIMultipartFormStream::GetContentTypeForFile(FileName), FilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("NetworkManager Model Upload failed: cannot read %s"), *FilePath);
+        Callback(TEXT(""), false);
+        return;
+    }
+    FormStream->Finalize();
     
-    // 添加结束边界
-    FString EndBoundary = FString::Printf(TEXT("\r\n--%s--\r\n"), *Boundary);
-    FormData.Append((uint8*)TCHAR_TO_UTF8(*EndBoundary), EndBoundary.Len());
+    // 大文件上传按文件大小放宽超时（至少120秒，每100MB再加60秒）
+    const float TimeoutSeconds = 120.0f + 60.0f * (float)(FormStream->TotalSize() / (100 * 1024 * 1024));
+    SendMultipartUpload(ServerUrl, FormStream, TimeoutSeconds, TEXT("Model"), Callback);
+}
+
+void UComfyUINetworkManager::SendMultipartUpload(const FString& ServerUrl, TSharedRef<FComfyUIMultipartFormStream, ESPMode::ThreadSafe> FormStream, float TimeoutSeconds, const FString& Label, TFunction<void(const FString& UploadedName, bool bSuccess)> Callback)
+{
+    if (!HttpModule) HttpModule = &FHttpModule::Get();
     
-    Request->SetContent(FormData);
+    // 使用通用的 /upload/image 端点
+    FString UploadUrl = ServerUrl;
+    if (!UploadUrl.EndsWith(TEXT("/"))) UploadUrl += TEXT("/");
+    UploadUrl += TEXT("upload/image");
+    
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
+    Request->SetURL(UploadUrl);
+    Request->SetVerb(TEXT("POST"));
+    Request->SetTimeout(TimeoutSeconds);
+    Request->SetHeader(TEXT("Content-Type"), FormStream->GetContentType());
+    Request->SetContentFromStream(FormStream);
 
     Request->OnProcessRequestComplete().BindLambda(
-        [this, Callback](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
+        [this, Callback, Label](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
         {
             // 分析HTTP错误
             FComfyUIError Error = AnalyzeHttpError(Req, Resp, bSuccess);
             
             if (Error.ErrorType == EComfyUIErrorType::None)
             {
-                // 解析响应JSON获取上传的模型名称
+                // 解析响应JSON获取上传后的文件名称
                 FString ResponseContent = Resp->GetContentAsString();
                 TSharedPtr<FJsonObject> JsonObject;
                 TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
                 
                 if (FJsonSerializer::Deserialize(Reader, JsonObject) && JsonObject.IsValid())
                 {
-                    FString UploadedModelName;
-                    if (JsonObject->TryGetStringField(TEXT("name"), UploadedModelName))
+                    FString UploadedName;
+                    if (JsonObject->TryGetStringField(TEXT("name"), UploadedName))
                     {
-                        UE_LOG(LogTemp, Log, TEXT("Model uploaded successfully: %s"), *UploadedModelName);
-                        Callback(UploadedModelName, true);
+                        // 服务器返回子目录时需要带上，工作流按相对 input 目录的路径引用
+                        FString Subfolder;
+                        if (JsonObject->TryGetStringField(TEXT("subfolder"), Subfolder) && !Subfolder.IsEmpty())
+                        {
+                            UploadedName = Subfolder / UploadedName;
+                        }
+                        UE_LOG(LogTemp, Log, TEXT("%s uploaded successfully: %s"), *Label, *UploadedName);
+                        Callback(UploadedName, true);
                         return;
                     }
                 }
                 
-                UE_LOG(LogTemp, Warning, TEXT("Model uploaded but failed to parse response: %s"), *ResponseContent);
+                UE_LOG(LogTemp, Warning, TEXT("%s uploaded but failed to parse response: %s"), *Label, *ResponseContent);
                 Callback(TEXT(""), false);
             }
             else
             {
-                UE_LOG(LogTemp, Warning, TEXT("NetworkManager Model Upload failed: %s"), *Error.ErrorMessage);
+                // 请求失败，记录错误
+                UE_LOG(LogTemp, Warning, TEXT("NetworkManager %s Upload failed: %s"), *Label, *Error.ErrorMessage);
                 Callback(TEXT(""), false);
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, EComfyUIRequestPriority::Upload);
+}
+
+void UComfyUINetworkManager::CheckInputExists(const FString& ServerUrl, const FString& UploadedName, TFunction<void(bool bExists)> Callback)
+{
+    if (!HttpModule) HttpModule = &FHttpModule::Get();
+    
+    // 上传返回的名称可能带子目录
+    const FString Filename = FPaths::GetCleanFilename(UploadedName);
+    const FString Subfolder = FPaths::GetPath(UploadedName);
+    
+    FString ViewUrl = ServerUrl;
+    if (!ViewUrl.EndsWith(TEXT("/"))) ViewUrl += TEXT("/");
+    ViewUrl += FString::Printf(TEXT("view?filename=%s&type=input"), *FGenericPlatformHttp::UrlEncode(Filename));
+    if (!Subfolder.IsEmpty())
+    {
+        ViewUrl += FString::Printf(TEXT("&subfolder=%s"), *FGenericPlatformHttp::UrlEncode(Subfolder));
+    }
+    
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
+    Request->SetURL(ViewUrl);
+    Request->SetVerb(TEXT("HEAD"));
+    Request->SetTimeout(10.0f);
+    
+    Request->OnProcessRequestComplete().BindLambda(
+        [Callback](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
+        {
+            // 无法确认时按不存在处理，重新上传
+            Callback(bSuccess && Resp.IsValid() && EHttpResponseCodes::IsOk(Resp->GetResponseCode()));
+        }
+    );
+    ProcessRequest(Request, EComfyUIRequestPriority::Status);
 }
 
-void UComfyUINetworkManager::DownloadModel(const FString& Url, TFunction<void(const TArray<uint8>& ModelData, bool bSuccess)> Callback)
+void UComfyUINetworkManager::DownloadModel(const FString& Url, TFunction<void(const FComfyUIHttpPayload& ModelData, bool bSuccess)> Callback)
 {
     if (!HttpModule) HttpModule = &FHttpModule::Get();
     
@@ -276,10 +407,10 @@ void UComfyUINetworkManager::DownloadModel(const FString& Url, TFunction<void(co
             
             if (Error.ErrorType == EComfyUIErrorType::None)
             {
-                // 获取模型数据
-                TArray<uint8> ModelData = Resp->GetContent();
+                // 模型数据直接引用响应体
+                FComfyUIHttpPayload ModelData(Resp);
                 
-                if (ModelData.Num() > 0)
+                if (!ModelData.IsEmpty())
                 {
                     UE_LOG(LogTemp, Log, TEXT("Model downloaded successfully: %d bytes"), ModelData.Num());
                     Callback(ModelData, true);
@@ -287,29 +418,231 @@ void UComfyUINetworkManager::DownloadModel(const FString& Url, TFunction<void(co
                 else
                 {
                     UE_LOG(LogTemp, Warning, TEXT("Model download completed but no data received"));
-                    Callback(TArray<uint8>(), false);
+                    Callback(FComfyUIHttpPayload(), false);
                 }
             }
             else
             {
                 // 请求失败，记录错误
                 UE_LOG(LogTemp, Warning, TEXT("NetworkManager Model Download failed: %s"), *Error.ErrorMessage);
-                Callback(TArray<uint8>(), false);
+                Callback(FComfyUIHttpPayload(), false);
             }
         }
     );
-    Request->ProcessRequest();
+    ProcessRequest(Request, EComfyUIRequestPriority::Download);
 }
 
-#pragma optimize("", on)
-void UComfyUINetworkManager::PollQueueStatus(const FString& ServerUrl, const FString& PromptId, TFunction<void(const FString& Response, bool bSuccess)> Callback)
+void UComfyUINetworkManager::DownloadToFile(const FString& Url, const FString& DestFilePath,
+                                           TFunction<void(int64 BytesReceived, int64 BytesTotal)> OnProgress,
+                                           TFunction<void(const FString& FilePath, bool bSuccess)> Callback,
+                                           float TimeoutSeconds)
+{
+    if (!HttpModule) HttpModule = &FHttpModule::Get();
+    
+    // 先写入 Intermediate 下的部分文件，成功后再移动到目标位置；失败时保留，下次从断点继续
+    const FComfyUIPartialDownload Partial = FComfyUIPartialDownload::Find(Url, DestFilePath);
+    IFileManager::Get().MakeDirectory(*FComfyUIPartialDownload::GetPartialDirectory(), true);
+    IFileManager::Get().MakeDirectory(*FPaths::GetPath(DestFilePath), true);
+    
+    TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = HttpModule->CreateRequest();
+    Request->SetURL(Url);
+    Request->SetVerb(TEXT("GET"));
+    Request->SetTimeout(TimeoutSeconds);
+    Partial.ApplyToRequest(Request);
+    
+    if (Partial.ResumeOffset > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Resuming download of %s at %lld bytes"), *FPaths::GetCleanFilename(DestFilePath), Partial.ResumeOffset);
+    }
+    
+    // 响应体直接写入文件，不在内存中缓存；写入方式在收到响应后按状态码决定
+    TSharedRef<FComfyUIRangeFileWriter> FileWriter = MakeShared<FComfyUIRangeFileWriter>(Partial.PartFilePath, Partial.ResumeOffset);
+    FileWriter->SetRequest(Request);
+    if (!Request->SetResponseBodyReceiveStream(FileWriter))
+    {
+        UE_LOG(LogTemp, Error, TEXT("NetworkManager DownloadToFile: response streaming not supported"));
+        Callback(DestFilePath, false);
+        return;
+    }
+    
+    if (OnProgress)
+    {
+        Request->OnRequestProgress64().BindLambda(
+            [OnProgress, FileWriter](FHttpRequestPtr Req, uint64 BytesSent, uint64 BytesReceived)
+            {
+                // 续传时进度包含已下载的部分
+                const int64 StartOffset = FMath::Max<int64>(FileWriter->GetStartOffset(), 0);
+                int64 BytesTotal = -1;
+                FHttpResponsePtr Resp = Req.IsValid() ? Req->GetResponse() : nullptr;
+                if (Resp.IsValid() && Resp->GetContentLength() > 0)
+                {
+                    BytesTotal = StartOffset + Resp->GetContentLength();
+                }
+                OnProgress(StartOffset + (int64)BytesReceived, BytesTotal);
+            }
+        );
+    }
+    
+    Request->OnProcessRequestComplete().BindLambda(
+        [this, Callback, FileWriter, Partial, DestFilePath](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
+        {
+            const bool bWriteOk = FileWriter->Close();
+            const int64 PartSize = IFileManager::Get().FileSize(*Partial.PartFilePath);
+            const int32 StatusCode = Resp.IsValid() ? Resp->GetResponseCode() : 0;
+            
+            // 下次续传需要校验值，不论本次是否成功都先保存
+            Partial.SaveValidator(Resp);
+            
+            bool bComplete = false;
+            if (bSuccess && StatusCode == 416 && Partial.ResumeOffset > 0)
+            {
+                // 请求的范围超出文件末尾：部分文件已经完整，或者服务器上的文件变短了
+                int64 RangeStart = -1;
+                int64 RangeTotal = -1;
+                FComfyUIPartialDownload::ParseContentRange(Resp->GetHeader(TEXT("Content-Range")), RangeStart, RangeTotal);
+                bComplete = RangeTotal == PartSize;
+                if (!bComplete)
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("NetworkManager DownloadToFile: partial file of %s no longer matches, restarting"), *DestFilePath);
+                    Partial.Discard();
+                }
+            }
+            else
+            {
+                // 分析HTTP错误
+                FComfyUIError Error = AnalyzeHttpError(Req, Resp, bSuccess);
+                
+                if (Error.ErrorType == EComfyUIErrorType::None && bWriteOk && PartSize > 0)
+                {
+                    // 响应完整写入后文件大小应与 Content-Range 给出的总大小一致
+                    int64 RangeStart = -1;
+                    int64 RangeTotal = -1;
+                    if (StatusCode == 206 && FComfyUIPartialDownload::ParseContentRange(Resp->GetHeader(TEXT("Content-Range")), RangeStart, RangeTotal)
+                        && RangeTotal >= 0 && RangeTotal != PartSize)
+                    {
+                        UE_LOG(LogTemp, Warning, TEXT("NetworkManager DownloadToFile: size mismatch for %s (%lld of %lld bytes)"), *DestFilePath, PartSize, RangeTotal);
+                        Partial.Discard();
+                    }
+                    else
+                    {
+                        bComplete = true;
+                    }
+                }
+                else
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("NetworkManager DownloadToFile failed: %s (%lld bytes kept for resume)"), 
+                           Error.ErrorType != EComfyUIErrorType::None ? *Error.ErrorMessage : TEXT("file write error or empty body"),
+                           FMath::Max<int64>(PartSize, 0));
+                    
+                    // 不可重试的错误（例如文件已被删除）或本地写入失败时不再保留部分文件
+                    if (Error.ErrorType == EComfyUIErrorType::None ? !bWriteOk : !Error.bCanRetry)
+                    {
+                        Partial.Discard();
+                    }
+                }
+            }
+            
+            if (bComplete)
+            {
+                if (IFileManager::Get().Move(*DestFilePath, *Partial.PartFilePath, true, true))
+                {
+                    Partial.Discard();
+                    UE_LOG(LogTemp, Log, TEXT("Model downloaded to file: %s (%lld bytes)"), *DestFilePath, IFileManager::Get().FileSize(*DestFilePath));
+                    Callback(DestFilePath, true);
+                    return;
+                }
+                UE_LOG(LogTemp, Warning, TEXT("NetworkManager DownloadToFile: failed to move %s"), *Partial.PartFilePath);
+            }
+            
+            Callback(DestFilePath, false);
+        }
+    );
+    ProcessRequest(Request, EComfyUIRequestPriority::Download);
+}
+
+void UComfyUINetworkManager::PollQueueStatus(const FString& ServerUrl, const FString& PromptId, TFunction<void(const FComfyUIHttpPayload& Response, bool bSuccess)> Callback)
 {
     FString StatusUrl = ServerUrl;
     if (!StatusUrl.EndsWith(TEXT("/")))
         StatusUrl += TEXT("/");
     StatusUrl += TEXT("history/") + PromptId;
     
-    SendGetRequest(StatusUrl, Callback, 10.0f);
+    SendGetRequestRaw(StatusUrl, Callback, 10.0f);
+}
+
+void UComfyUINetworkManager::FetchQueue(const FString& ServerUrl, TFunction<void(const FString& Response, bool bSuccess)> Callback)
+{
+    FString QueueUrl = ServerUrl;
+    if (!QueueUrl.EndsWith(TEXT("/")))
+        QueueUrl += TEXT("/");
+    QueueUrl += TEXT("queue");
+    
+    SendGetRequest(QueueUrl, Callback, 10.0f);
+}
+
+void UComfyUINetworkManager::FetchHistory(const FString& ServerUrl, int32 MaxItems, TFunction<void(const FComfyUIHttpPayload& Response, bool bSuccess)> Callback)
+{
+    FString HistoryUrl = ServerUrl;
+    if (!HistoryUrl.EndsWith(TEXT("/")))
+        HistoryUrl += TEXT("/");
+    HistoryUrl += FString::Printf(TEXT("history?max_items=%d"), FMath::Max(1, MaxItems));
+    
+    SendGetRequestRaw(HistoryUrl, Callback, 10.0f);
+}
+
+void UComfyUINetworkManager::DeleteQueuedPrompts(const FString& ServerUrl, const TArray<FString>& PromptIds, TFunction<void(bool bSuccess)> Callback)
+{
+    FString QueueUrl = ServerUrl;
+    if (!QueueUrl.EndsWith(TEXT("/")))
+        QueueUrl += TEXT("/");
+    QueueUrl += TEXT("queue");
+    
+    TArray<TSharedPtr<FJsonValue>> DeleteIds;
+    for (const FString& PromptId : PromptIds)
+    {
+        DeleteIds.Add(MakeShared<FJsonValueString>(PromptId));
+    }
+    TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+    Body->SetArrayField(TEXT("delete"), DeleteIds);
+    
+    FString Payload;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Payload);
+    FJsonSerializer::Serialize(Body, Writer);
+    
+    SendRequest(QueueUrl, Payload, [Callback](const FString& Response, bool bSuccess)
+    {
+        Callback(bSuccess);
+    });
+}
+
+void UComfyUINetworkManager::InterruptPrompt(const FString& ServerUrl, const FString& PromptId, TFunction<void(bool bSuccess)> Callback)
+{
+    FString InterruptUrl = ServerUrl;
+    if (!InterruptUrl.EndsWith(TEXT("/")))
+        InterruptUrl += TEXT("/");
+    InterruptUrl += TEXT("interrupt");
+    
+    TSharedRef<FJsonObject> Body = MakeShared<FJsonObject>();
+    Body->SetStringField(TEXT("prompt_id"), PromptId);
+    
+    FString Payload;
+    TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&Payload);
+    FJsonSerializer::Serialize(Body, Writer);
+    
+    SendRequest(InterruptUrl, Payload, [Callback](const FString& Response, bool bSuccess)
+    {
+        Callback(bSuccess);
+    });
+}
+
+void UComfyUINetworkManager::FetchSystemStats(const FString& ServerUrl, TFunction<void(const FString& Response, bool bSuccess)> Callback)
+{
+    FString StatsUrl = ServerUrl;
+    if (!StatsUrl.EndsWith(TEXT("/")))
+        StatsUrl += TEXT("/");
+    StatsUrl += TEXT("system_stats");
+    
+    SendGetRequest(StatsUrl, Callback, 5.0f);
 }
 
 void UComfyUINetworkManager::TestServerConnection(const FString& ServerUrl, TFunction<void(bool bSuccess, const FString& ErrorMessage)> Callback)
@@ -369,6 +702,27 @@ void UComfyUINetworkManager::TestServerConnection(const FString& ServerUrl, TFun
     }, 5.0f);
 }
 
+namespace
+{
+    /** 错误消息中附带的响应体最多字节数 */
+    constexpr int32 MaxErrorBodyBytes = 4096;
+
+    /** 错误响应体的开头部分，用于错误消息；二进制内容不读取 */
+    FString GetErrorBodyPreview(const FHttpResponsePtr& Response)
+    {
+        const FString ContentType = Response->GetContentType();
+        if (ContentType.StartsWith(TEXT("image/")) || ContentType.StartsWith(TEXT("model/")) ||
+            ContentType.StartsWith(TEXT("application/octet-stream")))
+        {
+            return FString();
+        }
+
+        const TArray<uint8>& Content = Response->GetContent();
+        const FUTF8ToTCHAR Converted(reinterpret_cast<const ANSICHAR*>(Content.GetData()), FMath::Min(Content.Num(), MaxErrorBodyBytes));
+        return FString(Converted.Length(), Converted.Get());
+    }
+}
+
 FComfyUIError UComfyUINetworkManager::AnalyzeHttpError(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful)
 {
     if (!bWasSuccessful)
@@ -380,6 +734,14 @@ FComfyUIError UComfyUINetworkManager::AnalyzeHttpError(FHttpRequestPtr Request,
                                TEXT("检查网络连接并重试"), true);
         }
 
+        // 请求未发出：端点处于熔断冷却期
+        if (Request->GetStatus() == EHttpRequestStatus::NotStarted)
+        {
+            return FComfyUIError(EComfyUIErrorType::ServerUnavailable, 
+                               TEXT("服务器暂时不可用，请求未发出"), 0, 
+                               TEXT("服务器连续请求失败，等待其恢复后会自动重试"), true);
+        }
+
         // 检查是否超时或连接错误
         if (Request->GetStatus() == EHttpRequestStatus::Failed)
         {
@@ -411,14 +773,20 @@ FComfyUIError UComfyUINetworkManager::AnalyzeHttpError(FHttpRequestPtr Request,
     }
 
     int32 StatusCode = Response->GetResponseCode();
-    FString ResponseContent = Response->GetContentAsString();
+
+    // 成功的响应不读取响应体，图片和模型可能有几十 MB
+    if (StatusCode == 200 || StatusCode == 206)
+    {
+        return FComfyUIError(EComfyUIErrorType::None, TEXT(""));
+    }
+
+    // 错误响应只读取开头一段作为错误消息
+    const FString ResponseContent = GetErrorBodyPreview(Response);
 
     // 分析HTTP状态码
     switch (StatusCode)
     {
-        case 200: // 成功
-            return FComfyUIError(EComfyUIErrorType::None, TEXT(""));
-            
+
         case 400: // 错误请求
             return FComfyUIError(EComfyUIErrorType::InvalidWorkflow, 
                                FString::Printf(TEXT("请求格式错误 (400): %s"), *ResponseContent), StatusCode,
@@ -435,9 +803,13 @@ FComfyUIError UComfyUINetworkManager::AnalyzeHttpError(FHttpRequestPtr Request,
                                TEXT("检查API端点URL是否正确"), false);
             
         case 429: // 请求过多
-            return FComfyUIError(EComfyUIErrorType::ServerUnavailable, 
+        {
+            FComfyUIError Error(EComfyUIErrorType::ServerUnavailable, 
                                TEXT("请求过于频繁 (429)"), StatusCode,
                                TEXT("请稍后再试，或联系服务器管理员"), true);
+            Error.RetryAfterSeconds = (float)FComfyUICircuitBreaker::ParseRetryAfter(Response);
+            return Error;
+        }
             
         case 500: // 服务器内部错误
             return FComfyUIError(EComfyUIErrorType::ServerError, 
@@ -447,9 +819,13 @@ FComfyUIError UComfyUINetworkManager::AnalyzeHttpError(FHttpRequestPtr Request,
         case 502: // 错误网关
         case 503: // 服务不可用
         case 504: // 网关超时
-            return FComfyUIError(EComfyUIErrorType::ServerUnavailable, 
+        {
+            FComfyUIError Error(EComfyUIErrorType::ServerUnavailable, 
                                FString::Printf(TEXT("服务器暂时不可用 (%d)"), StatusCode), StatusCode,
                                TEXT("服务器暂时不可用，请稍后重试"), true);
+            Error.RetryAfterSeconds = (float)FComfyUICircuitBreaker::ParseRetryAfter(Response);
+            return Error;
+        }
                                
         default:
             if (StatusCode >= 400 && StatusCode < 500)
@@ -0,0 +1,197 @@
+#include "Network/ComfyUIRangeDownload.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+FString FComfyUIPartialDownload::GetPartialDirectory()
+{
+    return FPaths::ProjectIntermediateDir() / TEXT("ComfyUI") / TEXT("Downloads");
+}
+
+FComfyUIPartialDownload FComfyUIPartialDownload::Find(const FString& Url, const FString& DestFilePath)
+{
+    // 同一输出的重试使用相同的 URL 和目标路径，按两者的哈希定位部分文件
+    FComfyUIPartialDownload Partial;
+    const uint32 Key = FCrc::StrCrc32(*(Url + TEXT("|") + DestFilePath));
+    Partial.PartFilePath = GetPartialDirectory() / FString::Printf(TEXT("%08x_%s.part"), Key, *FPaths::GetCleanFilename(DestFilePath));
+
+    const int64 ExistingSize = IFileManager::Get().FileSize(*Partial.PartFilePath);
+    if (ExistingSize > 0)
+    {
+        Partial.ResumeOffset = ExistingSize;
+        FFileHelper::LoadFileToString(Partial.Validator, *(Partial.PartFilePath + TEXT(".meta")));
+        Partial.Validator.TrimStartAndEndInline();
+    }
+    return Partial;
+}
+
+void FComfyUIPartialDownload::ApplyToRequest(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request) const
+{
+    if (ResumeOffset <= 0)
+    {
+        return;
+    }
+
+    Request->SetHeader(TEXT("Range"), FString::Printf(TEXT("bytes=%lld-"), ResumeOffset));
+    if (!Validator.IsEmpty())
+    {
+        Request->SetHeader(TEXT("If-Range"), Validator);
+    }
+}
+
+void FComfyUIPartialDownload::SaveValidator(FHttpResponsePtr Response) const
+{
+    if (!Response.IsValid())
+    {
+        return;
+    }
+
+    // If-Range 只接受强 ETag，弱 ETag 时退回 Last-Modified
+    FString NewValidator = Response->GetHeader(TEXT("ETag")).TrimStartAndEnd();
+    if (NewValidator.IsEmpty() || NewValidator.StartsWith(TEXT("W/")))
+    {
+        NewValidator = Response->GetHeader(TEXT("Last-Modified")).TrimStartAndEnd();
+    }
+    if (!NewValidator.IsEmpty() && NewValidator != Validator)
+    {
+        FFileHelper::SaveStringToFile(NewValidator, *(PartFilePath + TEXT(".meta")));
+    }
+}
+
+void FComfyUIPartialDownload::Discard() const
+{
+    IFileManager::Get().Delete(*PartFilePath, false, false, true);
+    IFileManager::Get().Delete(*(PartFilePath + TEXT(".meta")), false, false, true);
+}
+
+bool FComfyUIPartialDownload::ParseContentRange(const FString& Header, int64& OutStart, int64& OutTotal)
+{
+    OutStart = -1;
+    OutTotal = -1;
+
+    FString Range = Header.TrimStartAndEnd();
+    if (!Range.RemoveFromStart(TEXT("bytes "), ESearchCase::IgnoreCase))
+    {
+        return false;
+    }
+
+    FString Span;
+    FString Total;
+    if (!Range.Split(TEXT("/"), &Span, &Total))
+    {
+        return false;
+    }
+
+    if (Total.IsNumeric())
+    {
+        OutTotal = FCString::Atoi64(*Total);
+    }
+
+    FString First;
+    FString Last;
+    if (Span.Split(TEXT("-"), &First, &Last) && First.IsNumeric())
+    {
+        OutStart = FCString::Atoi64(*First);
+    }
+    return OutStart >= 0 || OutTotal >= 0;
+}
+
+FComfyUIRangeFileWriter::FComfyUIRangeFileWriter(const FString& InFilePath, int64 InResumeOffset)
+    : FilePath(InFilePath)
+    , ResumeOffset(InResumeOffset)
+{
+    SetIsSaving(true);
+    SetIsPersistent(false);
+}
+
+FComfyUIRangeFileWriter::~FComfyUIRangeFileWriter()
+{
+    Close();
+}
+
+void FComfyUIRangeFileWriter::OpenForResponse()
+{
+    bOpened = true;
+
+    int32 StatusCode = 0;
+    FString ContentRange;
+    if (TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> PinnedRequest = Request.Pin())
+    {
+        if (FHttpResponsePtr Response = PinnedRequest->GetResponse())
+        {
+            StatusCode = Response->GetResponseCode();
+            ContentRange = Response->GetHeader(TEXT("Content-Range"));
+        }
+    }
+
+    if (StatusCode == 206 && ResumeOffset > 0)
+    {
+        int64 RangeStart = -1;
+        int64 RangeTotal = -1;
+        FComfyUIPartialDownload::ParseContentRange(ContentRange, RangeStart, RangeTotal);
+        if (RangeStart == ResumeOffset)
+        {
+            FileWriter.Reset(IFileManager::Get().CreateFileWriter(*FilePath, FILEWRITE_Append));
+            StartOffset = ResumeOffset;
+        }
+        else
+        {
+            // 服务器返回的范围与本地不一致，无法拼接
+            UE_LOG(LogTemp, Warning, TEXT("RangeDownload: unexpected Content-Range '%s' for offset %lld"), *ContentRange, ResumeOffset);
+            bDiscardBody = true;
+            SetError();
+        }
+    }
+    else if (StatusCode >= 200 && StatusCode < 300)
+    {
+        // 服务器忽略了 Range 或文件已变化（If-Range 不匹配），从头写入
+        FileWriter.Reset(IFileManager::Get().CreateFileWriter(*FilePath));
+        StartOffset = 0;
+    }
+    else
+    {
+        // 错误响应的内容不写入部分文件
+        bDiscardBody = true;
+    }
+
+    if (!bDiscardBody && !FileWriter.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("RangeDownload: cannot open %s"), *FilePath);
+        bDiscardBody = true;
+        SetError();
+    }
+}
+
+void FComfyUIRangeFileWriter::Serialize(void* Data, int64 Length)
+{
+    if (!bOpened)
+    {
+        OpenForResponse();
+    }
+
+    Position += Length;
+    if (bDiscardBody)
+    {
+        return;
+    }
+
+    FileWriter->Serialize(Data, Length);
+    if (FileWriter->IsError())
+    {
+        SetError();
+    }
+}
+
+bool FComfyUIRangeFileWriter::Close()
+{
+    if (FileWriter.IsValid())
+    {
+        const bool bClosed = FileWriter->Close();
+        FileWriter.Reset();
+        if (!bClosed)
+        {
+            SetError();
+        }
+    }
+    return !IsError();
+}
@@ -0,0 +1,228 @@
+#include "Network/ComfyUIRequestScheduler.h"
+#include "Interfaces/IHttpResponse.h"
+#include "Containers/Ticker.h"
+
+FString FComfyUIRequestScheduler::GetHostKey(const FString& Url)
+{
+    const int32 SchemeEnd = Url.Find(TEXT("://"));
+    const int32 HostStart = SchemeEnd == INDEX_NONE ? 0 : SchemeEnd + 3;
+
+    int32 HostEnd = Url.Len();
+    for (int32 Index = HostStart; Index < Url.Len(); ++Index)
+    {
+        const TCHAR Char = Url[Index];
+        if (Char == TEXT('/') || Char == TEXT('?') || Char == TEXT('#'))
+        {
+            HostEnd = Index;
+            break;
+        }
+    }
+    return Url.Left(HostEnd).ToLower();
+}
+
+void FComfyUIRequestScheduler::Enqueue(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request, EComfyUIRequestPriority Priority)
+{
+    const FString HostKey = GetHostKey(Request->GetURL());
+    FHostState& Host = Hosts.FindOrAdd(HostKey);
+
+    Host.Queues[(int32)Priority].Add({ Request, Priority, FPlatformTime::Seconds() });
+    Host.Stats.Queued[(int32)Priority]++;
+    Host.Stats.PeakQueueDepth = FMath::Max(Host.Stats.PeakQueueDepth, Host.Stats.GetQueueDepth());
+
+    Pump(HostKey);
+}
+
+int32 FComfyUIRequestScheduler::PickQueue(const FHostState& Host, double Now) const
+{
+    int32 FirstReady = INDEX_NONE;
+    int32 OldestStarved = INDEX_NONE;
+    double OldestStarvedTime = TNumericLimits<double>::Max();
+
+    for (int32 Index = 0; Index < (int32)EComfyUIRequestPriority::Count; ++Index)
+    {
+        const TArray<FQueuedRequest>& Queue = Host.Queues[Index];
+        if (Queue.Num() == 0)
+        {
+            continue;
+        }
+
+        // 下载和上传的名额用完时只能发出提交和状态请求
+        if (IsBulk((EComfyUIRequestPriority)Index) && Host.Stats.BulkInFlight >= MaxBulkPerHost)
+        {
+            continue;
+        }
+
+        if (FirstReady == INDEX_NONE)
+        {
+            FirstReady = Index;
+        }
+
+        const double EnqueueTime = Queue[0].EnqueueTime;
+        if (Now - EnqueueTime >= StarvationSeconds && EnqueueTime < OldestStarvedTime)
+        {
+            OldestStarved = Index;
+            OldestStarvedTime = EnqueueTime;
+        }
+    }
+
+    return OldestStarved != INDEX_NONE ? OldestStarved : FirstReady;
+}
+
+void FComfyUIRequestScheduler::Pump(const FString& HostKey)
+{
+    FHostState* Host = Hosts.Find(HostKey);
+    if (!Host)
+    {
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    while (Host->Stats.InFlight < MaxConcurrentPerHost)
+    {
+        const int32 QueueIndex = PickQueue(*Host, Now);
+        if (QueueIndex == INDEX_NONE)
+        {
+            break;
+        }
+
+        // 每个队列内按先进先出
+        FQueuedRequest Item = Host->Queues[QueueIndex][0];
+        Host->Queues[QueueIndex].RemoveAt(0);
+        Host->Stats.Queued[QueueIndex]--;
+
+        Dispatch(HostKey, *Host, MoveTemp(Item), Now);
+
+        // Dispatch 中请求可能同步完成并修改 Hosts
+        Host = Hosts.Find(HostKey);
+        if (!Host)
+        {
+            return;
+        }
+    }
+}
+
+void FComfyUIRequestScheduler::Dispatch(const FString& HostKey, FHostState& Host, FQueuedRequest&& Item, double Now)
+{
+    const EComfyUIRequestPriority Priority = Item.Priority;
+
+    Host.Stats.InFlight++;
+    if (IsBulk(Priority))
+    {
+        Host.Stats.BulkInFlight++;
+    }
+    Host.Stats.TotalDispatched++;
+
+    const double WaitSeconds = Now - Item.EnqueueTime;
+    Host.Stats.AverageWaitSeconds = Host.Stats.TotalDispatched == 1
+        ? WaitSeconds
+        : Host.Stats.AverageWaitSeconds * 0.9 + WaitSeconds * 0.1;
+
+    if (WaitSeconds > 1.0)
+    {
+        UE_LOG(LogTemp, Verbose, TEXT("RequestScheduler: %s waited %.2fs (priority %d, queue depth %d)"),
+               *Item.Request->GetURL(), WaitSeconds, (int32)Priority, Host.Stats.GetQueueDepth());
+    }
+
+    // 包装完成回调：先释放名额，再执行原回调，最后发出排队中的请求
+    FHttpRequestCompleteDelegate OriginalCallback = Item.Request->OnProcessRequestComplete();
+    TSharedRef<bool> bReleased = MakeShared<bool>(false);
+    TWeakPtr<FComfyUIRequestScheduler> WeakThis = AsShared();
+
+    Item.Request->OnProcessRequestComplete().BindLambda(
+        [WeakThis, HostKey, Priority, OriginalCallback, bReleased](FHttpRequestPtr Req, FHttpResponsePtr Resp, bool bSuccess)
+        {
+            TSharedPtr<FComfyUIRequestScheduler> Scheduler = WeakThis.Pin();
+            if (Scheduler.IsValid() && !*bReleased)
+            {
+                *bReleased = true;
+                Scheduler->OnRequestFinished(HostKey, Priority);
+            }
+
+            OriginalCallback.ExecuteIfBound(Req, Resp, bSuccess);
+
+            if (Scheduler.IsValid())
+            {
+                Scheduler->Pump(HostKey);
+            }
+        }
+    );
+
+    if (!Item.Request->ProcessRequest() && !*bReleased)
+    {
+        // 请求未能发出，也不会再触发完成回调：释放名额，下一帧以失败结束，调用方的错误和重试流程照常执行
+        // （不在 Pump 的循环内直接回调，避免重入）
+        *bReleased = true;
+        OnRequestFinished(HostKey, Priority);
+
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request = Item.Request;
+        FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda(
+            [Request](float DeltaTime)
+            {
+                Request->OnProcessRequestComplete().ExecuteIfBound(Request, nullptr, false);
+                return false;
+            }));
+    }
+}
+
+void FComfyUIRequestScheduler::OnRequestFinished(const FString& HostKey, EComfyUIRequestPriority Priority)
+{
+    if (FHostState* Host = Hosts.Find(HostKey))
+    {
+        Host->Stats.InFlight = FMath::Max(0, Host->Stats.InFlight - 1);
+        if (IsBulk(Priority))
+        {
+            Host->Stats.BulkInFlight = FMath::Max(0, Host->Stats.BulkInFlight - 1);
+        }
+    }
+}
+
+FComfyUIRequestSchedulerStats FComfyUIRequestScheduler::GetStats(const FString& Url) const
+{
+    const FHostState* Host = Hosts.Find(GetHostKey(Url));
+    return Host ? Host->Stats : FComfyUIRequestSchedulerStats();
+}
+
+int32 FComfyUIRequestScheduler::GetTotalQueueDepth() const
+{
+    int32 Depth = 0;
+    for (const TPair<FString, FHostState>& Pair : Hosts)
+    {
+        Depth += Pair.Value.Stats.GetQueueDepth();
+    }
+    return Depth;
+}
+
+bool FComfyUIRequestScheduler::Remove(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request)
+{
+    FHostState* Host = Hosts.Find(GetHostKey(Request->GetURL()));
+    if (!Host)
+    {
+        return false;
+    }
+
+    for (int32 Index = 0; Index < (int32)EComfyUIRequestPriority::Count; ++Index)
+    {
+        const int32 NumRemoved = Host->Queues[Index].RemoveAll([&Request](const FQueuedRequest& Item)
+        {
+            return Item.Request == Request;
+        });
+        if (NumRemoved > 0)
+        {
+            Host->Stats.Queued[Index] -= NumRemoved;
+            return true;
+        }
+    }
+    return false;
+}
+
+void FComfyUIRequestScheduler::Reset()
+{
+    for (TPair<FString, FHostState>& Pair : Hosts)
+    {
+        for (TArray<FQueuedRequest>& Queue : Pair.Value.Queues)
+        {
+            Queue.Reset();
+        }
+        FMemory::Memzero(Pair.Value.Stats.Queued);
+    }
+}
@@ -0,0 +1,336 @@
+#include "Network/ComfyUIServerPool.h"
+#include "Network/ComfyUINetworkManager.h"
+#include "Network/ComfyUIStatusEngine.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FComfyUIServerPool::FComfyUIServerPool(UComfyUINetworkManager* InNetworkManager)
+    : NetworkManager(InNetworkManager)
+{
+}
+
+FString FComfyUIServerPool::NormalizeUrl(const FString& Url)
+{
+    FString Result = Url.TrimStartAndEnd();
+    while (Result.RemoveFromEnd(TEXT("/")))
+    {
+    }
+    return Result;
+}
+
+void FComfyUIServerPool::SetServers(const TArray<FString>& Urls)
+{
+    TArray<FString> NewUrls;
+    for (const FString& Url : Urls)
+    {
+        const FString Normalized = NormalizeUrl(Url);
+        if (!Normalized.IsEmpty())
+        {
+            NewUrls.AddUnique(Normalized);
+        }
+    }
+
+    TArray<FString> OldUrls;
+    for (const FComfyUIServerStatus& Server : Servers)
+    {
+        OldUrls.Add(Server.Url);
+    }
+    if (OldUrls == NewUrls)
+    {
+        return;
+    }
+
+    Servers.Reset();
+    for (const FString& Url : NewUrls)
+    {
+        FComfyUIServerStatus& Server = Servers.AddDefaulted_GetRef();
+        Server.Url = Url;
+    }
+    LastRefreshTime = -1.0;
+}
+
+FString FComfyUIServerPool::GetPrimaryServer() const
+{
+    return Servers.Num() > 0 ? Servers[0].Url : FString();
+}
+
+FComfyUIServerStatus* FComfyUIServerPool::FindServer(const FString& Url)
+{
+    const FString Normalized = NormalizeUrl(Url);
+    return Servers.FindByPredicate([&Normalized](const FComfyUIServerStatus& Server)
+    {
+        return Server.Url == Normalized;
+    });
+}
+
+bool FComfyUIServerPool::IsBetterCandidate(const FComfyUIServerStatus& A, const FComfyUIServerStatus& B) const
+{
+    if (Policy == EComfyUIServerSelectionPolicy::MostFreeVram && A.VramFree != B.VramFree)
+    {
+        return A.VramFree > B.VramFree;
+    }
+
+    if (A.GetEffectiveQueue() != B.GetEffectiveQueue())
+    {
+        return A.GetEffectiveQueue() < B.GetEffectiveQueue();
+    }
+    return A.VramFree > B.VramFree;
+}
+
+FString FComfyUIServerPool::PickServer()
+{
+    if (Servers.Num() == 0)
+    {
+        return FString();
+    }
+
+    RefreshIfStale();
+
+    if (Servers.Num() == 1)
+    {
+        Servers[0].AssignedSinceCheck++;
+        return Servers[0].Url;
+    }
+
+    // 优先在可用的服务器中选择；全部不可用时仍然选一台，让错误按正常流程报告
+    FComfyUIServerStatus* Best = nullptr;
+    for (FComfyUIServerStatus& Server : Servers)
+    {
+        if (Server.bHealthy && (!Best || IsBetterCandidate(Server, *Best)))
+        {
+            Best = &Server;
+        }
+    }
+    if (!Best)
+    {
+        for (FComfyUIServerStatus& Server : Servers)
+        {
+            if (!Best || Server.ConsecutiveFailures < Best->ConsecutiveFailures)
+            {
+                Best = &Server;
+            }
+        }
+    }
+
+    Best->AssignedSinceCheck++;
+    UE_LOG(LogTemp, Log, TEXT("ServerPool: assigned job to %s (queue %d, vram free %lld)"),
+           *Best->Url, Best->GetEffectiveQueue(), Best->VramFree);
+    return Best->Url;
+}
+
+void FComfyUIServerPool::ReportFailure(const FString& Url)
+{
+    if (FComfyUIServerStatus* Server = FindServer(Url))
+    {
+        Server->bHealthy = false;
+        Server->ConsecutiveFailures++;
+        Server->LastCheckTime = 0.0;
+    }
+}
+
+void FComfyUIServerPool::Invalidate(const FString& Url)
+{
+    if (FComfyUIServerStatus* Server = FindServer(Url))
+    {
+        Server->LastCheckTime = 0.0;
+    }
+}
+
+bool FComfyUIServerPool::IsHealthyFresh(const FString& Url) const
+{
+    const FString Normalized = NormalizeUrl(Url);
+    const FComfyUIServerStatus* Server = Servers.FindByPredicate([&Normalized](const FComfyUIServerStatus& Status)
+    {
+        return Status.Url == Normalized;
+    });
+    return Server && Server->bChecked && Server->bHealthy && Server->LastCheckTime > 0.0 &&
+           FPlatformTime::Seconds() - Server->LastCheckTime <= HealthSnapshotTTL;
+}
+
+bool FComfyUIServerPool::HasFreshHealthyServer() const
+{
+    for (const FComfyUIServerStatus& Server : Servers)
+    {
+        if (IsHealthyFresh(Server.Url))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FComfyUIServerPool::UpdateQueue(const FString& Url, const FComfyUIQueueSnapshot& Snapshot)
+{
+    if (FComfyUIServerStatus* Server = FindServer(Url))
+    {
+        Server->QueueRunning = Snapshot.RunningCount;
+        Server->QueuePending = Snapshot.PendingCount;
+        Server->AssignedSinceCheck = 0;
+        Server->bHealthy = true;
+        Server->bChecked = true;
+        Server->ConsecutiveFailures = 0;
+        Server->LastCheckTime = FPlatformTime::Seconds();
+    }
+}
+
+void FComfyUIServerPool::RefreshIfStale()
+{
+    if (PendingChecks == 0 && (LastRefreshTime < 0.0 || FPlatformTime::Seconds() - LastRefreshTime >= HealthCheckInterval))
+    {
+        RefreshHealth();
+    }
+}
+
+void FComfyUIServerPool::RefreshHealth(TFunction<void()> OnComplete)
+{
+    if (OnComplete)
+    {
+        RefreshCallbacks.Add(MoveTemp(OnComplete));
+    }
+
+    // 上一轮检查尚未结束时等待它完成
+    if (PendingChecks > 0)
+    {
+        return;
+    }
+
+    if (Servers.Num() == 0 || !NetworkManager.IsValid())
+    {
+        TArray<TFunction<void()>> Callbacks = MoveTemp(RefreshCallbacks);
+        for (TFunction<void()>& Callback : Callbacks)
+        {
+            Callback();
+        }
+        return;
+    }
+
+    LastRefreshTime = FPlatformTime::Seconds();
+    PendingChecks = Servers.Num();
+
+    TArray<FString> Urls;
+    for (const FComfyUIServerStatus& Server : Servers)
+    {
+        Urls.Add(Server.Url);
+    }
+    for (const FString& Url : Urls)
+    {
+        CheckServer(Url);
+    }
+}
+
+void FComfyUIServerPool::CheckServer(const FString& Url)
+{
+    TWeakPtr<FComfyUIServerPool> WeakThis = AsShared();
+
+    // 先查 /system_stats（显存），再查 /queue（负载）
+    NetworkManager->FetchSystemStats(Url, [WeakThis, Url](const FString& StatsResponse, bool bStatsSuccess)
+    {
+        TSharedPtr<FComfyUIServerPool> Pool = WeakThis.Pin();
+        if (!Pool.IsValid())
+        {
+            return;
+        }
+
+        FComfyUIServerStatus* Server = Pool->FindServer(Url);
+        if (!bStatsSuccess || !Server || !Pool->NetworkManager.IsValid())
+        {
+            Pool->OnServerChecked(Url, false);
+            return;
+        }
+        ParseSystemStats(StatsResponse, *Server);
+
+        Pool->NetworkManager->FetchQueue(Url, [WeakThis, Url](const FString& QueueResponse, bool bQueueSuccess)
+        {
+            TSharedPtr<FComfyUIServerPool> InnerPool = WeakThis.Pin();
+            if (!InnerPool.IsValid())
+            {
+                return;
+            }
+
+            FComfyUIQueueSnapshot Snapshot;
+            const bool bHealthy = bQueueSuccess && FComfyUIStatusEngine::ParseQueueSnapshot(QueueResponse, Snapshot);
+            if (bHealthy)
+            {
+                InnerPool->UpdateQueue(Url, Snapshot);
+            }
+            InnerPool->OnServerChecked(Url, bHealthy);
+        });
+    });
+}
+
+void FComfyUIServerPool::OnServerChecked(const FString& Url, bool bHealthy)
+{
+    if (FComfyUIServerStatus* Server = FindServer(Url))
+    {
+        Server->bChecked = true;
+        if (!bHealthy)
+        {
+            if (Server->bHealthy)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("ServerPool: %s is not responding"), *Url);
+            }
+            Server->bHealthy = false;
+            Server->ConsecutiveFailures++;
+            Server->LastCheckTime = 0.0;
+        }
+    }
+
+    PendingChecks = FMath::Max(0, PendingChecks - 1);
+    if (PendingChecks == 0)
+    {
+        TArray<TFunction<void()>> Callbacks = MoveTemp(RefreshCallbacks);
+        for (TFunction<void()>& Callback : Callbacks)
+        {
+            Callback();
+        }
+    }
+}
+
+bool FComfyUIServerPool::ParseSystemStats(const FString& ResponseContent, FComfyUIServerStatus& OutStatus)
+{
+    TSharedPtr<FJsonObject> JsonObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
+    if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+    {
+        return false;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* Devices = nullptr;
+    if (!JsonObject->TryGetArrayField(TEXT("devices"), Devices) || !Devices || Devices->Num() == 0)
+    {
+        return false;
+    }
+
+    const TSharedPtr<FJsonObject>* System = nullptr;
+    if (JsonObject->TryGetObjectField(TEXT("system"), System) && System)
+    {
+        (*System)->TryGetStringField(TEXT("comfyui_version"), OutStatus.ComfyUIVersion);
+    }
+
+    // 多卡服务器按所有设备合计
+    int64 TotalFree = 0;
+    int64 TotalVram = 0;
+    for (const TSharedPtr<FJsonValue>& DeviceValue : *Devices)
+    {
+        const TSharedPtr<FJsonObject>* Device = nullptr;
+        if (DeviceValue.IsValid() && DeviceValue->TryGetObject(Device) && Device)
+        {
+            int64 Free = 0;
+            int64 Total = 0;
+            (*Device)->TryGetNumberField(TEXT("vram_free"), Free);
+            (*Device)->TryGetNumberField(TEXT("vram_total"), Total);
+            TotalFree += Free;
+            TotalVram += Total;
+
+            if (OutStatus.DeviceName.IsEmpty())
+            {
+                (*Device)->TryGetStringField(TEXT("name"), OutStatus.DeviceName);
+            }
+        }
+    }
+
+    OutStatus.VramFree = TotalFree;
+    OutStatus.VramTotal = TotalVram;
+    return true;
+}
@@ -0,0 +1,223 @@
+#include "Network/ComfyUIStatusEngine.h"
+#include "Network/ComfyUINetworkManager.h"
+#include "Client/ComfyUIGameThreadDispatcher.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+const FComfyUIHistoryEntry* FComfyUIStatusBatch::FindHistoryEntry(const FString& PromptId) const
+{
+    return PromptId.IsEmpty() ? nullptr : History.Find(PromptId);
+}
+
+FComfyUIStatusEngine::FComfyUIStatusEngine(UComfyUINetworkManager* InNetworkManager)
+    : NetworkManager(InNetworkManager)
+{
+}
+
+bool FComfyUIStatusEngine::RunCycle(const FString& ServerUrl, int32 HistoryWindow, const FOnComfyUIStatusBatch& OnComplete)
+{
+    if (bCycleInFlight || !NetworkManager.IsValid())
+    {
+        return false;
+    }
+
+    bCycleInFlight = true;
+    CycleServerUrl = ServerUrl;
+    PendingBatch = FComfyUIStatusBatch();
+    PendingBatch.HistoryWindow = HistoryWindow;
+    PendingCallback = OnComplete;
+
+    TWeakPtr<FComfyUIStatusEngine> WeakThis = AsShared();
+    NetworkManager->FetchQueue(ServerUrl, [WeakThis](const FString& Response, bool bSuccess)
+    {
+        if (TSharedPtr<FComfyUIStatusEngine> Engine = WeakThis.Pin())
+        {
+            Engine->OnQueueFetched(Response, bSuccess);
+        }
+    });
+    return true;
+}
+
+void FComfyUIStatusEngine::OnQueueFetched(const FString& ResponseContent, bool bSuccess)
+{
+    if (!bSuccess)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ComfyUI status: failed to fetch queue from %s"), *CycleServerUrl);
+        CompleteCycle(false);
+        return;
+    }
+
+    // 在工作线程解析，游戏线程只接收结果
+    struct FParseResult
+    {
+        FString Content;
+        FComfyUIQueueSnapshot Snapshot;
+        bool bParsed = false;
+    };
+    TSharedRef<FParseResult> Result = MakeShared<FParseResult>();
+    Result->Content = ResponseContent;
+
+    TWeakPtr<FComfyUIStatusEngine> WeakThis = AsShared();
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [Result]()
+        {
+            Result->bParsed = ParseQueueSnapshot(Result->Content, Result->Snapshot);
+        },
+        [WeakThis, Result]()
+        {
+            if (TSharedPtr<FComfyUIStatusEngine> Engine = WeakThis.Pin())
+            {
+                Engine->OnQueueParsed(MoveTemp(Result->Snapshot), Result->bParsed);
+            }
+        });
+}
+
+void FComfyUIStatusEngine::OnQueueParsed(FComfyUIQueueSnapshot&& Snapshot, bool bParsed)
+{
+    if (!bParsed)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ComfyUI status: failed to parse queue from %s"), *CycleServerUrl);
+        CompleteCycle(false);
+        return;
+    }
+    PendingBatch.Queue = MoveTemp(Snapshot);
+
+    if (!NetworkManager.IsValid())
+    {
+        CompleteCycle(false);
+        return;
+    }
+
+    TWeakPtr<FComfyUIStatusEngine> WeakThis = AsShared();
+    NetworkManager->FetchHistory(CycleServerUrl, PendingBatch.HistoryWindow, [WeakThis](const FComfyUIHttpPayload& Response, bool bHistorySuccess)
+    {
+        if (TSharedPtr<FComfyUIStatusEngine> Engine = WeakThis.Pin())
+        {
+            Engine->OnHistoryFetched(Response, bHistorySuccess);
+        }
+    });
+}
+
+void FComfyUIStatusEngine::OnHistoryFetched(const FComfyUIHttpPayload& ResponseContent, bool bSuccess)
+{
+    if (!bSuccess)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ComfyUI status: failed to fetch history from %s"), *CycleServerUrl);
+        CompleteCycle(false);
+        return;
+    }
+
+    // 历史记录可能有几 MB，在工作线程直接扫描 UTF-8 字节，只提取状态和输出
+    struct FParseResult
+    {
+        FComfyUIHttpPayload Content;
+        TMap<FString, FComfyUIHistoryEntry> History;
+        bool bParsed = false;
+    };
+    TSharedRef<FParseResult> Result = MakeShared<FParseResult>();
+    Result->Content = ResponseContent;
+
+    TWeakPtr<FComfyUIStatusEngine> WeakThis = AsShared();
+    FComfyUIGameThreadDispatcher::RunAsync(
+        [Result]()
+        {
+            Result->bParsed = FComfyUIHistoryScanner::Scan(Result->Content.GetView(), Result->History);
+            Result->Content.Reset();
+        },
+        [WeakThis, Result]()
+        {
+            TSharedPtr<FComfyUIStatusEngine> Engine = WeakThis.Pin();
+            if (!Engine.IsValid())
+            {
+                return;
+            }
+
+            if (!Result->bParsed)
+            {
+                UE_LOG(LogTemp, Warning, TEXT("ComfyUI status: failed to parse history from %s"), *Engine->CycleServerUrl);
+                Engine->CompleteCycle(false);
+                return;
+            }
+
+            Engine->PendingBatch.History = MoveTemp(Result->History);
+            Engine->CompleteCycle(true);
+        });
+}
+
+void FComfyUIStatusEngine::CompleteCycle(bool bSuccess)
+{
+    // 先复位状态，回调里可以立即发起下一轮
+    FComfyUIStatusBatch Batch = MoveTemp(PendingBatch);
+    FOnComfyUIStatusBatch Callback = PendingCallback;
+    PendingBatch = FComfyUIStatusBatch();
+    PendingCallback.Unbind();
+    bCycleInFlight = false;
+
+    UE_LOG(LogTemp, VeryVerbose, TEXT("ComfyUI status cycle done: running=%d pending=%d success=%d"),
+           Batch.Queue.RunningCount, Batch.Queue.PendingCount, bSuccess ? 1 : 0);
+
+    Callback.ExecuteIfBound(Batch, bSuccess);
+}
+
+bool FComfyUIStatusEngine::ParseQueueSnapshot(const FString& ResponseContent, FComfyUIQueueSnapshot& OutSnapshot)
+{
+    TSharedPtr<FJsonObject> JsonObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(ResponseContent);
+    if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+    {
+        return false;
+    }
+
+    OutSnapshot = FComfyUIQueueSnapshot();
+
+    auto ReadQueue = [&OutSnapshot](const TArray<TSharedPtr<FJsonValue>>& Items, bool bRunning)
+    {
+        int32 Count = 0;
+        for (const TSharedPtr<FJsonValue>& Item : Items)
+        {
+            const TArray<TSharedPtr<FJsonValue>>* Fields = nullptr;
+            if (!Item.IsValid() || !Item->TryGetArray(Fields) || !Fields || Fields->Num() < 2)
+            {
+                continue;
+            }
+
+            FString PromptId;
+            if (!(*Fields)[1]->TryGetString(PromptId) || PromptId.IsEmpty())
+            {
+                continue;
+            }
+
+            // 队列位置从1开始，0表示正在执行
+            ++Count;
+            OutSnapshot.Positions.Add(PromptId, bRunning ? 0 : Count);
+        }
+        return Count;
+    };
+
+    const TArray<TSharedPtr<FJsonValue>>* RunningArray = nullptr;
+    if (JsonObject->TryGetArrayField(TEXT("queue_running"), RunningArray) && RunningArray)
+    {
+        OutSnapshot.RunningCount = ReadQueue(*RunningArray, true);
+    }
+
+    // 等待队列按 number 排序返回
+    const TArray<TSharedPtr<FJsonValue>>* PendingArray = nullptr;
+    if (JsonObject->TryGetArrayField(TEXT("queue_pending"), PendingArray) && PendingArray)
+    {
+        TArray<TSharedPtr<FJsonValue>> SortedPending = *PendingArray;
+        SortedPending.StableSort([](const TSharedPtr<FJsonValue>& A, const TSharedPtr<FJsonValue>& B)
+        {
+            const TArray<TSharedPtr<FJsonValue>>* FieldsA = nullptr;
+            const TArray<TSharedPtr<FJsonValue>>* FieldsB = nullptr;
+            double NumberA = 0.0;
+            double NumberB = 0.0;
+            if (A.IsValid() && A->TryGetArray(FieldsA) && FieldsA && FieldsA->Num() > 0) (*FieldsA)[0]->TryGetNumber(NumberA);
+            if (B.IsValid() && B->TryGetArray(FieldsB) && FieldsB && FieldsB->Num() > 0) (*FieldsB)[0]->TryGetNumber(NumberB);
+            return NumberA < NumberB;
+        });
+        OutSnapshot.PendingCount = ReadQueue(SortedPending, false);
+    }
+
+    return true;
+}
@@ -0,0 +1,274 @@
+#include "Network/ComfyUIUploadCache.h"
+#include "Utils/ComfyUIFileManager.h"
+#include "Hash/xxhash.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+namespace
+{
+    /** 缓存文件格式版本，格式变化时旧文件直接丢弃 */
+    constexpr int32 UploadCacheVersion = 1;
+
+    /** 计算文件哈希时每次读取的块大小 */
+    constexpr int64 HashChunkSize = 1024 * 1024;
+
+    FString FormatHash(const FXxHash64& Hash)
+    {
+        return FString::Printf(TEXT("%016llx"), Hash.Hash);
+    }
+}
+
+FComfyUIUploadCache::FComfyUIUploadCache(const FString& InCacheFilePath)
+    : CacheFilePath(InCacheFilePath)
+{
+}
+
+FString FComfyUIUploadCache::HashData(const TArray<uint8>& Data)
+{
+    return FormatHash(FXxHash64::HashBuffer(Data.GetData(), Data.Num()));
+}
+
+FString FComfyUIUploadCache::HashFile(const FString& FilePath)
+{
+    const FFileStatData Stat = IFileManager::Get().GetStatData(*FilePath);
+    if (!Stat.bIsValid || Stat.bIsDirectory)
+    {
+        return FString();
+    }
+
+    const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+    if (const FFileHashEntry* Known = FileHashes.Find(FullPath))
+    {
+        if (Known->Size == Stat.FileSize && Known->Timestamp == Stat.ModificationTime)
+        {
+            return Known->Hash;
+        }
+    }
+
+    TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+    if (!Reader.IsValid())
+    {
+        return FString();
+    }
+
+    FXxHash64Builder Builder;
+    TArray<uint8> Buffer;
+    Buffer.SetNumUninitialized((int32)FMath::Min<int64>(HashChunkSize, FMath::Max<int64>(Stat.FileSize, 1)));
+
+    int64 Remaining = Reader->TotalSize();
+    while (Remaining > 0)
+    {
+        const int64 ChunkSize = FMath::Min<int64>(Remaining, Buffer.Num());
+        Reader->Serialize(Buffer.GetData(), ChunkSize);
+        if (Reader->IsError())
+        {
+            return FString();
+        }
+        Builder.Update(Buffer.GetData(), ChunkSize);
+        Remaining -= ChunkSize;
+    }
+
+    FFileHashEntry& Entry = FileHashes.FindOrAdd(FullPath);
+    Entry.Size = Stat.FileSize;
+    Entry.Timestamp = Stat.ModificationTime;
+    Entry.Hash = FormatHash(Builder.Finalize());
+    return Entry.Hash;
+}
+
+FString FComfyUIUploadCache::MakeKey(const FString& ServerUrl, const FString& ContentHash)
+{
+    FString Server = ServerUrl.ToLower();
+    Server.RemoveFromEnd(TEXT("/"));
+    return Server + TEXT("|") + ContentHash;
+}
+
+FComfyUIUploadCacheEntry* FComfyUIUploadCache::Find(const FString& ServerUrl, const FString& ContentHash)
+{
+    if (ContentHash.IsEmpty())
+    {
+        return nullptr;
+    }
+
+    FComfyUIUploadCacheEntry* Entry = Entries.Find(MakeKey(ServerUrl, ContentHash));
+    if (Entry)
+    {
+        Entry->LastUsed = FDateTime::UtcNow();
+    }
+    return Entry;
+}
+
+void FComfyUIUploadCache::Add(const FString& ServerUrl, const FString& ContentHash, const FString& UploadedName, int64 Size)
+{
+    if (ContentHash.IsEmpty() || UploadedName.IsEmpty())
+    {
+        return;
+    }
+
+    FComfyUIUploadCacheEntry& Entry = Entries.FindOrAdd(MakeKey(ServerUrl, ContentHash));
+    Entry.UploadedName = UploadedName;
+    Entry.Size = Size;
+    Entry.LastUsed = FDateTime::UtcNow();
+    Entry.LastVerifiedTime = FPlatformTime::Seconds();
+
+    Prune();
+}
+
+void FComfyUIUploadCache::Remove(const FString& ServerUrl, const FString& ContentHash)
+{
+    Entries.Remove(MakeKey(ServerUrl, ContentHash));
+}
+
+void FComfyUIUploadCache::Prune()
+{
+    if (Entries.Num() <= MaxEntries)
+    {
+        return;
+    }
+
+    Entries.ValueSort([](const FComfyUIUploadCacheEntry& A, const FComfyUIUploadCacheEntry& B)
+    {
+        return A.LastUsed > B.LastUsed;
+    });
+
+    TArray<FString> Keys;
+    Entries.GetKeys(Keys);
+    for (int32 Index = MaxEntries; Index < Keys.Num(); ++Index)
+    {
+        Entries.Remove(Keys[Index]);
+    }
+}
+
+void FComfyUIUploadCache::Load()
+{
+    Entries.Reset();
+    FileHashes.Reset();
+
+    FString JsonContent;
+    if (!FPaths::FileExists(CacheFilePath) || !FFileHelper::LoadFileToString(JsonContent, *CacheFilePath))
+    {
+        return;
+    }
+
+    TSharedPtr<FJsonObject> Root;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonContent);
+    if (!FJsonSerializer::Deserialize(Reader, Root) || !Root.IsValid())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("UploadCache: failed to parse %s, starting empty"), *CacheFilePath);
+        return;
+    }
+
+    int32 Version = 0;
+    if (!Root->TryGetNumberField(TEXT("version"), Version) || Version != UploadCacheVersion)
+    {
+        return;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* EntryArray = nullptr;
+    if (Root->TryGetArrayField(TEXT("entries"), EntryArray) && EntryArray)
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *EntryArray)
+        {
+            const TSharedPtr<FJsonObject>* Object = nullptr;
+            if (!Value.IsValid() || !Value->TryGetObject(Object) || !Object)
+            {
+                continue;
+            }
+
+            FString Server, Hash, LastUsed;
+            FComfyUIUploadCacheEntry Entry;
+            if ((*Object)->TryGetStringField(TEXT("server"), Server) &&
+                (*Object)->TryGetStringField(TEXT("hash"), Hash) &&
+                (*Object)->TryGetStringField(TEXT("name"), Entry.UploadedName))
+            {
+                (*Object)->TryGetNumberField(TEXT("size"), Entry.Size);
+                if ((*Object)->TryGetStringField(TEXT("last_used"), LastUsed))
+                {
+                    FDateTime::ParseIso8601(*LastUsed, Entry.LastUsed);
+                }
+                Entries.Add(MakeKey(Server, Hash), Entry);
+            }
+        }
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* FileArray = nullptr;
+    if (Root->TryGetArrayField(TEXT("files"), FileArray) && FileArray)
+    {
+        for (const TSharedPtr<FJsonValue>& Value : *FileArray)
+        {
+            const TSharedPtr<FJsonObject>* Object = nullptr;
+            if (!Value.IsValid() || !Value->TryGetObject(Object) || !Object)
+            {
+                continue;
+            }
+
+            FString Path, Timestamp;
+            FFileHashEntry Entry;
+            // 已删除的文件不再保留
+            if ((*Object)->TryGetStringField(TEXT("path"), Path) && FPaths::FileExists(Path) &&
+                (*Object)->TryGetStringField(TEXT("hash"), Entry.Hash) &&
+                (*Object)->TryGetStringField(TEXT("timestamp"), Timestamp) &&
+                FDateTime::ParseIso8601(*Timestamp, Entry.Timestamp))
+            {
+                (*Object)->TryGetNumberField(TEXT("size"), Entry.Size);
+                FileHashes.Add(Path, Entry);
+            }
+        }
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("UploadCache: loaded %d entries from %s"), Entries.Num(), *CacheFilePath);
+}
+
+void FComfyUIUploadCache::Save() const
+{
+    TSharedPtr<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetNumberField(TEXT("version"), UploadCacheVersion);
+
+    TArray<TSharedPtr<FJsonValue>> EntryArray;
+    for (const TPair<FString, FComfyUIUploadCacheEntry>& Pair : Entries)
+    {
+        FString Server, Hash;
+        if (!Pair.Key.Split(TEXT("|"), &Server, &Hash, ESearchCase::CaseSensitive, ESearchDir::FromEnd))
+        {
+            continue;
+        }
+
+        TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetStringField(TEXT("server"), Server);
+        Object->SetStringField(TEXT("hash"), Hash);
+        Object->SetStringField(TEXT("name"), Pair.Value.UploadedName);
+        Object->SetNumberField(TEXT("size"), (double)Pair.Value.Size);
+        Object->SetStringField(TEXT("last_used"), Pair.Value.LastUsed.ToIso8601());
+        EntryArray.Add(MakeShared<FJsonValueObject>(Object));
+    }
+    Root->SetArrayField(TEXT("entries"), EntryArray);
+
+    TArray<TSharedPtr<FJsonValue>> FileArray;
+    for (const TPair<FString, FFileHashEntry>& Pair : FileHashes)
+    {
+        TSharedPtr<FJsonObject> Object = MakeShared<FJsonObject>();
+        Object->SetStringField(TEXT("path"), Pair.Key);
+        Object->SetStringField(TEXT("hash"), Pair.Value.Hash);
+        Object->SetNumberField(TEXT("size"), (double)Pair.Value.Size);
+        Object->SetStringField(TEXT("timestamp"), Pair.Value.Timestamp.ToIso8601());
+        FileArray.Add(MakeShared<FJsonValueObject>(Object));
+    }
+    Root->SetArrayField(TEXT("files"), FileArray);
+
+    FString JsonContent;
+    TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonContent);
+    if (!FJsonSerializer::Serialize(Root.ToSharedRef(), Writer))
+    {
+        return;
+    }
+
+    UComfyUIFileManager::EnsureDirectoryExists(FPaths::GetPath(CacheFilePath));
+    if (!FFileHelper::SaveStringToFile(JsonContent, *CacheFilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("UploadCache: failed to save %s"), *CacheFilePath);
+    }
+}
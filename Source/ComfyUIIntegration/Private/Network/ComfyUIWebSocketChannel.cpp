@@ -0,0 +1,274 @@
+#include "Network/ComfyUIWebSocketChannel.h"
+#include "WebSocketsModule.h"
+#include "IWebSocket.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+
+FComfyUIWebSocketChannel::FComfyUIWebSocketChannel(const FString& InServerUrl, const FString& InClientId)
+    : ServerUrl(InServerUrl)
+    , ClientId(InClientId)
+{
+}
+
+FComfyUIWebSocketChannel::~FComfyUIWebSocketChannel()
+{
+    Close();
+}
+
+FString FComfyUIWebSocketChannel::BuildWebSocketUrl(const FString& HttpUrl, const FString& InClientId)
+{
+    FString WsUrl = HttpUrl;
+    if (WsUrl.StartsWith(TEXT("https://")))
+    {
+        WsUrl = TEXT("wss://") + WsUrl.RightChop(8);
+    }
+    else if (WsUrl.StartsWith(TEXT("http://")))
+    {
+        WsUrl = TEXT("ws://") + WsUrl.RightChop(7);
+    }
+    else if (!WsUrl.StartsWith(TEXT("ws://")) && !WsUrl.StartsWith(TEXT("wss://")))
+    {
+        WsUrl = TEXT("ws://") + WsUrl;
+    }
+
+    if (!WsUrl.EndsWith(TEXT("/"))) WsUrl += TEXT("/");
+    return WsUrl + TEXT("ws?clientId=") + InClientId;
+}
+
+void FComfyUIWebSocketChannel::Connect()
+{
+    bWantConnection = true;
+
+    if (WebSocket.IsValid())
+    {
+        // 已连接或正在连接
+        return;
+    }
+
+    if (ServerUrl.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ComfyUI WebSocket: Server URL is empty"));
+        return;
+    }
+
+    FString WsUrl = BuildWebSocketUrl(ServerUrl, ClientId);
+    WebSocket = FWebSocketsModule::Get().CreateWebSocket(WsUrl);
+    if (!WebSocket.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("ComfyUI WebSocket: Failed to create socket for %s"), *WsUrl);
+        ScheduleReconnect();
+        return;
+    }
+
+    WebSocket->OnConnected().AddSP(this, &FComfyUIWebSocketChannel::HandleConnected);
+    WebSocket->OnConnectionError().AddSP(this, &FComfyUIWebSocketChannel::HandleConnectionError);
+    WebSocket->OnClosed().AddSP(this, &FComfyUIWebSocketChannel::HandleClosed);
+    WebSocket->OnMessage().AddSP(this, &FComfyUIWebSocketChannel::HandleMessage);
+    // 二进制消息为预览图，当前不处理
+
+    UE_LOG(LogTemp, Log, TEXT("ComfyUI WebSocket: Connecting to %s"), *WsUrl);
+    WebSocket->Connect();
+}
+
+void FComfyUIWebSocketChannel::Close()
+{
+    bWantConnection = false;
+
+    if (ReconnectTickerHandle.IsValid())
+    {
+        FTSTicker::GetCoreTicker().RemoveTicker(ReconnectTickerHandle);
+        ReconnectTickerHandle.Reset();
+    }
+
+    if (WebSocket.IsValid() && WebSocket->IsConnected())
+    {
+        WebSocket->Close();
+    }
+    ReleaseWebSocket();
+
+    SetConnected(false);
+}
+
+void FComfyUIWebSocketChannel::ReleaseWebSocket()
+{
+    if (!WebSocket.IsValid())
+    {
+        return;
+    }
+
+    WebSocket->OnConnected().RemoveAll(this);
+    WebSocket->OnConnectionError().RemoveAll(this);
+    WebSocket->OnClosed().RemoveAll(this);
+    WebSocket->OnMessage().RemoveAll(this);
+
+    // 可能正处于该连接自身的事件广播中，下一帧再释放，避免在回调返回前销毁连接
+    TSharedPtr<IWebSocket> Released = MoveTemp(WebSocket);
+    FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Released](float) mutable
+    {
+        Released.Reset();
+        return false;
+    }));
+}
+
+bool FComfyUIWebSocketChannel::IsConnected() const
+{
+    return bConnected && WebSocket.IsValid() && WebSocket->IsConnected();
+}
+
+void FComfyUIWebSocketChannel::HandleConnected()
+{
+    UE_LOG(LogTemp, Log, TEXT("ComfyUI WebSocket: Connected to %s"), *ServerUrl);
+    SetConnected(true);
+}
+
+void FComfyUIWebSocketChannel::HandleConnectionError(const FString& Error)
+{
+    UE_LOG(LogTemp, Warning, TEXT("ComfyUI WebSocket: Connection error (%s): %s"), *ServerUrl, *Error);
+    ReleaseWebSocket();
+    SetConnected(false);
+    ScheduleReconnect();
+}
+
+void FComfyUIWebSocketChannel::HandleClosed(int32 StatusCode, const FString& Reason, bool bWasClean)
+{
+    UE_LOG(LogTemp, Warning, TEXT("ComfyUI WebSocket: Closed (%d, clean=%d): %s"), StatusCode, bWasClean ? 1 : 0, *Reason);
+    ReleaseWebSocket();
+    SetConnected(false);
+    ScheduleReconnect();
+}
+
+void FComfyUIWebSocketChannel::HandleMessage(const FString& Message)
+{
+    FComfyUIServerEvent Event;
+    if (!ParseServerMessage(Message, Event))
+    {
+        UE_LOG(LogTemp, VeryVerbose, TEXT("ComfyUI WebSocket: Ignored message: %s"), *Message);
+        return;
+    }
+
+    OnServerEvent.ExecuteIfBound(Event);
+}
+
+void FComfyUIWebSocketChannel::ScheduleReconnect()
+{
+    if (!bWantConnection || ReconnectTickerHandle.IsValid())
+    {
+        return;
+    }
+
+    ReconnectTickerHandle = FTSTicker::GetCoreTicker().AddTicker(
+        FTickerDelegate::CreateSP(this, &FComfyUIWebSocketChannel::HandleReconnect),
+        ReconnectDelaySeconds
+    );
+}
+
+bool FComfyUIWebSocketChannel::HandleReconnect(float DeltaTime)
+{
+    ReconnectTickerHandle.Reset();
+    if (bWantConnection)
+    {
+        Connect();
+    }
+    return false; // 只执行一次
+}
+
+void FComfyUIWebSocketChannel::SetConnected(bool bNewConnected)
+{
+    if (bConnected != bNewConnected)
+    {
+        bConnected = bNewConnected;
+        OnStateChanged.ExecuteIfBound(bConnected);
+    }
+}
+
+bool FComfyUIWebSocketChannel::ParseServerMessage(const FString& Message, FComfyUIServerEvent& OutEvent)
+{
+    TSharedPtr<FJsonObject> JsonObject;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(Message);
+    if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+    {
+        return false;
+    }
+
+    FString TypeString;
+    if (!JsonObject->TryGetStringField(TEXT("type"), TypeString))
+    {
+        return false;
+    }
+
+    const TSharedPtr<FJsonObject>* DataPtr = nullptr;
+    TSharedPtr<FJsonObject> Data = JsonObject->TryGetObjectField(TEXT("data"), DataPtr) && DataPtr ? *DataPtr : nullptr;
+    if (!Data.IsValid())
+    {
+        return false;
+    }
+
+    Data->TryGetStringField(TEXT("prompt_id"), OutEvent.PromptId);
+
+    if (TypeString == TEXT("status"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::Status;
+        const TSharedPtr<FJsonObject>* StatusPtr = nullptr;
+        const TSharedPtr<FJsonObject>* ExecInfoPtr = nullptr;
+        if (Data->TryGetObjectField(TEXT("status"), StatusPtr) && StatusPtr &&
+            (*StatusPtr)->TryGetObjectField(TEXT("exec_info"), ExecInfoPtr) && ExecInfoPtr)
+        {
+            (*ExecInfoPtr)->TryGetNumberField(TEXT("queue_remaining"), OutEvent.QueueRemaining);
+        }
+    }
+    else if (TypeString == TEXT("execution_start"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::ExecutionStart;
+    }
+    else if (TypeString == TEXT("execution_cached"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::ExecutionCached;
+    }
+    else if (TypeString == TEXT("executing"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::Executing;
+        // node 为 null 时表示执行结束，TryGetStringField 会保持为空
+        Data->TryGetStringField(TEXT("node"), OutEvent.NodeId);
+    }
+    else if (TypeString == TEXT("progress"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::Progress;
+        Data->TryGetStringField(TEXT("node"), OutEvent.NodeId);
+        Data->TryGetNumberField(TEXT("value"), OutEvent.ProgressValue);
+        Data->TryGetNumberField(TEXT("max"), OutEvent.ProgressMax);
+    }
+    else if (TypeString == TEXT("executed"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::Executed;
+        Data->TryGetStringField(TEXT("node"), OutEvent.NodeId);
+        const TSharedPtr<FJsonObject>* OutputPtr = nullptr;
+        if (Data->TryGetObjectField(TEXT("output"), OutputPtr) && OutputPtr)
+        {
+            OutEvent.Data = *OutputPtr;
+        }
+    }
+    else if (TypeString == TEXT("execution_success"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::ExecutionSuccess;
+    }
+    else if (TypeString == TEXT("execution_error"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::ExecutionError;
+        Data->TryGetStringField(TEXT("node_id"), OutEvent.NodeId);
+        Data->TryGetStringField(TEXT("exception_message"), OutEvent.ErrorMessage);
+        OutEvent.Data = Data;
+    }
+    else if (TypeString == TEXT("execution_interrupted"))
+    {
+        OutEvent.Type = EComfyUIServerEventType::ExecutionInterrupted;
+        Data->TryGetStringField(TEXT("node_id"), OutEvent.NodeId);
+    }
+    else
+    {
+        OutEvent.Type = EComfyUIServerEventType::Unknown;
+        return false;
+    }
+
+    return true;
+}
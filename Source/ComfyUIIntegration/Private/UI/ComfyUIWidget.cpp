@@ -91,6 +91,12 @@ void SComfyUIWidget::Construct(const FArguments& InArgs)
     
     // 刷新自定义工作流列表
     RefreshCustomWorkflowList();
+    
+    // 模板目录中的修改热重载后刷新列表
+    if (UComfyUIWorkflowService* WorkflowService = UComfyUIWorkflowService::Get())
+    {
+        WorkflowService->OnWorkflowsChanged().AddSP(this, &SComfyUIWidget::OnCustomWorkflowsReloaded);
+    }
 
     ChildSlot
     [
@@ -221,7 +227,7 @@ TSharedRef<SWidget> SComfyUIWidget::CreateServerConfigWidget()
             [
                 SAssignNew(ComfyUIServerUrlTextBox, SEditableTextBox)
                 .Text(FText::FromString(TEXT("http://192.168.2.169:8188")))
-                .HintText(LOCTEXT("ServerUrlHint", "请输入ComfyUI服务器URL"))
+                .HintText(LOCTEXT("ServerUrlHint", "请输入ComfyUI服务器URL，多台服务器用逗号分隔"))
             ]
         ]
 
@@ -448,6 +454,7 @@ TSharedRef<SWidget> SComfyUIWidget::CreateControlButtonsWidget()
                 .Text(LOCTEXT("CancelButton", "取消"))
                 .OnClicked(this, &SComfyUIWidget::OnCancelClicked)
                 .Visibility(this, &SComfyUIWidget::GetCancelButtonVisibility)
+                .IsEnabled(this, &SComfyUIWidget::IsCancelButtonEnabled)
                 .HAlign(HAlign_Center)
                 .ToolTipText(LOCTEXT("CancelTooltip", "取消当前生成任务"))
             ]
@@ -803,28 +810,42 @@ FReply SComfyUIWidget::OnGenerateClicked()
     CurrentClient = UComfyUIClient::GetInstance();
     if (CurrentClient)
     {
-        CurrentClient->SetServerUrl(ServerUrl);
+        // 支持用逗号或分号分隔的多台服务器，任务会分配到负载最低的一台
+        TArray<FString> ServerUrls;
+        ServerUrl.Replace(TEXT(";"), TEXT(",")).ParseIntoArray(ServerUrls, TEXT(","), true);
+        CurrentClient->SetServerUrls(ServerUrls);
+        
+        TFunction<void()> StartGeneration = [this, TypeToCheck, Prompt, NegativePrompt]()
+        {
+            FComfyUIWorkflowExecutor::RunGeneration(
+                TypeToCheck,
+                Prompt,
+                NegativePrompt,
+                InputImage,
+                InputModelPath,
+                CurrentClient,
+                // 回调委托，按正确顺序
+                FOnImageGenerated::CreateSP(this, &SComfyUIWidget::OnImageGenerationComplete),
+                FOnMeshGenerated::CreateSP(this, &SComfyUIWidget::OnMeshGenerationComplete),
+                FOnGenerationProgress::CreateSP(this, &SComfyUIWidget::OnGenerationProgressUpdate),
+                FOnGenerationStarted::CreateSP(this, &SComfyUIWidget::OnGenerationStarted),
+                FOnGenerationFailed(),  // 暂时为空，稍后添加失败处理
+                FOnGenerationCompleted::CreateSP(this, &SComfyUIWidget::OnGenerationCompleted)
+            );
+        };
         
-        // 先测试连接
-        CurrentClient->TestServerConnection(FOnConnectionTested::CreateLambda([this, TypeToCheck, Prompt, NegativePrompt](bool bSuccess, FString ErrorMessage)
+        // 后台健康监控确认过服务器可用时直接提交，否则先测试连接
+        if (CurrentClient->HasHealthyServer())
+        {
+            StartGeneration();
+            return FReply::Handled();
+        }
+        
+        CurrentClient->TestServerConnection(FOnConnectionTested::CreateLambda([this, StartGeneration](bool bSuccess, FString ErrorMessage)
         {
             if (bSuccess)
             {
-                FComfyUIWorkflowExecutor::RunGeneration(
-                    TypeToCheck,
-                    Prompt,
-                    NegativePrompt,
-                    InputImage,
-                    InputModelPath,
-                    CurrentClient,
-                    // 回调委托，按正确顺序
-                    FOnImageGenerated::CreateSP(this, &SComfyUIWidget::OnImageGenerationComplete),
-                    FOnMeshGenerated::CreateSP(this, &SComfyUIWidget::OnMeshGenerationComplete),
-                    FOnGenerationProgress::CreateSP(this, &SComfyUIWidget::OnGenerationProgressUpdate),
-                    FOnGenerationStarted::CreateSP(this, &SComfyUIWidget::OnGenerationStarted),
-                    FOnGenerationFailed(),  // 暂时为空，稍后添加失败处理
-                    FOnGenerationCompleted::CreateSP(this, &SComfyUIWidget::OnGenerationCompleted)
-                );
+                StartGeneration();
             }
             else
             {
@@ -947,11 +968,11 @@ FReply SComfyUIWidget::OnSaveAsClicked()
             
             if (FileExtension == TEXT("gltf") || FileExtension == TEXT("glb"))
             {
-                // 对于glTF格式，如果有原始数据则直接保存，否则显示错误
-                if (GeneratedMeshOriginalData.Num() > 0 && 
+                // 对于glTF格式，如果有原始文件则直接复制，否则显示错误
+                if (!GeneratedMeshSourcePath.IsEmpty() && FPaths::FileExists(GeneratedMeshSourcePath) &&
                     (GeneratedMeshOriginalFormat == TEXT("gltf") || GeneratedMeshOriginalFormat == TEXT("glb")))
                 {
-                    bSaveSuccess = UComfyUI3DAssetManager::SaveOriginalModelData(GeneratedMeshOriginalData, SavePath);
+                    bSaveSuccess = UComfyUI3DAssetManager::CopyOriginalModelFile(GeneratedMeshSourcePath, SavePath);
                     UE_LOG(LogTemp, Log, TEXT("OnSaveAsClicked: Saved original glTF data, format: %s"), *GeneratedMeshOriginalFormat);
                 }
                 else
@@ -1220,7 +1241,7 @@ void SComfyUIWidget::OnImageGenerationComplete(UTexture2D* GeneratedImage)
     }
 }
 
-void SComfyUIWidget::OnMeshGenerationComplete(UStaticMesh* InGeneratedMesh, const TArray<uint8>& OriginalData, const FString& OriginalFormat)
+void SComfyUIWidget::OnMeshGenerationComplete(UStaticMesh* InGeneratedMesh, const FString& SourceFilePath, const FString& OriginalFormat)
 {
     // 清理之前的瞬态网格
     CleanupTransientMesh();
@@ -1234,12 +1255,12 @@ void SComfyUIWidget::OnMeshGenerationComplete(UStaticMesh* InGeneratedMesh, cons
     {
         this->GeneratedMesh = InGeneratedMesh;
         
-        // 保存原始数据用于文件导出
-        this->GeneratedMeshOriginalData = OriginalData;
+        // 记录原始文件路径用于文件导出
+        this->GeneratedMeshSourcePath = SourceFilePath;
         this->GeneratedMeshOriginalFormat = OriginalFormat.ToLower();
         
-        UE_LOG(LogTemp, Log, TEXT("OnMeshGenerationComplete: Saved original data, format: %s, size: %d bytes"), 
-               *OriginalFormat, OriginalData.Num());
+        UE_LOG(LogTemp, Log, TEXT("OnMeshGenerationComplete: Original file: %s, format: %s"), 
+               *SourceFilePath, *OriginalFormat);
         
         // 在3D视口中显示生成的模型
         if (ModelViewport.IsValid())
@@ -1426,6 +1447,29 @@ void SComfyUIWidget::OnCustomWorkflowChanged(TSharedPtr<FString> NewSelection, E
     }
 }
 
+void SComfyUIWidget::OnCustomWorkflowsReloaded()
+{
+    const FString SelectedName = CurrentCustomWorkflow.IsValid() ? *CurrentCustomWorkflow : FString();
+    
+    RefreshCustomWorkflowList();
+    
+    // 列表项是新建的，按名称找回原来的选择；原来的工作流已删除时选择第一个
+    const TSharedPtr<FString>* Found = CustomWorkflowNames.FindByPredicate([&SelectedName](const TSharedPtr<FString>& WorkflowName)
+    {
+        return *WorkflowName == SelectedName;
+    });
+    CurrentCustomWorkflow = Found ? *Found : (CustomWorkflowNames.Num() > 0 ? CustomWorkflowNames[0] : nullptr);
+    
+    if (CurrentCustomWorkflow.IsValid())
+    {
+        if (CustomWorkflowComboBox.IsValid())
+            CustomWorkflowComboBox->SetSelectedItem(CurrentCustomWorkflow);
+        
+        DetectWorkflowType(*CurrentCustomWorkflow);
+    }
+    UpdateWorkflowVisibility();
+}
+
 FText SComfyUIWidget::GetWorkflowTypeText(TSharedPtr<EComfyUIWorkflowType> InOption) const
 {
     if (!InOption.IsValid())
@@ -1791,6 +1835,12 @@ EVisibility SComfyUIWidget::GetCancelButtonVisibility() const
     return bIsGenerating ? EVisibility::Visible : EVisibility::Collapsed;
 }
 
+bool SComfyUIWidget::IsCancelButtonEnabled() const
+{
+    // 开始回调先报告占位 ID（如 "workflow_execution_started"），服务器返回 prompt_id 后才能只取消本窗口的任务
+    return bIsGenerating && CurrentClient && IsValid(CurrentClient) && CurrentClient->IsGenerationActive(CurrentPromptId);
+}
+
 bool SComfyUIWidget::IsGenerateButtonEnabled() const
 {
     return !bIsGenerating;
@@ -1830,8 +1880,12 @@ FReply SComfyUIWidget::OnCancelClicked()
 {
     if (bIsGenerating && CurrentClient && IsValid(CurrentClient))
     {
-        // 取消当前生成任务
-        CurrentClient->CancelCurrentGeneration();
+        // 只取消本窗口发起的任务；客户端上其他任务不受影响，尚未拿到 prompt_id 时按钮不可用
+        if (!CurrentClient->CancelGeneration(CurrentPromptId))
+        {
+            return FReply::Handled();
+        }
+        CurrentPromptId.Empty();
         
         // 重置UI状态
         bIsGenerating = false;
@@ -1865,6 +1919,7 @@ void SComfyUIWidget::OnGenerationStarted(const FString& PromptId)
 {
     bIsGenerating = true;
     CurrentProgressInfo = FComfyUIProgressInfo(0, 0.0f, TEXT(""), TEXT("开始生成..."), false);
+    CurrentPromptId = PromptId;
     UE_LOG(LogTemp, Log, TEXT("Generation started with Prompt ID: %s"), *PromptId);
 }
 
@@ -1873,6 +1928,7 @@ void SComfyUIWidget::OnGenerationCompleted()
     bIsGenerating = false;
     CurrentProgressInfo = FComfyUIProgressInfo();
     CurrentClient = nullptr;  // 清除客户端引用，生成完成后不再需要
+    CurrentPromptId.Empty();
     UE_LOG(LogTemp, Log, TEXT("Generation completed"));
 }
 
@@ -73,57 +73,101 @@ FString UComfyUIFileManager::GetConfigDirectory()
     return GetPluginDirectory() / TEXT("Config");
 }
 
+FString UComfyUIFileManager::GetIntermediateDirectory()
+{
+    return FPaths::ProjectIntermediateDir() / TEXT("ComfyUI");
+}
+
+FString UComfyUIFileManager::GetDownloadsDirectory()
+{
+    return GetIntermediateDirectory() / TEXT("Downloads");
+}
+
+FString UComfyUIFileManager::GetCacheDirectory()
+{
+    return FPaths::ProjectSavedDir() / TEXT("ComfyUI");
+}
+
 UTexture2D* UComfyUIFileManager::CreateTextureFromImageData(const TArray<uint8>& ImageData)
 {
     if (ImageData.Num() == 0)
         LOG_AND_RETURN(Error, nullptr, "CreateTextureFromImageData: Empty image data");
 
-    // 使用ImageWrapper模块来解码图像
-    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+    // 确保 ImageWrapper 模块已加载
+    FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
 
-    // 尝试不同的图像格式
-    static const TArray<EImageFormat> SupportedFormats = {
-        EImageFormat::PNG,
-        EImageFormat::JPEG,
-        EImageFormat::BMP,
-        EImageFormat::EXR
-    };
+    TArray<uint8> UncompressedBGRA;
+    int32 Width = 0;
+    int32 Height = 0;
+    if (!DecodeImageData(ImageData, UncompressedBGRA, Width, Height))
+    {
+        UE_LOG(LogTemp, Error, TEXT("CreateTextureFromImageData: Failed to decode image data with any supported format"));
+        return nullptr;
+    }
+
+    return CreateTextureFromBGRA(UncompressedBGRA, Width, Height);
+}
+
+bool UComfyUIFileManager::DecodeImageData(const TArray<uint8>& ImageData, TArray<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight)
+{
+    if (ImageData.Num() == 0)
+        return false;
+
+    // 工作线程上不能加载模块，只取已加载的模块
+    IImageWrapperModule* ImageWrapperModule = FModuleManager::GetModulePtr<IImageWrapperModule>(FName("ImageWrapper"));
+    if (!ImageWrapperModule)
+        LOG_AND_RETURN(Error, false, "DecodeImageData: ImageWrapper module is not loaded");
 
-    for (EImageFormat Format : SupportedFormats)
+    // 先按文件头识别格式，识别不了再逐个尝试
+    const EImageFormat DetectedFormat = ImageWrapperModule->DetectImageFormat(ImageData.GetData(), ImageData.Num());
+    TArray<EImageFormat> FormatsToTry;
+    if (DetectedFormat != EImageFormat::Invalid)
+    {
+        FormatsToTry.Add(DetectedFormat);
+    }
+    for (EImageFormat Format : { EImageFormat::PNG, EImageFormat::JPEG, EImageFormat::BMP, EImageFormat::EXR })
     {
-        TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(Format);
+        FormatsToTry.AddUnique(Format);
+    }
+
+    for (EImageFormat Format : FormatsToTry)
+    {
+        TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule->CreateImageWrapper(Format);
         if (!ImageWrapper.IsValid()) continue;
 
-        if (ImageWrapper->SetCompressed(ImageData.GetData(), ImageData.Num()))
+        if (ImageWrapper->SetCompressed(ImageData.GetData(), ImageData.Num()) &&
+            ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, OutBGRA))
         {
-            TArray<uint8> UncompressedBGRA;
-            if (ImageWrapper->GetRaw(ERGBFormat::BGRA, 8, UncompressedBGRA))
-            {
-                // 创建纹理
-                int32 Width = ImageWrapper->GetWidth();
-                int32 Height = ImageWrapper->GetHeight();
-                
-                UTexture2D* NewTexture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
-                if (NewTexture)
-                {
-                    // 使用更现代的方式填充纹理数据
-                    FTexture2DMipMap& Mip = NewTexture->GetPlatformData()->Mips[0];
-                    void* TextureData = Mip.BulkData.Lock(LOCK_READ_WRITE);
-                    FMemory::Memcpy(TextureData, UncompressedBGRA.GetData(), UncompressedBGRA.Num());
-                    Mip.BulkData.Unlock();
-                    
-                    // 更新纹理
-                    NewTexture->UpdateResource();
-                    
-                    UE_LOG(LogTemp, Log, TEXT("CreateTextureFromImageData: Successfully created %dx%d texture"), Width, Height);
-                    return NewTexture;
-                }
-            }
+            OutWidth = ImageWrapper->GetWidth();
+            OutHeight = ImageWrapper->GetHeight();
+            return true;
         }
     }
+    return false;
+}
+
+UTexture2D* UComfyUIFileManager::CreateTextureFromBGRA(const TArray<uint8>& BGRA, int32 Width, int32 Height)
+{
+    check(IsInGameThread());
+
+    if (Width <= 0 || Height <= 0 || BGRA.Num() < Width * Height * 4)
+        LOG_AND_RETURN(Error, nullptr, "CreateTextureFromBGRA: Invalid pixel data (%dx%d, %d bytes)", Width, Height, BGRA.Num());
+
+    UTexture2D* NewTexture = UTexture2D::CreateTransient(Width, Height, PF_B8G8R8A8);
+    if (!NewTexture)
+        return nullptr;
+
+    // 使用更现代的方式填充纹理数据
+    FTexture2DMipMap& Mip = NewTexture->GetPlatformData()->Mips[0];
+    void* TextureData = Mip.BulkData.Lock(LOCK_READ_WRITE);
+    FMemory::Memcpy(TextureData, BGRA.GetData(), (SIZE_T)Width * Height * 4);
+    Mip.BulkData.Unlock();
+
+    // 更新纹理
+    NewTexture->UpdateResource();
 
-    UE_LOG(LogTemp, Error, TEXT("CreateTextureFromImageData: Failed to decode image data with any supported format"));
-    return nullptr;
+    UE_LOG(LogTemp, Log, TEXT("CreateTextureFromBGRA: Successfully created %dx%d texture"), Width, Height);
+    return NewTexture;
 }
 
 bool UComfyUIFileManager::ExtractImageDataFromTexture(UTexture2D* Texture, TArray<uint8>& OutImageData, EComfyUIImageFormat ImageFormat)
@@ -0,0 +1,294 @@
+#include "Workflow/ComfyUICompiledTemplate.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Hash/CityHash.h"
+
+namespace
+{
+    uint64 HashString(const FString& Value, uint64 Seed)
+    {
+        return CityHash64WithSeed(reinterpret_cast<const char*>(*Value), Value.Len() * sizeof(TCHAR), Seed);
+    }
+
+    bool IsPlaceholderChar(TCHAR Char)
+    {
+        return (Char >= TEXT('A') && Char <= TEXT('Z')) || (Char >= TEXT('0') && Char <= TEXT('9')) || Char == TEXT('_');
+    }
+
+    /** Content[Start] 为 '{' 时返回匹配的 '}' 位置，中间不是占位符名时返回 INDEX_NONE */
+    int32 MatchPlaceholder(const TCHAR* Content, int32 Num, int32 Start)
+    {
+        int32 Index = Start + 1;
+        while (Index < Num && IsPlaceholderChar(Content[Index]))
+        {
+            ++Index;
+        }
+        return Index < Num && Index > Start + 1 && Content[Index] == TEXT('}') ? Index : INDEX_NONE;
+    }
+}
+
+FComfyUITemplateValue FComfyUITemplateValue::MakeString(const FString& Value)
+{
+    FComfyUITemplateValue Result;
+    Result.Type = EType::String;
+    Result.String = Value;
+    return Result;
+}
+
+FComfyUITemplateValue FComfyUITemplateValue::MakeNumber(double Value)
+{
+    FComfyUITemplateValue Result;
+    Result.Type = EType::Number;
+    Result.Number = Value;
+    return Result;
+}
+
+FComfyUITemplateValue FComfyUITemplateValue::MakeBoolean(bool Value)
+{
+    FComfyUITemplateValue Result;
+    Result.Type = EType::Boolean;
+    Result.bBoolean = Value;
+    return Result;
+}
+
+FString FComfyUITemplateValue::ToText() const
+{
+    switch (Type)
+    {
+    case EType::Number:
+    {
+        FString Text;
+        FComfyUICompiledTemplate::AppendNumber(Text, Number);
+        return Text;
+    }
+    case EType::Boolean:
+        return bBoolean ? TEXT("true") : TEXT("false");
+    default:
+        return String;
+    }
+}
+
+TSharedPtr<const FComfyUICompiledTemplate> FComfyUICompiledTemplate::Compile(const FString& TemplateJson, FString* OutError, TSharedPtr<FJsonObject>* OutParsed)
+{
+    // 只编译合法的工作流 JSON，词法切分依赖字符串边界正确
+    TSharedPtr<FJsonObject> Parsed;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(TemplateJson);
+    if (!FJsonSerializer::Deserialize(Reader, Parsed) || !Parsed.IsValid())
+    {
+        if (OutError)
+        {
+            *OutError = TEXT("Invalid JSON format");
+        }
+        return nullptr;
+    }
+    if (OutParsed)
+    {
+        *OutParsed = Parsed;
+    }
+
+    TSharedRef<FComfyUICompiledTemplate> Compiled = MakeShared<FComfyUICompiledTemplate>();
+
+    const TCHAR* Chars = *TemplateJson;
+    const int32 Len = TemplateJson.Len();
+    FString Literal;
+    Literal.Reserve(Len);
+
+    int32 Index = 0;
+    while (Index < Len)
+    {
+        const TCHAR Char = Chars[Index];
+        if (Char != TEXT('"'))
+        {
+            // 字符串之外的空白不影响语义，直接去掉
+            if (!FChar::IsWhitespace(Char))
+            {
+                Literal.AppendChar(Char);
+            }
+            ++Index;
+            continue;
+        }
+
+        int32 End = Index + 1;
+        while (End < Len && Chars[End] != TEXT('"'))
+        {
+            End += Chars[End] == TEXT('\\') ? 2 : 1;
+        }
+        End = FMath::Min(End, Len);
+
+        Compiled->CompileString(Chars + Index + 1, End - Index - 1, Literal);
+        Index = End + 1;
+    }
+
+    Compiled->LiteralLength += Literal.Len();
+    Compiled->TrailingLiteral = MoveTemp(Literal);
+
+    // 内容哈希基于压缩后的片段，只有空白不同的模板哈希相同
+    uint64 Hash = 0;
+    for (const FSlot& Slot : Compiled->Slots)
+    {
+        Hash = HashString(Slot.Literal, Hash);
+        Hash = HashString(Slot.Name, Hash ^ (Slot.bWholeValue ? 1 : 2));
+    }
+    Compiled->ContentHash = HashString(Compiled->TrailingLiteral, Hash);
+    return Compiled;
+}
+
+void FComfyUICompiledTemplate::CompileString(const TCHAR* Content, int32 Num, FString& Literal)
+{
+    // 整个值就是占位符：槽位按类型写出，引号由槽位决定
+    if (Num > 0 && Content[0] == TEXT('{') && MatchPlaceholder(Content, Num, 0) == Num - 1)
+    {
+        AddSlot(Literal, FString(Num - 2, Content + 1), true);
+        return;
+    }
+
+    Literal.AppendChar(TEXT('"'));
+    int32 Index = 0;
+    while (Index < Num)
+    {
+        if (Content[Index] == TEXT('{'))
+        {
+            const int32 Close = MatchPlaceholder(Content, Num, Index);
+            if (Close != INDEX_NONE)
+            {
+                AddSlot(Literal, FString(Close - Index - 1, Content + Index + 1), false);
+                Index = Close + 1;
+                continue;
+            }
+        }
+
+        // 转义序列原样保留
+        if (Content[Index] == TEXT('\\') && Index + 1 < Num)
+        {
+            Literal.AppendChar(Content[Index++]);
+        }
+        Literal.AppendChar(Content[Index++]);
+    }
+    Literal.AppendChar(TEXT('"'));
+}
+
+void FComfyUICompiledTemplate::AddSlot(FString& Literal, FString&& Name, bool bWholeValue)
+{
+    PlaceholderNames.AddUnique(Name);
+    LiteralLength += Literal.Len();
+
+    FSlot& Slot = Slots.AddDefaulted_GetRef();
+    Slot.Literal = MoveTemp(Literal);
+    Slot.Name = MoveTemp(Name);
+    Slot.bWholeValue = bWholeValue;
+    Literal.Reset();
+}
+
+void FComfyUICompiledTemplate::Write(const FComfyUITemplateBindings& Bindings, FString& Out, const FComfyUITemplateBindings* Defaults) const
+{
+    Out.Reserve(Out.Len() + LiteralLength + Slots.Num() * 32);
+
+    for (const FSlot& Slot : Slots)
+    {
+        Out += Slot.Literal;
+
+        const FComfyUITemplateValue* Value = Bindings.Find(Slot.Name);
+        if (!Value && Defaults)
+        {
+            Value = Defaults->Find(Slot.Name);
+        }
+        if (!Value)
+        {
+            // 未绑定的占位符保留原文
+            Out += Slot.bWholeValue ? TEXT("\"{") : TEXT("{");
+            Out += Slot.Name;
+            Out += Slot.bWholeValue ? TEXT("}\"") : TEXT("}");
+            continue;
+        }
+
+        if (!Slot.bWholeValue)
+        {
+            AppendEscaped(Out, Value->ToText());
+            continue;
+        }
+
+        switch (Value->Type)
+        {
+        case FComfyUITemplateValue::EType::Number:
+            AppendNumber(Out, Value->Number);
+            break;
+        case FComfyUITemplateValue::EType::Boolean:
+            Out += Value->bBoolean ? TEXT("true") : TEXT("false");
+            break;
+        default:
+            Out.AppendChar(TEXT('"'));
+            AppendEscaped(Out, Value->String);
+            Out.AppendChar(TEXT('"'));
+            break;
+        }
+    }
+
+    Out += TrailingLiteral;
+}
+
+FString FComfyUICompiledTemplate::BuildRequest(const FComfyUITemplateBindings& Bindings, const FString& ClientId, const FComfyUITemplateBindings* Defaults) const
+{
+    FString Request;
+    Request.Reserve(LiteralLength + Slots.Num() * 32 + 64);
+    Request += TEXT("{\"client_id\":\"");
+    AppendEscaped(Request, ClientId);
+    Request += TEXT("\",\"prompt\":");
+    Write(Bindings, Request, Defaults);
+    Request.AppendChar(TEXT('}'));
+    return Request;
+}
+
+void FComfyUICompiledTemplate::AppendEscaped(FString& Out, const FString& Value)
+{
+    for (const TCHAR Char : Value)
+    {
+        switch (Char)
+        {
+        case TEXT('"'):  Out += TEXT("\\\""); break;
+        case TEXT('\\'): Out += TEXT("\\\\"); break;
+        case TEXT('\n'): Out += TEXT("\\n"); break;
+        case TEXT('\r'): Out += TEXT("\\r"); break;
+        case TEXT('\t'): Out += TEXT("\\t"); break;
+        case TEXT('\b'): Out += TEXT("\\b"); break;
+        case TEXT('\f'): Out += TEXT("\\f"); break;
+        default:
+            if (Char < 0x20)
+            {
+                Out += FString::Printf(TEXT("\\u%04x"), (uint32)Char);
+            }
+            else
+            {
+                Out.AppendChar(Char);
+            }
+            break;
+        }
+    }
+}
+
+void FComfyUICompiledTemplate::AppendNumber(FString& Out, double Value)
+{
+    if (!FMath::IsFinite(Value))
+    {
+        // JSON 没有 NaN/Inf
+        Out += TEXT("0");
+        return;
+    }
+
+    // 整数（步数、种子、尺寸）写为不带小数点的整数，ComfyUI 的 INT 输入不接受 20.0
+    if (Value == FMath::RoundToDouble(Value) && FMath::Abs(Value) < 9007199254740992.0)
+    {
+        Out += FString::Printf(TEXT("%lld"), (int64)Value);
+        return;
+    }
+    Out += FString::SanitizeFloat(Value);
+}
+
+FString FComfyUIWorkflowTemplate::BuildRequest(const FComfyUITemplateBindings& Bindings, const FString& ClientId) const
+{
+    if (!Compiled.IsValid())
+    {
+        return FString();
+    }
+    return Compiled->BuildRequest(Bindings, ClientId, Defaults.Get());
+}
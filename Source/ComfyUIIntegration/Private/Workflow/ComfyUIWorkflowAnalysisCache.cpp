@@ -0,0 +1,207 @@
+#include "Workflow/ComfyUIWorkflowAnalysisCache.h"
+#include "Utils/ComfyUIFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+    /** 文件标识 "CUWA" */
+    constexpr uint32 AnalysisCacheMagic = 0x41575543;
+
+    /** 文件格式版本，与分析器版本无关 */
+    constexpr uint32 AnalysisCacheFormatVersion = 1;
+
+    template <typename EnumType>
+    void SerializeEnum(FArchive& Ar, EnumType& Value)
+    {
+        uint8 Raw = (uint8)Value;
+        Ar << Raw;
+        Value = (EnumType)Raw;
+    }
+
+    void SerializeInput(FArchive& Ar, FWorkflowInputInfo& Input)
+    {
+        Ar << Input.NodeId;
+        Ar << Input.ParameterName;
+        SerializeEnum(Ar, Input.InputType);
+        Ar << Input.PlaceholderValue;
+        Ar << Input.DisplayName;
+        Ar << Input.Description;
+        Ar << Input.bRequired;
+        Ar << Input.MinValue;
+        Ar << Input.MaxValue;
+        Ar << Input.ChoiceOptions;
+    }
+
+    void SerializeOutput(FArchive& Ar, FWorkflowOutputInfo& Output)
+    {
+        Ar << Output.NodeId;
+        Ar << Output.NodeType;
+        SerializeEnum(Ar, Output.OutputType);
+    }
+
+    void SerializeParameter(FArchive& Ar, FWorkflowParameterDef& Parameter)
+    {
+        Ar << Parameter.Name;
+        Ar << Parameter.Type;
+        Ar << Parameter.DefaultValue;
+        Ar << Parameter.Description;
+        Ar << Parameter.ChoiceOptions;
+        Ar << Parameter.MinValue;
+        Ar << Parameter.MaxValue;
+    }
+
+    template <typename ElementType>
+    void SerializeArray(FArchive& Ar, TArray<ElementType>& Array, void (*SerializeElement)(FArchive&, ElementType&))
+    {
+        int32 Num = Array.Num();
+        Ar << Num;
+        if (Ar.IsLoading())
+        {
+            // 损坏的文件不能导致巨大的分配
+            if (Num < 0 || Num > Ar.TotalSize())
+            {
+                Ar.SetError();
+                return;
+            }
+            Array.SetNum(Num);
+        }
+        for (ElementType& Element : Array)
+        {
+            SerializeElement(Ar, Element);
+            if (Ar.IsError())
+            {
+                return;
+            }
+        }
+    }
+}
+
+FComfyUIWorkflowAnalysis FComfyUIWorkflowAnalysis::FromConfig(const FWorkflowConfig& Config)
+{
+    FComfyUIWorkflowAnalysis Analysis;
+    Analysis.RequiredInputs = Config.RequiredInputs;
+    Analysis.OutputNodes = Config.OutputNodes;
+    Analysis.DetectedType = Config.DetectedType;
+    Analysis.ParameterDefinitions = Config.ParameterDefinitions;
+    Analysis.WorkflowInputs = Config.WorkflowInputs;
+    Analysis.WorkflowOutputs = Config.WorkflowOutputs;
+    return Analysis;
+}
+
+void FComfyUIWorkflowAnalysis::ApplyTo(FWorkflowConfig& Config) const
+{
+    Config.RequiredInputs = RequiredInputs;
+    Config.OutputNodes = OutputNodes;
+    Config.DetectedType = DetectedType;
+    Config.ParameterDefinitions = ParameterDefinitions;
+    Config.WorkflowInputs = WorkflowInputs;
+    Config.WorkflowOutputs = WorkflowOutputs;
+}
+
+void FComfyUIWorkflowAnalysis::Serialize(FArchive& Ar)
+{
+    Ar << RequiredInputs;
+    Ar << OutputNodes;
+    SerializeEnum(Ar, DetectedType);
+    SerializeArray(Ar, ParameterDefinitions, &SerializeParameter);
+    SerializeArray(Ar, WorkflowInputs, &SerializeInput);
+    SerializeArray(Ar, WorkflowOutputs, &SerializeOutput);
+}
+
+FComfyUIWorkflowAnalysisCache::FComfyUIWorkflowAnalysisCache(const FString& InCacheFilePath)
+    : CacheFilePath(InCacheFilePath)
+{
+}
+
+const FComfyUIWorkflowAnalysis* FComfyUIWorkflowAnalysisCache::Find(uint64 ContentHash)
+{
+    FCachedAnalysis* Entry = Entries.Find(ContentHash);
+    if (!Entry)
+    {
+        return nullptr;
+    }
+    Entry->bUsed = true;
+    return &Entry->Analysis;
+}
+
+void FComfyUIWorkflowAnalysisCache::Add(uint64 ContentHash, FComfyUIWorkflowAnalysis&& Analysis)
+{
+    FCachedAnalysis& Entry = Entries.FindOrAdd(ContentHash);
+    Entry.Analysis = MoveTemp(Analysis);
+    Entry.bUsed = true;
+}
+
+void FComfyUIWorkflowAnalysisCache::Load()
+{
+    Entries.Reset();
+
+    // 整个文件一次读入，再从内存反序列化
+    TArray<uint8> Data;
+    if (!FPaths::FileExists(CacheFilePath) || !FFileHelper::LoadFileToArray(Data, *CacheFilePath))
+    {
+        return;
+    }
+
+    FMemoryReader Reader(Data);
+    uint32 Magic = 0, FormatVersion = 0, Version = 0;
+    int32 Count = 0;
+    Reader << Magic << FormatVersion << Version << Count;
+    if (Reader.IsError() || Magic != AnalysisCacheMagic || FormatVersion != AnalysisCacheFormatVersion || Version != AnalyzerVersion)
+    {
+        // 分析器版本变化，旧结果全部作废
+        return;
+    }
+
+    for (int32 Index = 0; Index < Count && !Reader.AtEnd(); ++Index)
+    {
+        uint64 ContentHash = 0;
+        FCachedAnalysis Entry;
+        Reader << ContentHash;
+        Entry.Analysis.Serialize(Reader);
+        if (Reader.IsError())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("WorkflowAnalysisCache: %s is corrupt, starting empty"), *CacheFilePath);
+            Entries.Reset();
+            return;
+        }
+        Entries.Add(ContentHash, MoveTemp(Entry));
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("WorkflowAnalysisCache: loaded %d entries from %s"), Entries.Num(), *CacheFilePath);
+}
+
+void FComfyUIWorkflowAnalysisCache::Save()
+{
+    // 超出容量时只保留本次会话用到的记录
+    const bool bUsedOnly = Entries.Num() > MaxEntries;
+    int32 Count = 0;
+    for (const TPair<uint64, FCachedAnalysis>& Pair : Entries)
+    {
+        Count += (!bUsedOnly || Pair.Value.bUsed) ? 1 : 0;
+    }
+
+    TArray<uint8> Data;
+    FMemoryWriter Writer(Data);
+    uint32 Magic = AnalysisCacheMagic, FormatVersion = AnalysisCacheFormatVersion, Version = AnalyzerVersion;
+    Writer << Magic << FormatVersion << Version << Count;
+
+    for (TPair<uint64, FCachedAnalysis>& Pair : Entries)
+    {
+        if (bUsedOnly && !Pair.Value.bUsed)
+        {
+            continue;
+        }
+        uint64 ContentHash = Pair.Key;
+        Writer << ContentHash;
+        Pair.Value.Analysis.Serialize(Writer);
+    }
+
+    UComfyUIFileManager::EnsureDirectoryExists(FPaths::GetPath(CacheFilePath));
+    if (!FFileHelper::SaveArrayToFile(Data, *CacheFilePath))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("WorkflowAnalysisCache: failed to save %s"), *CacheFilePath);
+    }
+}
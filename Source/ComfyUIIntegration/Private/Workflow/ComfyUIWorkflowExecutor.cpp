@@ -4,7 +4,6 @@
 #include "Engine/Texture2D.h"
 #include "Workflow/ComfyUIWorkflowService.h"
 
-#pragma optimize("", off)
 void FComfyUIWorkflowExecutor::RunGeneration(
     EComfyUIWorkflowType WorkflowType,
     const FString& Prompt,
@@ -46,6 +45,37 @@ void FComfyUIWorkflowExecutor::RunGeneration(
     bool bNeedImageUpload = InputImage && WorkflowNeedsImageInput(WorkflowType);
     bool bNeedModelUpload = !InputModelPath.IsEmpty() && WorkflowNeedsMeshInput(WorkflowType);
     
+    // 输入的内容哈希用于结果缓存的键；图像数据只提取一次，上传时复用
+    TArray<uint8> ImageData;
+    const bool bImageExtracted = bNeedImageUpload && UComfyUIFileManager::ExtractImageDataFromTexture(InputImage, ImageData);
+    if (bImageExtracted)
+    {
+        Params.InputContentHashes.Add(TEXT("INPUT_IMAGE"), FComfyUIUploadCache::HashData(ImageData));
+    }
+    if (bNeedModelUpload && Client && FPaths::FileExists(InputModelPath))
+    {
+        const FString ModelHash = Client->HashInputFile(InputModelPath);
+        if (!ModelHash.IsEmpty())
+        {
+            Params.InputContentHashes.Add(TEXT("INPUT_MESH"), ModelHash);
+        }
+    }
+    
+    // 所有输入都已计算哈希、且相同请求已有缓存的结果时跳过上传
+    const int32 NumUploads = (bNeedImageUpload ? 1 : 0) + (bNeedModelUpload ? 1 : 0);
+    if (NumUploads > 0 && Params.InputContentHashes.Num() == NumUploads && Client &&
+        Client->HasCachedResult(MakeResultCacheKey(Params)))
+    {
+        UE_LOG(LogTemp, Log, TEXT("RunGeneration: Cached result found, skipping input uploads"));
+        return ExecuteWorkflow(Params, Client);
+    }
+    
+    // 需要上传输入时先选定服务器，上传的文件只存在于这台服务器上
+    if ((bNeedImageUpload || bNeedModelUpload) && Client)
+    {
+        Params.ServerUrl = Client->SelectServer();
+    }
+    
     if (!bNeedImageUpload && !bNeedModelUpload)
     {
         // 没有需要上传的资源，直接执行工作流
@@ -88,14 +118,13 @@ void FComfyUIWorkflowExecutor::RunGeneration(
     // 处理图像上传
     if (bNeedImageUpload)
     {
-        TArray<uint8> ImageData;
-        if (UComfyUIFileManager::ExtractImageDataFromTexture(InputImage, ImageData))
+        if (bImageExtracted)
         {
             FString FileName = FString::Printf(TEXT("input_%d.png"), FDateTime::Now().GetTicks());
             
             if (Client)
             {
-                Client->UploadImage(ImageData, FileName, 
+                Client->UploadImage(MoveTemp(ImageData), FileName, 
                     [OnUploadCompleted, UploadState, OnFailed](const FString& ImageName, bool bSuccess) mutable {
                         if (bSuccess && !ImageName.IsEmpty())
                         {
@@ -113,7 +142,8 @@ void FComfyUIWorkflowExecutor::RunGeneration(
                         }
                         
                         OnUploadCompleted();
-                    });
+                    },
+                    Params.ServerUrl);
             }
             else
             {
@@ -135,14 +165,14 @@ void FComfyUIWorkflowExecutor::RunGeneration(
     // 处理3D模型上传到ComfyUI的input目录
     if (bNeedModelUpload)
     {
-        TArray<uint8> ModelData;
-        if (UComfyUIFileManager::LoadArrayFromFile(InputModelPath, ModelData))
+        // 只检查文件是否存在，内容在上传时从磁盘流式读取
+        if (FPaths::FileExists(InputModelPath))
         {
             FString FileName = FPaths::GetCleanFilename(InputModelPath);
             
             if (Client)
             {
-                Client->UploadModel(ModelData, FileName, 
+                Client->UploadModelFile(InputModelPath, FileName, 
                     [OnUploadCompleted, UploadState, OnFailed](const FString& ModelName, bool bSuccess) mutable {
                         if (bSuccess && !ModelName.IsEmpty())
                         {
@@ -164,7 +194,8 @@ void FComfyUIWorkflowExecutor::RunGeneration(
                         }
                         
                         OnUploadCompleted();
-                    });
+                    },
+                    Params.ServerUrl);
             }
             else
             {
@@ -212,6 +243,16 @@ void FComfyUIWorkflowExecutor::ExecuteWorkflow(const FComfyUIWorkflowExecutorPar
         return;
     }
     
+    // 获取工作流模板，本次执行的参数只放在局部绑定中，不写入共享的工作流配置
+    const FComfyUIWorkflowTemplate Template = WorkflowService->GetWorkflowTemplate(WorkflowName);
+    if (!Template.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("ExecuteWorkflow: No valid template for workflow: %s"), *WorkflowName);
+        return;
+    }
+    
+    FComfyUITemplateBindings Bindings = UComfyUIWorkflowService::MakeBindings(Params.Input);
+    
     // 为3D生成工作流设置输出文件名参数
     if (Params.WorkflowType == EComfyUIWorkflowType::ImageTo3D || 
         Params.WorkflowType == EComfyUIWorkflowType::TextTo3D)
@@ -222,18 +263,14 @@ void FComfyUIWorkflowExecutor::ExecuteWorkflow(const FComfyUIWorkflowExecutorPar
         FString OutputFilenamePrefix = FString::Printf(TEXT("Generated3D_%s_%s"), *Timestamp, *UniqueId);
         
         // 设置输出文件名参数
-        WorkflowService->SetWorkflowParameter(WorkflowName, TEXT("OUTPUT_FILENAME_PREFIX"), OutputFilenamePrefix);
-        
-        // 将文件名存储到Input参数中，供后续下载使用
-        FComfyUIWorkflowExecutorParams& MutableParams = const_cast<FComfyUIWorkflowExecutorParams&>(Params);
-        MutableParams.Input.TextParameters.Add(TEXT("EXPECTED_OUTPUT_FILENAME"), OutputFilenamePrefix + TEXT(".glb"));
+        Bindings.Add(TEXT("OUTPUT_FILENAME_PREFIX"), FComfyUITemplateValue::MakeString(OutputFilenamePrefix));
+        Bindings.Add(TEXT("EXPECTED_OUTPUT_FILENAME"), FComfyUITemplateValue::MakeString(OutputFilenamePrefix + TEXT(".glb")));
         
         UE_LOG(LogTemp, Log, TEXT("Set 3D output filename: %s"), *OutputFilenamePrefix);
     }
     
-    // 构建工作流JSON
-    // 使用WorkflowService构建JSON，传入完整的Input参数
-    FString WorkflowJson = WorkflowService->BuildWorkflowJson(WorkflowName, Params.Input);
+    // 构建工作流JSON，直接写入客户端 ID，提交时不必再解析和重新序列化
+    FString WorkflowJson = Template.BuildRequest(Bindings, Client->GetClientId());
     
     if (WorkflowJson.IsEmpty())
     {
@@ -254,9 +291,11 @@ void FComfyUIWorkflowExecutor::ExecuteWorkflow(const FComfyUIWorkflowExecutorPar
                            Params.OnImageGenerated,
                            Params.OnMeshGenerated,
                            Params.OnFailed,
-                           Params.OnCompleted);
+                           Params.OnCompleted,
+                           Params.ServerUrl,
+                           Params.OnWorkflowCompleted,
+                           MakeResultCacheKey(Params));
 }
-#pragma optimize("", on)
 
 bool FComfyUIWorkflowExecutor::WorkflowNeedsImageInput(EComfyUIWorkflowType WorkflowType)
 {
@@ -282,6 +321,33 @@ bool FComfyUIWorkflowExecutor::WorkflowNeedsMeshInput(EComfyUIWorkflowType Workf
     }
 }
 
+FString FComfyUIWorkflowExecutor::MakeResultCacheKey(const FComfyUIWorkflowExecutorParams& Params)
+{
+    UComfyUIWorkflowService* WorkflowService = Params.bUseResultCache ? UComfyUIWorkflowService::Get() : nullptr;
+    if (!WorkflowService)
+    {
+        return FString();
+    }
+    
+    const FComfyUIWorkflowTemplate Template = WorkflowService->GetWorkflowTemplate(GetWorkflowNameFromType(Params.WorkflowType));
+    if (!Template.IsValid())
+    {
+        return FString();
+    }
+    
+    // 上传的输入按内容哈希绑定，重新上传或上传到其他服务器时键不变；
+    // 3D 工作流每次生成的输出文件名不绑定，保留占位符原文
+    FComfyUITemplateBindings Bindings = UComfyUIWorkflowService::MakeBindings(Params.Input);
+    for (const auto& Hash : Params.InputContentHashes)
+    {
+        Bindings.Add(Hash.Key.ToUpper(), FComfyUITemplateValue::MakeString(TEXT("content:") + Hash.Value));
+    }
+    
+    FString PromptJson;
+    Template.Compiled->Write(Bindings, PromptJson, Template.Defaults.Get());
+    return FComfyUIResultCache::MakeKey(PromptJson);
+}
+
 FString FComfyUIWorkflowExecutor::GetWorkflowNameFromType(EComfyUIWorkflowType WorkflowType)
 {
     switch (WorkflowType)
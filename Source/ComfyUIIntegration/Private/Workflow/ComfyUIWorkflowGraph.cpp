@@ -0,0 +1,771 @@
+#include "Workflow/ComfyUIWorkflowGraph.h"
+#include "Dom/JsonObject.h"
+#include "Dom/JsonValue.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Misc/Parse.h"
+
+namespace
+{
+    /** inputs 中的值是否为链接 ["节点ID", 输出槽]：恰好两个元素，第二个是整数 */
+    bool GetLink(const TSharedPtr<FJsonValue>& Value, FString& OutSource, int32& OutSlot)
+    {
+        if (!Value.IsValid() || Value->Type != EJson::Array)
+        {
+            return false;
+        }
+
+        const TArray<TSharedPtr<FJsonValue>>& Elements = Value->AsArray();
+        if (Elements.Num() != 2 || !Elements[0].IsValid() || Elements[0]->Type != EJson::String ||
+            !Elements[1].IsValid() || Elements[1]->Type != EJson::Number)
+        {
+            return false;
+        }
+
+        const double Slot = Elements[1]->AsNumber();
+        if (Slot != FMath::FloorToDouble(Slot))
+        {
+            return false;
+        }
+
+        OutSource = Elements[0]->AsString();
+        OutSlot = (int32)Slot;
+        return true;
+    }
+
+    const TSharedPtr<FJsonObject>* FindInputs(const TSharedPtr<FJsonValue>& NodeValue)
+    {
+        const TSharedPtr<FJsonObject>* NodeObject = nullptr;
+        const TSharedPtr<FJsonObject>* Inputs = nullptr;
+        if (NodeValue.IsValid() && NodeValue->TryGetObject(NodeObject) && (*NodeObject)->TryGetObjectField(TEXT("inputs"), Inputs))
+        {
+            return Inputs;
+        }
+        return nullptr;
+    }
+
+    FString GetClassType(const TSharedPtr<FJsonValue>& NodeValue)
+    {
+        FString ClassType;
+        const TSharedPtr<FJsonObject>* NodeObject = nullptr;
+        if (NodeValue.IsValid() && NodeValue->TryGetObject(NodeObject))
+        {
+            (*NodeObject)->TryGetStringField(TEXT("class_type"), ClassType);
+        }
+        return ClassType;
+    }
+
+    /** 与键顺序无关的值文本，用于比较两个节点的输入是否相同 */
+    void AppendCanonical(FString& Out, const TSharedPtr<FJsonValue>& Value)
+    {
+        if (!Value.IsValid())
+        {
+            Out += TEXT("null");
+            return;
+        }
+
+        switch (Value->Type)
+        {
+        case EJson::String:
+            Out.AppendChar(TEXT('"'));
+            Out += Value->AsString().ReplaceCharWithEscapedChar();
+            Out.AppendChar(TEXT('"'));
+            break;
+        case EJson::Number:
+            Out += FString::Printf(TEXT("%.17g"), Value->AsNumber());
+            break;
+        case EJson::Boolean:
+            Out += Value->AsBool() ? TEXT("true") : TEXT("false");
+            break;
+        case EJson::Array:
+            Out.AppendChar(TEXT('['));
+            for (const TSharedPtr<FJsonValue>& Element : Value->AsArray())
+            {
+                AppendCanonical(Out, Element);
+                Out.AppendChar(TEXT(','));
+            }
+            Out.AppendChar(TEXT(']'));
+            break;
+        case EJson::Object:
+        {
+            const TSharedPtr<FJsonObject> Object = Value->AsObject();
+            TArray<FString> Keys;
+            Object->Values.GetKeys(Keys);
+            Keys.Sort();
+            Out.AppendChar(TEXT('{'));
+            for (const FString& Key : Keys)
+            {
+                Out += Key;
+                Out.AppendChar(TEXT(':'));
+                AppendCanonical(Out, Object->Values[Key]);
+                Out.AppendChar(TEXT(','));
+            }
+            Out.AppendChar(TEXT('}'));
+            break;
+        }
+        default:
+            Out += TEXT("null");
+            break;
+        }
+    }
+
+    FString MakeLinkKey(const FString& Source, int32 Slot)
+    {
+        return FString::Printf(TEXT("%s:%d"), *Source, Slot);
+    }
+
+    // ========== 请求文本扫描 ==========
+    // OptimizeRequest 按原文本删除节点，以下函数只定位值的范围，不解析数值
+
+    int32 SkipWhitespace(const FString& Json, int32 Pos)
+    {
+        while (Pos < Json.Len() && FChar::IsWhitespace(Json[Pos]))
+        {
+            ++Pos;
+        }
+        return Pos;
+    }
+
+    /** 读取 Pos 处的字符串字面量，返回结束引号之后的位置，格式错误时返回 INDEX_NONE */
+    int32 ReadString(const FString& Json, int32 Pos, FString* OutValue = nullptr)
+    {
+        if (Pos >= Json.Len() || Json[Pos] != TEXT('"'))
+        {
+            return INDEX_NONE;
+        }
+
+        for (++Pos; Pos < Json.Len(); ++Pos)
+        {
+            TCHAR Char = Json[Pos];
+            if (Char == TEXT('"'))
+            {
+                return Pos + 1;
+            }
+            if (Char == TEXT('\\'))
+            {
+                if (++Pos >= Json.Len())
+                {
+                    return INDEX_NONE;
+                }
+                switch (Json[Pos])
+                {
+                case TEXT('n'): Char = TEXT('\n'); break;
+                case TEXT('r'): Char = TEXT('\r'); break;
+                case TEXT('t'): Char = TEXT('\t'); break;
+                case TEXT('b'): Char = TEXT('\b'); break;
+                case TEXT('f'): Char = TEXT('\f'); break;
+                case TEXT('u'):
+                    if (Pos + 4 >= Json.Len())
+                    {
+                        return INDEX_NONE;
+                    }
+                    Char = (TCHAR)FParse::HexNumber(*Json.Mid(Pos + 1, 4));
+                    Pos += 4;
+                    break;
+                default: Char = Json[Pos]; break;
+                }
+            }
+            if (OutValue)
+            {
+                OutValue->AppendChar(Char);
+            }
+        }
+        return INDEX_NONE;
+    }
+
+    /** 跳过 Pos 处的一个值，返回值之后的位置，格式错误时返回 INDEX_NONE */
+    int32 SkipValue(const FString& Json, int32 Pos)
+    {
+        Pos = SkipWhitespace(Json, Pos);
+        if (Pos >= Json.Len())
+        {
+            return INDEX_NONE;
+        }
+        if (Json[Pos] == TEXT('"'))
+        {
+            return ReadString(Json, Pos);
+        }
+        if (Json[Pos] != TEXT('{') && Json[Pos] != TEXT('['))
+        {
+            // 数字、true、false、null
+            while (Pos < Json.Len() && !FChar::IsWhitespace(Json[Pos]) &&
+                   Json[Pos] != TEXT(',') && Json[Pos] != TEXT('}') && Json[Pos] != TEXT(']'))
+            {
+                ++Pos;
+            }
+            return Pos;
+        }
+
+        int32 Depth = 0;
+        while (Pos < Json.Len())
+        {
+            const TCHAR Char = Json[Pos];
+            if (Char == TEXT('"'))
+            {
+                Pos = ReadString(Json, Pos);
+                if (Pos == INDEX_NONE)
+                {
+                    return INDEX_NONE;
+                }
+                continue;
+            }
+            if (Char == TEXT('{') || Char == TEXT('['))
+            {
+                ++Depth;
+            }
+            else if ((Char == TEXT('}') || Char == TEXT(']')) && --Depth == 0)
+            {
+                return Pos + 1;
+            }
+            ++Pos;
+        }
+        return INDEX_NONE;
+    }
+
+    /** 对象成员在文本中的范围：从键的引号到值的末尾 */
+    struct FMemberSpan
+    {
+        FString Key;
+        int32 Start = 0;
+        int32 ValueStart = 0;
+        int32 End = 0;
+    };
+
+    /** 列出 Pos 处对象的成员，返回对象之后的位置，格式错误时返回 INDEX_NONE */
+    int32 ReadObjectMembers(const FString& Json, int32 Pos, TArray<FMemberSpan>& OutMembers)
+    {
+        Pos = SkipWhitespace(Json, Pos);
+        if (Pos >= Json.Len() || Json[Pos] != TEXT('{'))
+        {
+            return INDEX_NONE;
+        }
+        Pos = SkipWhitespace(Json, Pos + 1);
+        if (Pos < Json.Len() && Json[Pos] == TEXT('}'))
+        {
+            return Pos + 1;
+        }
+
+        while (true)
+        {
+            FMemberSpan& Member = OutMembers.AddDefaulted_GetRef();
+            Member.Start = Pos;
+            Pos = ReadString(Json, Pos, &Member.Key);
+            Pos = Pos == INDEX_NONE ? INDEX_NONE : SkipWhitespace(Json, Pos);
+            if (Pos == INDEX_NONE || Pos >= Json.Len() || Json[Pos] != TEXT(':'))
+            {
+                return INDEX_NONE;
+            }
+            Member.ValueStart = SkipWhitespace(Json, Pos + 1);
+            Member.End = SkipValue(Json, Member.ValueStart);
+            if (Member.End == INDEX_NONE)
+            {
+                return INDEX_NONE;
+            }
+
+            Pos = SkipWhitespace(Json, Member.End);
+            if (Pos < Json.Len() && Json[Pos] == TEXT('}'))
+            {
+                return Pos + 1;
+            }
+            if (Pos >= Json.Len() || Json[Pos] != TEXT(','))
+            {
+                return INDEX_NONE;
+            }
+            Pos = SkipWhitespace(Json, Pos + 1);
+        }
+    }
+
+    /** Pos 处是否为链接 ["节点ID", 整数输出槽]：恰好两个元素且第二个是整数，读出节点ID和它的结束位置 */
+    bool ReadLink(const FString& Json, int32 Pos, int32 End, FString& OutSource, int32& OutSourceStart, int32& OutSourceEnd)
+    {
+        OutSourceStart = SkipWhitespace(Json, Pos + 1);
+        OutSourceEnd = ReadString(Json, OutSourceStart, &OutSource);
+        if (OutSourceEnd == INDEX_NONE)
+        {
+            return false;
+        }
+
+        int32 Cursor = SkipWhitespace(Json, OutSourceEnd);
+        if (Cursor >= End || Json[Cursor] != TEXT(','))
+        {
+            return false;
+        }
+        Cursor = SkipWhitespace(Json, Cursor + 1);
+        if (Cursor < End && Json[Cursor] == TEXT('-'))
+        {
+            ++Cursor;
+        }
+        const int32 DigitsStart = Cursor;
+        while (Cursor < End && FChar::IsDigit(Json[Cursor]))
+        {
+            ++Cursor;
+        }
+        if (Cursor == DigitsStart)
+        {
+            return false;
+        }
+
+        Cursor = SkipWhitespace(Json, Cursor);
+        return Cursor < End && Json[Cursor] == TEXT(']');
+    }
+
+    /** 复制 [Start, End) 的文本，把指向被合并节点的链接 ["节点ID", 输出槽] 改为指向保留的节点，其他数组（如字符串列表）不改 */
+    void AppendRelinked(FString& Out, const FString& Json, int32 Start, int32 End, const TMap<FString, FString>& MergedNodes)
+    {
+        int32 Copied = Start;
+        int32 Pos = Start;
+        while (Pos < End)
+        {
+            const TCHAR Char = Json[Pos];
+            if (Char == TEXT('"'))
+            {
+                Pos = ReadString(Json, Pos);
+                if (Pos == INDEX_NONE)
+                {
+                    break;
+                }
+                continue;
+            }
+
+            if (Char == TEXT('['))
+            {
+                FString Source;
+                int32 SourceStart = INDEX_NONE;
+                int32 SourceEnd = INDEX_NONE;
+                const bool bLink = ReadLink(Json, Pos, End, Source, SourceStart, SourceEnd);
+                if (const FString* Kept = bLink ? MergedNodes.Find(Source) : nullptr)
+                {
+                    Out.Append(*Json + Copied, SourceStart - Copied);
+                    Out.AppendChar(TEXT('"'));
+                    Out += Kept->ReplaceCharWithEscapedChar();
+                    Out.AppendChar(TEXT('"'));
+                    Copied = Pos = SourceEnd;
+                    continue;
+                }
+            }
+            ++Pos;
+        }
+        Out.Append(*Json + Copied, End - Copied);
+    }
+}
+
+FString FComfyUIGraphOptimizeStats::ToString() const
+{
+    FString Result = FString::Printf(TEXT("nodes %d -> %d, depth %d"), NodesBefore, NodesAfter, MaxDepth);
+    if (MergedNodes.Num() > 0)
+    {
+        TArray<FString> Merged;
+        for (const TPair<FString, FString>& Pair : MergedNodes)
+        {
+            Merged.Add(FString::Printf(TEXT("%s->%s"), *Pair.Key, *Pair.Value));
+        }
+        Result += FString::Printf(TEXT(", merged loaders [%s]"), *FString::Join(Merged, TEXT(", ")));
+    }
+    if (PrunedPreviews.Num() > 0)
+    {
+        Result += FString::Printf(TEXT(", pruned previews [%s]"), *FString::Join(PrunedPreviews, TEXT(", ")));
+    }
+    if (PrunedNodes.Num() > 0)
+    {
+        Result += FString::Printf(TEXT(", pruned unreachable [%s]"), *FString::Join(PrunedNodes, TEXT(", ")));
+    }
+    return Result;
+}
+
+bool FComfyUIWorkflowGraph::Build(const TSharedPtr<FJsonObject>& Workflow, FString* OutError)
+{
+    Nodes.Reset();
+    TopologicalOrder.Reset();
+    MaxDepth = 0;
+
+    auto Fail = [OutError](const FString& Error)
+    {
+        if (OutError)
+        {
+            *OutError = Error;
+        }
+        return false;
+    };
+
+    if (!Workflow.IsValid())
+    {
+        return Fail(TEXT("Invalid workflow"));
+    }
+
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Workflow->Values)
+    {
+        if (!Pair.Value.IsValid() || Pair.Value->Type != EJson::Object)
+        {
+            return Fail(FString::Printf(TEXT("Node %s is not an object"), *Pair.Key));
+        }
+
+        FNode& Node = Nodes.Add(Pair.Key);
+        Node.ClassType = GetClassType(Pair.Value);
+        if (const TSharedPtr<FJsonObject>* Inputs = FindInputs(Pair.Value))
+        {
+            for (const TPair<FString, TSharedPtr<FJsonValue>>& Input : (*Inputs)->Values)
+            {
+                FString Source;
+                int32 Slot = 0;
+                if (GetLink(Input.Value, Source, Slot))
+                {
+                    Node.Dependencies.Add(Source);
+                }
+            }
+        }
+    }
+
+    // 反向邻接表，链接到同一上游的多个输入各记一次
+    TMap<FString, TArray<FString>> Consumers;
+    TMap<FString, int32> PendingDependencies;
+    for (TPair<FString, FNode>& Pair : Nodes)
+    {
+        for (const FString& Source : Pair.Value.Dependencies)
+        {
+            FNode* SourceNode = Nodes.Find(Source);
+            if (!SourceNode)
+            {
+                return Fail(FString::Printf(TEXT("Node %s links to missing node %s"), *Pair.Key, *Source));
+            }
+            ++SourceNode->ConsumerCount;
+            Consumers.FindOrAdd(Source).Add(Pair.Key);
+        }
+        PendingDependencies.Add(Pair.Key, Pair.Value.Dependencies.Num());
+    }
+
+    // Kahn 拓扑排序，按工作流中的出现顺序处理没有依赖的节点
+    TArray<FString> Ready;
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Workflow->Values)
+    {
+        if (PendingDependencies[Pair.Key] == 0)
+        {
+            Ready.Add(Pair.Key);
+        }
+    }
+
+    TopologicalOrder.Reserve(Nodes.Num());
+    for (int32 Index = 0; Index < Ready.Num(); ++Index)
+    {
+        const FString NodeId = Ready[Index];
+        FNode& Node = Nodes[NodeId];
+
+        Node.Depth = 1;
+        for (const FString& Source : Node.Dependencies)
+        {
+            Node.Depth = FMath::Max(Node.Depth, Nodes[Source].Depth + 1);
+        }
+        MaxDepth = FMath::Max(MaxDepth, Node.Depth);
+        TopologicalOrder.Add(NodeId);
+
+        if (const TArray<FString>* NodeConsumers = Consumers.Find(NodeId))
+        {
+            for (const FString& Consumer : *NodeConsumers)
+            {
+                if (--PendingDependencies[Consumer] == 0)
+                {
+                    Ready.Add(Consumer);
+                }
+            }
+        }
+    }
+
+    if (TopologicalOrder.Num() != Nodes.Num())
+    {
+        return Fail(TEXT("Workflow graph contains a cycle"));
+    }
+    return true;
+}
+
+int32 FComfyUIWorkflowGraph::GetDepth(const FString& NodeId) const
+{
+    const FNode* Node = Nodes.Find(NodeId);
+    return Node ? Node->Depth : 0;
+}
+
+bool FComfyUIWorkflowGraph::Optimize(const TSharedPtr<FJsonObject>& Workflow, FComfyUIGraphOptimizeStats& OutStats, FString* OutError)
+{
+    OutStats = FComfyUIGraphOptimizeStats();
+
+    FComfyUIWorkflowGraph Graph;
+    if (!Graph.Build(Workflow, OutError))
+    {
+        return false;
+    }
+    OutStats.NodesBefore = Graph.Nodes.Num();
+
+    // 1. 合并重复的加载节点：没有链接输入、class_type 和输入都相同，保留先出现的
+    TMap<FString, FString> LoaderKeys;
+    for (const FString& NodeId : Graph.TopologicalOrder)
+    {
+        const FNode& Node = Graph.Nodes[NodeId];
+        if (Node.Dependencies.Num() > 0 || !IsLoaderNode(Node.ClassType) || IsOutputNode(Node.ClassType))
+        {
+            continue;
+        }
+
+        FString Key = Node.ClassType;
+        Key.AppendChar(TEXT('|'));
+        if (const TSharedPtr<FJsonObject>* Inputs = FindInputs(Workflow->Values[NodeId]))
+        {
+            AppendCanonical(Key, MakeShared<FJsonValueObject>(*Inputs));
+        }
+
+        if (const FString* Kept = LoaderKeys.Find(Key))
+        {
+            OutStats.MergedNodes.Add(NodeId, *Kept);
+        }
+        else
+        {
+            LoaderKeys.Add(MoveTemp(Key), NodeId);
+        }
+    }
+
+    if (OutStats.MergedNodes.Num() > 0)
+    {
+        for (const TPair<FString, FString>& Merged : OutStats.MergedNodes)
+        {
+            Workflow->RemoveField(Merged.Key);
+        }
+
+        // 指向被合并节点的链接改为指向保留的节点，输出槽不变
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Workflow->Values)
+        {
+            const TSharedPtr<FJsonObject>* Inputs = FindInputs(Pair.Value);
+            if (!Inputs)
+            {
+                continue;
+            }
+            for (TPair<FString, TSharedPtr<FJsonValue>>& Input : (*Inputs)->Values)
+            {
+                FString Source;
+                int32 Slot = 0;
+                const FString* Kept = GetLink(Input.Value, Source, Slot) ? OutStats.MergedNodes.Find(Source) : nullptr;
+                if (Kept)
+                {
+                    TArray<TSharedPtr<FJsonValue>> Link;
+                    Link.Add(MakeShared<FJsonValueString>(*Kept));
+                    Link.Add(Input.Value->AsArray()[1]);
+                    Input.Value = MakeShared<FJsonValueArray>(Link);
+                }
+            }
+        }
+
+        Graph.Build(Workflow);
+    }
+
+    // 2. 删除与保存节点显示同一输出的预览节点，客户端不必再下载一份临时图像
+    TSet<FString> SavedSources;
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Workflow->Values)
+    {
+        const FString& ClassType = Graph.Nodes[Pair.Key].ClassType;
+        const TSharedPtr<FJsonObject>* Inputs = FindInputs(Pair.Value);
+        if (!Inputs || ClassType == TEXT("PreviewImage") || !IsOutputNode(ClassType))
+        {
+            continue;
+        }
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Input : (*Inputs)->Values)
+        {
+            FString Source;
+            int32 Slot = 0;
+            if (GetLink(Input.Value, Source, Slot))
+            {
+                SavedSources.Add(MakeLinkKey(Source, Slot));
+            }
+        }
+    }
+
+    for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : Workflow->Values)
+    {
+        const FNode& Node = Graph.Nodes[Pair.Key];
+        const TSharedPtr<FJsonObject>* Inputs = FindInputs(Pair.Value);
+        if (Node.ClassType != TEXT("PreviewImage") || Node.ConsumerCount > 0 || !Inputs || Node.Dependencies.Num() == 0)
+        {
+            continue;
+        }
+
+        bool bAllSaved = true;
+        for (const TPair<FString, TSharedPtr<FJsonValue>>& Input : (*Inputs)->Values)
+        {
+            FString Source;
+            int32 Slot = 0;
+            if (GetLink(Input.Value, Source, Slot) && !SavedSources.Contains(MakeLinkKey(Source, Slot)))
+            {
+                bAllSaved = false;
+                break;
+            }
+        }
+        if (bAllSaved)
+        {
+            OutStats.PrunedPreviews.Add(Pair.Key);
+        }
+    }
+
+    for (const FString& NodeId : OutStats.PrunedPreviews)
+    {
+        Workflow->RemoveField(NodeId);
+        Graph.Nodes.Remove(NodeId);
+    }
+
+    // 3. 删除从输出节点不可达的分支
+    // 根为输出节点，以及没有下游、又不是已知中间节点的节点（无法判断时保留）
+    TArray<FString> Stack;
+    for (const TPair<FString, FNode>& Pair : Graph.Nodes)
+    {
+        if (IsOutputNode(Pair.Value.ClassType) || (Pair.Value.ConsumerCount == 0 && !IsIntermediateNode(Pair.Value.ClassType)))
+        {
+            Stack.Add(Pair.Key);
+        }
+    }
+
+    if (Stack.Num() > 0)
+    {
+        TSet<FString> Reached;
+        while (Stack.Num() > 0)
+        {
+            const FString NodeId = Stack.Pop();
+            bool bAlreadyReached = false;
+            Reached.Add(NodeId, &bAlreadyReached);
+            if (!bAlreadyReached)
+            {
+                Stack.Append(Graph.Nodes[NodeId].Dependencies);
+            }
+        }
+
+        for (const FString& NodeId : Graph.TopologicalOrder)
+        {
+            if (Graph.Nodes.Contains(NodeId) && !Reached.Contains(NodeId))
+            {
+                OutStats.PrunedNodes.Add(NodeId);
+                Workflow->RemoveField(NodeId);
+            }
+        }
+    }
+
+    // 4. 在最终的图上计算拓扑深度
+    Graph.Build(Workflow);
+    OutStats.NodesAfter = Graph.Nodes.Num();
+    OutStats.MaxDepth = Graph.MaxDepth;
+    return true;
+}
+
+bool FComfyUIWorkflowGraph::OptimizeRequest(FString& RequestJson, FComfyUIGraphOptimizeStats& OutStats, FString* OutError)
+{
+    OutStats = FComfyUIGraphOptimizeStats();
+
+    auto Fail = [OutError](const FString& Error)
+    {
+        if (OutError)
+        {
+            *OutError = Error;
+        }
+        return false;
+    };
+
+    TSharedPtr<FJsonObject> Request;
+    TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(RequestJson);
+    TArray<FMemberSpan> RootMembers;
+    if (!FJsonSerializer::Deserialize(Reader, Request) || !Request.IsValid() ||
+        ReadObjectMembers(RequestJson, 0, RootMembers) == INDEX_NONE)
+    {
+        return Fail(TEXT("Invalid request JSON"));
+    }
+
+    // 节点表在 prompt 字段中，或者就是整个请求
+    TSharedPtr<FJsonObject> Workflow = Request;
+    int32 NodesStart = SkipWhitespace(RequestJson, 0);
+    const TSharedPtr<FJsonObject>* PromptObject = nullptr;
+    if (Request->TryGetObjectField(TEXT("prompt"), PromptObject))
+    {
+        Workflow = *PromptObject;
+        for (const FMemberSpan& Member : RootMembers)
+        {
+            if (Member.Key == TEXT("prompt"))
+            {
+                NodesStart = Member.ValueStart;
+            }
+        }
+    }
+
+    // 在解析出的副本上决定删除和合并哪些节点
+    if (!Optimize(Workflow, OutStats, OutError) || !OutStats.HasChanges())
+    {
+        return false;
+    }
+
+    TArray<FMemberSpan> Nodes;
+    const int32 NodesEnd = ReadObjectMembers(RequestJson, NodesStart, Nodes);
+    if (NodesEnd == INDEX_NONE)
+    {
+        return Fail(TEXT("Invalid prompt JSON"));
+    }
+
+    // 优化后仍在的节点按原文本复制
+    FString Result;
+    Result.Reserve(RequestJson.Len());
+    Result.Append(*RequestJson, NodesStart);
+    Result.AppendChar(TEXT('{'));
+    bool bFirst = true;
+    for (const FMemberSpan& Node : Nodes)
+    {
+        if (!Workflow->HasField(Node.Key))
+        {
+            continue;
+        }
+        if (!bFirst)
+        {
+            Result.AppendChar(TEXT(','));
+        }
+        bFirst = false;
+        AppendRelinked(Result, RequestJson, Node.Start, Node.End, OutStats.MergedNodes);
+    }
+    Result.AppendChar(TEXT('}'));
+    Result.Append(*RequestJson + NodesEnd, RequestJson.Len() - NodesEnd);
+
+    RequestJson = MoveTemp(Result);
+    return true;
+}
+
+bool FComfyUIWorkflowGraph::IsOutputNode(const FString& ClassType)
+{
+    static const TCHAR* OutputMarkers[] = { TEXT("Save"), TEXT("Preview"), TEXT("Show"), TEXT("Export"), TEXT("Output") };
+    for (const TCHAR* Marker : OutputMarkers)
+    {
+        if (ClassType.Contains(Marker, ESearchCase::CaseSensitive))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FComfyUIWorkflowGraph::IsLoaderNode(const FString& ClassType)
+{
+    if (ClassType.Contains(TEXT("Loader"), ESearchCase::CaseSensitive))
+    {
+        return true;
+    }
+
+    // LoadImage、Hy3D21LoadMesh 等：Load 后接大写字母（区分 Download、Upload）
+    const int32 Index = ClassType.Find(TEXT("Load"), ESearchCase::CaseSensitive);
+    return Index != INDEX_NONE && Index + 4 < ClassType.Len() && FChar::IsUpper(ClassType[Index + 4]);
+}
+
+bool FComfyUIWorkflowGraph::IsIntermediateNode(const FString& ClassType)
+{
+    static const TSet<FString> IntermediateNodes = {
+        TEXT("CLIPTextEncode"),
+        TEXT("CLIPSetLastLayer"),
+        TEXT("ConditioningCombine"),
+        TEXT("ConditioningSetArea"),
+        TEXT("ControlNetApply"),
+        TEXT("EmptyLatentImage"),
+        TEXT("ImageScale"),
+        TEXT("KSampler"),
+        TEXT("KSamplerAdvanced"),
+        TEXT("LatentUpscale"),
+        TEXT("VAEDecode"),
+        TEXT("VAEEncode"),
+        TEXT("VAEEncodeForInpaint"),
+    };
+    return IsLoaderNode(ClassType) || IntermediateNodes.Contains(ClassType);
+}
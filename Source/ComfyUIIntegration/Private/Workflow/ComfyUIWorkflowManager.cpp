@@ -1,5 +1,6 @@
 #include "Workflow/ComfyUIWorkflowManager.h"
 #include "Workflow/ComfyUINodeAnalyzer.h"
+#include "Workflow/ComfyUIWorkflowGraph.h"
 #include "Utils/ComfyUIFileManager.h"
 #include "Utils/Defines.h"
 #include "Dom/JsonObject.h"
@@ -8,6 +9,71 @@
 #include "Serialization/JsonWriter.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Async/ParallelFor.h"
+#include "DirectoryWatcherModule.h"
+#include "IDirectoryWatcher.h"
+#include "Modules/ModuleManager.h"
+
+namespace
+{
+    /** 是否包含至少一个有 class_type 和 inputs 的节点 */
+    bool HasValidNodes(const TSharedPtr<FJsonObject>& WorkflowJson)
+    {
+        for (const auto& NodePair : WorkflowJson->Values)
+        {
+            const TSharedPtr<FJsonValue>& NodeValue = NodePair.Value;
+            if (NodeValue->Type == EJson::Object)
+            {
+                TSharedPtr<FJsonObject> NodeObj = NodeValue->AsObject();
+                if (NodeObj->HasField(TEXT("class_type")) && NodeObj->HasField(TEXT("inputs")))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    FComfyUIWorkflowFileStamp MakeFileStamp(const FString& FilePath)
+    {
+        FComfyUIWorkflowFileStamp Stamp;
+        Stamp.Path = FilePath;
+        const FFileStatData StatData = IFileManager::Get().GetStatData(*FilePath);
+        if (StatData.bIsValid)
+        {
+            Stamp.Size = StatData.FileSize;
+            Stamp.ModificationTime = StatData.ModificationTime;
+        }
+        return Stamp;
+    }
+
+    /** 读取、解析并编译一个模板文件的结果 */
+    struct FLoadedTemplate
+    {
+        FString Content;
+        TSharedPtr<const FComfyUICompiledTemplate> Compiled;
+        FString Error;
+    };
+
+    /** 读取并编译模板文件，JSON 只解析一次；不访问 UObject，可以在工作线程调用 */
+    void LoadTemplateFile(const FString& FilePath, FLoadedTemplate& Out)
+    {
+        if (!UComfyUIFileManager::LoadJsonFromFile(FilePath, Out.Content))
+        {
+            Out.Error = TEXT("Failed to load workflow template");
+            return;
+        }
+        
+        TSharedPtr<FJsonObject> Parsed;
+        Out.Compiled = FComfyUICompiledTemplate::Compile(Out.Content, &Out.Error, &Parsed);
+        if (Out.Compiled.IsValid() && !HasValidNodes(Parsed))
+        {
+            Out.Compiled.Reset();
+            Out.Error = TEXT("Invalid ComfyUI workflow format: no valid nodes found");
+        }
+    }
+}
 
 UComfyUIWorkflowManager::UComfyUIWorkflowManager()
 {
@@ -22,7 +88,7 @@ void UComfyUIWorkflowManager::LoadWorkflowConfigs()
     UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowManager: Loading workflow configurations"));
     
     // 清空现有配置
-    CustomWorkflowConfigs.Empty();
+    ResetRegistry();
     
     // 从模板目录加载
     LoadTemplateDirectoryWorkflows();
@@ -35,36 +101,12 @@ bool UComfyUIWorkflowManager::LoadCustomWorkflowFromFile(const FString& FilePath
     if (!FPaths::FileExists(FilePath))
         LOG_AND_RETURN(Warning, false, "LoadCustomWorkflowFromFile: Workflow template file not found: %s", *FilePath);
     
-    FString TemplateContent;
-    if (!UComfyUIFileManager::LoadJsonFromFile(FilePath, TemplateContent))
-        LOG_AND_RETURN(Error, false, "LoadCustomWorkflowFromFile: Failed to load workflow template: %s", *FilePath);
-    
-    // 验证JSON格式
-    TSharedPtr<FJsonObject> TemplateJson;
-    if (!UComfyUIFileManager::ParseJsonString(TemplateContent, TemplateJson))
-        LOG_AND_RETURN(Error, false, "LoadCustomWorkflowFromFile: Invalid JSON in workflow template: %s", *FilePath);
+    FLoadedTemplate Loaded;
+    LoadTemplateFile(FilePath, Loaded);
+    if (!Loaded.Compiled.IsValid())
+        LOG_AND_RETURN(Error, false, "LoadCustomWorkflowFromFile: %s: %s", *Loaded.Error, *FilePath);
     
-    // 创建工作流配置
-    FWorkflowConfig NewWorkflow;
-    FString FileName = FPaths::GetBaseFilename(FilePath);
-    NewWorkflow.Name = FileName;
-    NewWorkflow.Type = TEXT("custom");
-    NewWorkflow.Description = FString::Printf(TEXT("Custom workflow loaded from %s"), *FileName);
-    NewWorkflow.JsonTemplate = TemplateContent;
-    NewWorkflow.TemplateFile = FilePath;
-    
-    // 验证工作流
-    FString ValidationError;
-    if (ValidateWorkflowJson(TemplateContent, NewWorkflow, ValidationError))
-    {
-        CustomWorkflowConfigs.Add(NewWorkflow);
-        UE_LOG(LogTemp, Log, TEXT("LoadCustomWorkflowFromFile: Successfully loaded workflow: %s"), *NewWorkflow.Name);
-        return true;
-    }
-    else
-    {
-        LOG_AND_RETURN(Warning, false, "LoadCustomWorkflowFromFile: Workflow validation failed for %s: %s", *FileName, *ValidationError);
-    }
+    return RegisterTemplateFile(MakeFileStamp(FilePath), MoveTemp(Loaded.Content), Loaded.Compiled);
 }
 
 void UComfyUIWorkflowManager::LoadTemplateDirectoryWorkflows()
@@ -77,27 +119,308 @@ void UComfyUIWorkflowManager::LoadTemplateDirectoryWorkflows()
         return;
     }
     
+    // 索引：只读取目录项（文件名、大小和修改时间）
     TArray<FString> TemplateFiles = UComfyUIFileManager::ScanFilesInDirectory(TemplatesDir, TEXT(".json"));
-    
+    TArray<FComfyUIWorkflowFileStamp> Stamps;
+    Stamps.Reserve(TemplateFiles.Num());
     for (const FString& TemplateFile : TemplateFiles)
     {
-        FString FullPath = TemplatesDir / TemplateFile;
-        LoadCustomWorkflowFromFile(FullPath);
+        Stamps.Add(MakeFileStamp(TemplatesDir / TemplateFile));
     }
     
-    UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowManager: Loaded %d workflows from templates directory"), TemplateFiles.Num());
+    // 读取、解析和编译在任务图上并行执行，节点分析推迟到第一次选中工作流
+    TArray<FLoadedTemplate> Loaded;
+    Loaded.SetNum(Stamps.Num());
+    ParallelFor(Stamps.Num(), [&Stamps, &Loaded](int32 Index)
+    {
+        LoadTemplateFile(Stamps[Index].Path, Loaded[Index]);
+    });
+    
+    // 按文件顺序注册，重复的名称和内容保留先出现的
+    int32 LoadedCount = 0;
+    for (int32 Index = 0; Index < Stamps.Num(); ++Index)
+    {
+        if (!Loaded[Index].Compiled.IsValid())
+        {
+            UE_LOG(LogTemp, Warning, TEXT("LoadTemplateDirectoryWorkflows: %s: %s"), *Loaded[Index].Error, *Stamps[Index].Path);
+            continue;
+        }
+        
+        if (RegisterTemplateFile(Stamps[Index], MoveTemp(Loaded[Index].Content), Loaded[Index].Compiled))
+        {
+            ++LoadedCount;
+        }
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowManager: Loaded %d of %d workflows from templates directory"), LoadedCount, TemplateFiles.Num());
 }
 
 TArray<FString> UComfyUIWorkflowManager::GetAvailableWorkflowNames() const
 {
     TArray<FString> WorkflowNames;
     
-    for (const FWorkflowConfig& Config : CustomWorkflowConfigs)
-        WorkflowNames.Add(Config.Name);
+    for (int32 Index = 0; Index < CustomWorkflowConfigs.Num(); ++Index)
+    {
+        if (!RegistryEntries[Index].bRemoved)
+            WorkflowNames.Add(CustomWorkflowConfigs[Index].Name);
+    }
     
     return WorkflowNames;
 }
 
+// ========== 模板热重载 ==========
+
+void UComfyUIWorkflowManager::StartWatchingTemplates()
+{
+    if (TemplateWatcherHandle.IsValid())
+    {
+        return;
+    }
+    
+    FString TemplatesDir = UComfyUIFileManager::GetTemplatesDirectory();
+    if (!FPaths::DirectoryExists(TemplatesDir))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("StartWatchingTemplates: Templates directory does not exist: %s"), *TemplatesDir);
+        return;
+    }
+    
+    FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+    IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+    if (!DirectoryWatcher)
+    {
+        return;
+    }
+    
+    WatchedTemplatesDirectory = FPaths::ConvertRelativePathToFull(TemplatesDir);
+    DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(
+        WatchedTemplatesDirectory,
+        IDirectoryWatcher::FDirectoryChanged::CreateUObject(this, &UComfyUIWorkflowManager::OnTemplateDirectoryChanged),
+        TemplateWatcherHandle);
+    
+    UE_LOG(LogTemp, Log, TEXT("StartWatchingTemplates: Watching %s"), *WatchedTemplatesDirectory);
+}
+
+void UComfyUIWorkflowManager::StopWatchingTemplates()
+{
+    if (!TemplateWatcherHandle.IsValid())
+    {
+        return;
+    }
+    
+    // 关闭编辑器时监视模块可能已经卸载
+    if (FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher")))
+    {
+        if (IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule->Get())
+        {
+            DirectoryWatcher->UnregisterDirectoryChangedCallback_Handle(WatchedTemplatesDirectory, TemplateWatcherHandle);
+        }
+    }
+    TemplateWatcherHandle.Reset();
+}
+
+void UComfyUIWorkflowManager::OnTemplateDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
+{
+    TArray<FString> Changed;
+    TArray<FString> Removed;
+    
+    for (const FFileChangeData& Change : FileChanges)
+    {
+        if (Change.Action == FFileChangeData::FCA_RescanRequired)
+        {
+            // 变化太多时监视器要求重新扫描：目录中的文件按修改处理，已注册的文件交给删除检查
+            for (const FString& TemplateFile : UComfyUIFileManager::ScanFilesInDirectory(WatchedTemplatesDirectory, TEXT(".json")))
+            {
+                Changed.AddUnique(WatchedTemplatesDirectory / TemplateFile);
+            }
+            for (const FComfyUIWorkflowEntry& Entry : RegistryEntries)
+            {
+                if (!Entry.bRemoved && !Entry.FileStamp.Path.IsEmpty())
+                {
+                    Removed.AddUnique(Entry.FileStamp.Path);
+                }
+            }
+            continue;
+        }
+        
+        // 与启动时的扫描一致，只处理模板目录下（不含子目录）的 .json 文件
+        if (!Change.Filename.EndsWith(TEXT(".json")) ||
+            !FPaths::IsSamePath(FPaths::GetPath(Change.Filename), WatchedTemplatesDirectory))
+        {
+            continue;
+        }
+        
+        if (Change.Action == FFileChangeData::FCA_Removed)
+        {
+            Removed.AddUnique(Change.Filename);
+        }
+        else
+        {
+            Changed.AddUnique(Change.Filename);
+        }
+    }
+    
+    if (Changed.Num() > 0 || Removed.Num() > 0)
+    {
+        ReloadTemplateFiles(Changed, Removed);
+    }
+}
+
+void UComfyUIWorkflowManager::ReloadTemplateFiles(const TArray<FString>& AddedOrModified, const TArray<FString>& Removed)
+{
+    bool bChanged = false;
+    
+    for (const FString& FilePath : Removed)
+    {
+        // 编辑器保存时可能先删除再重建，文件仍在时按修改处理
+        if (FPaths::FileExists(FilePath))
+        {
+            continue;
+        }
+        
+        const int32* Found = FindNameIndex(FPaths::GetBaseFilename(FilePath));
+        if (Found && FPaths::IsSamePath(RegistryEntries[*Found].FileStamp.Path, FilePath))
+        {
+            UE_LOG(LogTemp, Log, TEXT("ReloadTemplateFiles: Removed workflow: %s"), *CustomWorkflowConfigs[*Found].Name);
+            UnregisterWorkflow(*Found);
+            bChanged = true;
+        }
+    }
+    
+    // 大小和修改时间都没变的文件跳过，同一次保存常会报告多次
+    TArray<FComfyUIWorkflowFileStamp> Stamps;
+    for (const FString& FilePath : AddedOrModified)
+    {
+        if (!FPaths::FileExists(FilePath))
+        {
+            continue;
+        }
+        
+        FComfyUIWorkflowFileStamp Stamp = MakeFileStamp(FilePath);
+        if (const int32* Found = FindNameIndex(FPaths::GetBaseFilename(FilePath)))
+        {
+            const FComfyUIWorkflowFileStamp& Known = RegistryEntries[*Found].FileStamp;
+            if (FPaths::IsSamePath(Known.Path, FilePath) && Known.Size == Stamp.Size && Known.ModificationTime == Stamp.ModificationTime)
+            {
+                continue;
+            }
+        }
+        Stamps.Add(MoveTemp(Stamp));
+    }
+    
+    // 只重新读取和编译变化的文件
+    TArray<FLoadedTemplate> Loaded;
+    Loaded.SetNum(Stamps.Num());
+    ParallelFor(Stamps.Num(), [&Stamps, &Loaded](int32 Index)
+    {
+        LoadTemplateFile(Stamps[Index].Path, Loaded[Index]);
+    });
+    
+    for (int32 Index = 0; Index < Stamps.Num(); ++Index)
+    {
+        const FComfyUIWorkflowFileStamp& Stamp = Stamps[Index];
+        if (!Loaded[Index].Compiled.IsValid())
+        {
+            // 保存到一半或有语法错误的文件不替换当前可用的版本
+            UE_LOG(LogTemp, Warning, TEXT("ReloadTemplateFiles: %s, keeping previous version: %s"), *Loaded[Index].Error, *Stamp.Path);
+            continue;
+        }
+        
+        const int32* Found = FindNameIndex(FPaths::GetBaseFilename(Stamp.Path));
+        if (!Found)
+        {
+            bChanged |= RegisterTemplateFile(Stamp, MoveTemp(Loaded[Index].Content), Loaded[Index].Compiled);
+            continue;
+        }
+        
+        // 同名的工作流已从另一个文件加载，保留已加载的版本，忽略这个文件
+        const FString& KnownPath = RegistryEntries[*Found].FileStamp.Path;
+        if (!KnownPath.IsEmpty() && !FPaths::IsSamePath(KnownPath, Stamp.Path))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("ReloadTemplateFiles: Workflow %s is already loaded from %s, ignoring %s"),
+                   *CustomWorkflowConfigs[*Found].Name, *KnownPath, *Stamp.Path);
+            continue;
+        }
+        
+        bChanged |= ReplaceTemplateFile(*Found, Stamp, MoveTemp(Loaded[Index].Content), Loaded[Index].Compiled);
+    }
+    
+    if (bChanged)
+    {
+        OnWorkflowsChanged.Broadcast();
+    }
+}
+
+bool UComfyUIWorkflowManager::ReplaceTemplateFile(int32 Index, const FComfyUIWorkflowFileStamp& Stamp, FString&& Content, TSharedPtr<const FComfyUICompiledTemplate> Compiled)
+{
+    FComfyUIWorkflowEntry& Entry = RegistryEntries[Index];
+    FWorkflowConfig& Config = CustomWorkflowConfigs[Index];
+    Entry.FileStamp = Stamp;
+    
+    // 只有空白或修改时间变化
+    const uint64 ContentHash = Compiled->GetContentHash();
+    if (Entry.Compiled.IsValid() && Entry.Compiled->GetContentHash() == ContentHash)
+    {
+        return false;
+    }
+    
+    // 与导入时一致，拒绝与其他工作流内容相同的模板
+    if (const int32* Other = ContentHashIndex.Find(ContentHash))
+    {
+        if (*Other != Index)
+            LOG_AND_RETURN(Warning, false, "ReloadTemplateFiles: %s is now identical to workflow %s, keeping previous version",
+                           *Config.Name, *CustomWorkflowConfigs[*Other].Name);
+    }
+    
+    if (Entry.Compiled.IsValid())
+    {
+        const uint64 OldHash = Entry.Compiled->GetContentHash();
+        if (const int32* Owner = ContentHashIndex.Find(OldHash); Owner && *Owner == Index)
+        {
+            ContentHashIndex.Remove(OldHash);
+        }
+    }
+    ContentHashIndex.Add(ContentHash, Index);
+    
+    // 整体替换编译结果；已取出的模板句柄仍持有旧版本，进行中的构建不受影响
+    Entry.Compiled = MoveTemp(Compiled);
+    Entry.OptimizedCompiled.Reset();
+    Config.JsonTemplate = MoveTemp(Content);
+    Config.TemplateFile = Stamp.Path;
+    
+    // 已设置的参数保留；分析结果从缓存取，没有时推迟到下次选中
+    Entry.bAnalyzed = false;
+    if (const FComfyUIWorkflowAnalysis* Cached = GetAnalysisCache().Find(ContentHash))
+    {
+        Cached->ApplyTo(Config);
+        Entry.bAnalyzed = true;
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("ReloadTemplateFiles: Reloaded workflow: %s"), *Config.Name);
+    return true;
+}
+
+void UComfyUIWorkflowManager::UnregisterWorkflow(int32 Index)
+{
+    FComfyUIWorkflowEntry& Entry = RegistryEntries[Index];
+    FWorkflowConfig& Config = CustomWorkflowConfigs[Index];
+    
+    NameIndex.Remove(FName(*Config.Name));
+    if (Entry.Compiled.IsValid())
+    {
+        const uint64 ContentHash = Entry.Compiled->GetContentHash();
+        if (const int32* Owner = ContentHashIndex.Find(ContentHash); Owner && *Owner == Index)
+        {
+            ContentHashIndex.Remove(ContentHash);
+        }
+    }
+    
+    // 已取出的模板句柄仍持有编译结果
+    Entry.Compiled.Reset();
+    Entry.OptimizedCompiled.Reset();
+    Entry.bRemoved = true;
+    Config.JsonTemplate.Empty();
+}
+
 // ========== 工作流验证 ==========
 
 bool UComfyUIWorkflowManager::ValidateWorkflowFile(const FString& FilePath, FString& OutError)
@@ -144,64 +467,14 @@ bool UComfyUIWorkflowManager::ValidateWorkflowJson(const FString& JsonContent, F
     }
     
     // 检查是否是有效的ComfyUI工作流格式
-    bool bHasValidNodes = false;
-    for (const auto& NodePair : WorkflowJson->Values)
-    {
-        const TSharedPtr<FJsonValue>& NodeValue = NodePair.Value;
-        if (NodeValue->Type == EJson::Object)
-        {
-            TSharedPtr<FJsonObject> NodeObj = NodeValue->AsObject();
-            if (NodeObj->HasField(TEXT("class_type")) && NodeObj->HasField(TEXT("inputs")))
-            {
-                bHasValidNodes = true;
-                break;
-            }
-        }
-    }
-    
-    if (!bHasValidNodes)
+    if (!HasValidNodes(WorkflowJson))
     {
         OutError = TEXT("Invalid ComfyUI workflow format: no valid nodes found");
         return false;
     }
     
     // 分析工作流节点
-    if (!AnalyzeWorkflowNodes(WorkflowJson, OutConfig))
-    {
-        OutError = TEXT("Failed to analyze workflow nodes");
-        return false;
-    }
-    
-    // 查找输入和输出节点（保留旧方法作为后备）
-    if (!FindWorkflowInputs(WorkflowJson, OutConfig.RequiredInputs))
-    {
-        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: No input nodes found"));
-    }
-    
-    if (!FindWorkflowOutputs(WorkflowJson, OutConfig.OutputNodes))
-    {
-        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: No output nodes found"));
-    }
-    
-    // 使用新的节点分析器来分析工作流输入输出
-    UComfyUINodeAnalyzer* NodeAnalyzer = NewObject<UComfyUINodeAnalyzer>();
-    TArray<FWorkflowInputInfo> Inputs;
-    TArray<FWorkflowOutputInfo> Outputs;
-    
-    if (NodeAnalyzer->AnalyzeWorkflow(WorkflowJson, Inputs, Outputs))
-    {
-        OutConfig.WorkflowInputs = Inputs;
-        OutConfig.WorkflowOutputs = Outputs;
-        OutConfig.DetectedType = NodeAnalyzer->DetermineWorkflowType(Inputs, Outputs);
-        
-        UE_LOG(LogTemp, Log, TEXT("ValidateWorkflowJson: Node analysis successful. Found %d workflow inputs and %d outputs"), 
-               Inputs.Num(), Outputs.Num());
-    }
-    else
-    {
-        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: Node analysis failed, using legacy method"));
-        OutConfig.DetectedType = EComfyUIWorkflowType::Unknown;
-    }
+    AnalyzeWorkflowConfig(WorkflowJson, OutConfig);
     
     OutConfig.bIsValid = true;
     OutConfig.JsonTemplate = JsonContent;
@@ -244,47 +517,118 @@ bool UComfyUIWorkflowManager::ImportWorkflowFile(const FString& FilePath, const
     NewWorkflow.Type = TEXT("custom");
     NewWorkflow.Description = FString::Printf(TEXT("Custom workflow: %s"), *NewWorkflow.Name);
     NewWorkflow.JsonTemplate = JsonContent;
-    NewWorkflow.TemplateFile = FilePath;
     
-    // 使用FileManager保存到插件目录
-    FString ImportError;
-    if (!UComfyUIFileManager::ImportWorkflowTemplate(FilePath, NewWorkflow.Name, ImportError))
+    // 复制到插件目录之前拒绝重复的名称和内容
+    TSharedPtr<const FComfyUICompiledTemplate> Compiled = FComfyUICompiledTemplate::Compile(JsonContent);
+    if (IsDuplicateWorkflow(NewWorkflow.Name, Compiled.Get(), OutError))
     {
-        OutError = ImportError;
         return false;
     }
     
-    // 添加到配置列表
-    CustomWorkflowConfigs.Add(NewWorkflow);
+    // 复制到模板目录，之后以副本为准；UComfyUIFileManager::ImportWorkflowTemplate 会转回这里，不能用它复制
+    const FString TemplatePath = UComfyUIFileManager::GetTemplatesDirectory() / (NewWorkflow.Name + TEXT(".json"));
+    if (!FPaths::IsSamePath(TemplatePath, FilePath) && IFileManager::Get().Copy(*TemplatePath, *FilePath) != COPY_OK)
+    {
+        OutError = FString::Printf(TEXT("Failed to copy workflow to templates directory: %s"), *TemplatePath);
+        return false;
+    }
+    NewWorkflow.TemplateFile = TemplatePath;
+    
+    // 添加到配置列表，记录副本的文件信息，模板目录中的副本被修改或删除时随之重新加载或注销
+    const FString ImportedName = NewWorkflow.Name;
+    FComfyUIWorkflowEntry Entry;
+    Entry.FileStamp = MakeFileStamp(TemplatePath);
+    Entry.Compiled = Compiled;
+    Entry.bAnalyzed = true;
+    const FComfyUIWorkflowHandle Handle = RegisterWorkflow(MoveTemp(NewWorkflow), MoveTemp(Entry), OutError);
+    if (!Handle.IsValid())
+    {
+        return false;
+    }
+    CacheWorkflowAnalysis(Handle.Index);
     
-    UE_LOG(LogTemp, Log, TEXT("ImportWorkflowFile: Successfully imported workflow: %s"), *NewWorkflow.Name);
+    UE_LOG(LogTemp, Log, TEXT("ImportWorkflowFile: Successfully imported workflow: %s"), *ImportedName);
     return true;
 }
 
 // ========== 工作流JSON构建 ==========
-#pragma optimize("", off)
+
 FString UComfyUIWorkflowManager::BuildWorkflowJson(const FString& CustomWorkflowName)
 {
-    // 查找自定义工作流配置
-    FWorkflowConfig* CustomConfig = FindWorkflowConfigInternal(CustomWorkflowName);
+    return BuildWorkflowRequest(CustomWorkflowName, FComfyUITemplateBindings());
+}
+
+FString UComfyUIWorkflowManager::BuildWorkflowRequest(const FString& WorkflowName, const FComfyUITemplateBindings& Bindings)
+{
+    const FComfyUIWorkflowTemplate Template = GetWorkflowTemplate(WorkflowName);
+    if (!Template.IsValid())
+        return TEXT("{}");
+    
+    // 单遍写出请求JSON
+    FString OutputString = Template.BuildRequest(Bindings);
+
+    UE_LOG(LogTemp, Verbose, TEXT("BuildCustomWorkflowJson: Successfully built workflow JSON for: %s"), *WorkflowName);
+    return OutputString;
+}
+
+FComfyUIWorkflowTemplate UComfyUIWorkflowManager::GetWorkflowTemplate(const FString& WorkflowName)
+{
+    const FComfyUIWorkflowHandle Handle = FindWorkflow(WorkflowName);
+    if (!Handle.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("GetWorkflowTemplate: Custom workflow not found: %s"), *WorkflowName);
+        FComfyUIWorkflowTemplate Template;
+        Template.WorkflowName = WorkflowName;
+        return Template;
+    }
+    
+    return GetWorkflowTemplate(Handle);
+}
+
+FComfyUIWorkflowTemplate UComfyUIWorkflowManager::GetWorkflowTemplate(const FComfyUIWorkflowHandle& Handle)
+{
+    FComfyUIWorkflowTemplate Template;
+    
+    const FWorkflowConfig* CustomConfig = GetWorkflowConfig(Handle);
     if (!CustomConfig)
-        LOG_AND_RETURN(Error, TEXT("{}"), "BuildCustomWorkflowJson: Custom workflow not found: %s", *CustomWorkflowName);
+        LOG_AND_RETURN(Error, Template, "GetWorkflowTemplate: Stale or invalid workflow handle");
     
-    // 创建请求JSON对象
-    TSharedPtr<FJsonObject> RequestJson = MakeShareable(new FJsonObject);
-    RequestJson->SetStringField(TEXT("client_id"), TEXT("unreal_engine_plugin"));
+    Template.WorkflowName = CustomConfig->Name;
+    Template.Compiled = RegistryEntries[Handle.Index].bOptimizeGraph ? GetOptimizedTemplate(Handle.Index) : GetCompiledTemplate(Handle.Index);
+    if (!Template.Compiled.IsValid())
+        LOG_AND_RETURN(Error, Template, "GetWorkflowTemplate: No valid template for custom workflow: %s", *CustomConfig->Name);
+    
+    // 已设置的参数按字符串快照，之后的 SetWorkflowParameter 不影响这个句柄
+    TSharedRef<FComfyUITemplateBindings> Defaults = MakeShared<FComfyUITemplateBindings>();
+    Defaults->Reserve(CustomConfig->Parameters.Num());
+    for (const TPair<FString, FString>& Param : CustomConfig->Parameters)
+    {
+        Defaults->Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
+    }
+    Template.Defaults = Defaults;
+    
+    return Template;
+}
 
+TSharedPtr<const FComfyUICompiledTemplate> UComfyUIWorkflowManager::GetCompiledTemplate(int32 Index)
+{
+    if (RegistryEntries[Index].Compiled.IsValid())
+    {
+        return RegistryEntries[Index].Compiled;
+    }
+    
+    FWorkflowConfig& Config = CustomWorkflowConfigs[Index];
+    
     // 获取工作流模板
     FString WorkflowTemplate;
-    if (!CustomConfig->JsonTemplate.IsEmpty())
+    if (!Config.JsonTemplate.IsEmpty())
     {
-        WorkflowTemplate = CustomConfig->JsonTemplate;
-        UE_LOG(LogTemp, Log, TEXT("BuildCustomWorkflowJson: Using cached template content"));
+        WorkflowTemplate = Config.JsonTemplate;
     }
-    else if (!CustomConfig->TemplateFile.IsEmpty())
+    else if (!Config.TemplateFile.IsEmpty())
     {
         // 从文件加载模板
-        FString TemplateFilePath = CustomConfig->TemplateFile;
+        FString TemplateFilePath = Config.TemplateFile;
         if (FPaths::IsRelative(TemplateFilePath))
         {
             FString TemplatesDir = UComfyUIFileManager::GetTemplatesDirectory();
@@ -294,46 +638,85 @@ FString UComfyUIWorkflowManager::BuildWorkflowJson(const FString& CustomWorkflow
         UE_LOG(LogTemp, Log, TEXT("BuildCustomWorkflowJson: Loading template from file: %s"), *TemplateFilePath);
         
         if (!UComfyUIFileManager::LoadJsonFromFile(TemplateFilePath, WorkflowTemplate))
-            LOG_AND_RETURN(Error, TEXT("{}"), "BuildCustomWorkflowJson: Failed to load workflow template file: %s", *TemplateFilePath);
+            LOG_AND_RETURN(Error, nullptr, "BuildCustomWorkflowJson: Failed to load workflow template file: %s", *TemplateFilePath);
         
         // 缓存模板内容以供下次使用
-        CustomConfig->JsonTemplate = WorkflowTemplate;
+        Config.JsonTemplate = WorkflowTemplate;
     }
     else
     {
-        LOG_AND_RETURN(Error, TEXT("{}"), "BuildCustomWorkflowJson: No template found for custom workflow: %s", *CustomWorkflowName);
+        LOG_AND_RETURN(Error, nullptr, "BuildCustomWorkflowJson: No template found for custom workflow: %s", *Config.Name);
     }
+    
+    FString CompileError;
+    TSharedPtr<const FComfyUICompiledTemplate> Compiled = FComfyUICompiledTemplate::Compile(WorkflowTemplate, &CompileError);
+    if (!Compiled.IsValid())
+        LOG_AND_RETURN(Error, nullptr, "BuildCustomWorkflowJson: Failed to compile template for %s: %s", *Config.Name, *CompileError);
+    
+    RegistryEntries[Index].Compiled = Compiled;
+    ContentHashIndex.FindOrAdd(Compiled->GetContentHash(), Index);
+    return Compiled;
+}
 
-    // 替换占位符
-    FString ProcessedWorkflow = ReplaceWorkflowPlaceholders(WorkflowTemplate, CustomConfig->Parameters);
+TSharedPtr<const FComfyUICompiledTemplate> UComfyUIWorkflowManager::GetOptimizedTemplate(int32 Index)
+{
+    if (RegistryEntries[Index].OptimizedCompiled.IsValid())
+    {
+        return RegistryEntries[Index].OptimizedCompiled;
+    }
     
-    // 解析处理后的工作流JSON
-    TSharedPtr<FJsonObject> FinalWorkflowJson;
-    TSharedRef<TJsonReader<>> FinalReader = TJsonReaderFactory<>::Create(ProcessedWorkflow);
-    if (FJsonSerializer::Deserialize(FinalReader, FinalWorkflowJson))
+    TSharedPtr<const FComfyUICompiledTemplate> Compiled = GetCompiledTemplate(Index);
+    if (!Compiled.IsValid())
     {
-        RequestJson->SetObjectField(TEXT("prompt"), FinalWorkflowJson);
+        return nullptr;
     }
-    else
+    
+    // 占位符都在字符串中，模板本身就是合法的节点表，优化后的文本重新编译一次
+    const FString& Name = CustomWorkflowConfigs[Index].Name;
+    FString OptimizedJson = CustomWorkflowConfigs[Index].JsonTemplate;
+    FComfyUIGraphOptimizeStats GraphStats;
+    FString GraphError;
+    if (FComfyUIWorkflowGraph::OptimizeRequest(OptimizedJson, GraphStats, &GraphError))
     {
-        LOG_AND_RETURN(Error, TEXT("{}"), "BuildCustomWorkflowJson: Failed to deserialize final workflow JSON");
+        FString CompileError;
+        if (TSharedPtr<const FComfyUICompiledTemplate> Optimized = FComfyUICompiledTemplate::Compile(OptimizedJson, &CompileError))
+        {
+            UE_LOG(LogTemp, Log, TEXT("GetOptimizedTemplate: Optimized workflow graph of %s: %s"), *Name, *GraphStats.ToString());
+            Compiled = Optimized;
+        }
+        else
+        {
+            UE_LOG(LogTemp, Warning, TEXT("GetOptimizedTemplate: Failed to compile optimized template for %s, using original: %s"), *Name, *CompileError);
+        }
     }
-
-    // 序列化最终的请求JSON
-    FString OutputString;
-    TSharedRef<TJsonWriter<>> OutputWriter = TJsonWriterFactory<>::Create(&OutputString);
-    FJsonSerializer::Serialize(RequestJson.ToSharedRef(), OutputWriter);
-
-    UE_LOG(LogTemp, Log, TEXT("BuildCustomWorkflowJson: Successfully built workflow JSON for: %s"), *CustomWorkflowName);
-    return OutputString;
+    else if (!GraphError.IsEmpty())
+    {
+        UE_LOG(LogTemp, Warning, TEXT("GetOptimizedTemplate: Skipped workflow graph optimization for %s: %s"), *Name, *GraphError);
+    }
+    
+    RegistryEntries[Index].OptimizedCompiled = Compiled;
+    return Compiled;
 }
-#pragma optimize("", on)
+
 FString UComfyUIWorkflowManager::ReplaceWorkflowPlaceholders(const FString& WorkflowTemplate, 
                                                            const TMap<FString, FString>& CustomParameters)
 {
-    FString ProcessedTemplate = WorkflowTemplate;
+    FComfyUITemplateBindings Bindings;
+    for (const auto& Param : CustomParameters)
+    {
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
+    }
+    
+    // 合法的工作流JSON编译后单遍替换，替换的值会正确转义
+    if (TSharedPtr<const FComfyUICompiledTemplate> Compiled = FComfyUICompiledTemplate::Compile(WorkflowTemplate))
+    {
+        FString ProcessedTemplate;
+        Compiled->Write(Bindings, ProcessedTemplate);
+        return ProcessedTemplate;
+    }
     
-    // 替换自定义参数
+    // 不是合法JSON的模板按文本替换
+    FString ProcessedTemplate = WorkflowTemplate;
     for (const auto& Param : CustomParameters)
     {
         FString Placeholder = FString::Printf(TEXT("{%s}"), *Param.Key.ToUpper());
@@ -373,11 +756,29 @@ FString UComfyUIWorkflowManager::GetWorkflowParameter(const FString& WorkflowNam
     return FString();
 }
 
+bool UComfyUIWorkflowManager::SetWorkflowGraphOptimization(const FString& WorkflowName, bool bEnabled)
+{
+    const int32* Index = FindNameIndex(WorkflowName);
+    if (!Index)
+        LOG_AND_RETURN(Warning, false, "SetWorkflowGraphOptimization: Workflow not found: %s", *WorkflowName);
+    
+    // 优化结果在下次取模板时生成；关闭时释放，已取出的模板句柄仍持有
+    FComfyUIWorkflowEntry& Entry = RegistryEntries[*Index];
+    Entry.bOptimizeGraph = bEnabled;
+    if (!bEnabled)
+    {
+        Entry.OptimizedCompiled.Reset();
+    }
+    
+    UE_LOG(LogTemp, Log, TEXT("SetWorkflowGraphOptimization: %s graph optimization for %s"), bEnabled ? TEXT("Enabled") : TEXT("Disabled"), *WorkflowName);
+    return true;
+}
+
 // ========== 工具函数 ==========
 
 void UComfyUIWorkflowManager::ClearWorkflowConfigs()
 {
-    CustomWorkflowConfigs.Empty();
+    ResetRegistry();
     UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowManager: Cleared all workflow configurations"));
 }
 
@@ -519,26 +920,225 @@ FString UComfyUIWorkflowManager::SanitizeWorkflowName(const FString& Name) const
 
 FWorkflowConfig* UComfyUIWorkflowManager::FindWorkflowConfigInternal(const FString& WorkflowName)
 {
-    for (FWorkflowConfig& Config : CustomWorkflowConfigs)
+    const int32* Found = FindNameIndex(WorkflowName);
+    return Found ? &CustomWorkflowConfigs[*Found] : nullptr;
+}
+
+const FWorkflowConfig* UComfyUIWorkflowManager::FindWorkflowConfigInternal(const FString& WorkflowName) const
+{
+    const int32* Found = FindNameIndex(WorkflowName);
+    return Found ? &CustomWorkflowConfigs[*Found] : nullptr;
+}
+
+// ========== 工作流注册表 ==========
+
+const int32* UComfyUIWorkflowManager::FindNameIndex(const FString& WorkflowName) const
+{
+    // FNAME_Find 对从未出现过的名称返回 NAME_None，不能拿它去查索引，否则会命中名为 "None" 的条目
+    const FName Name(*WorkflowName, FNAME_Find);
+    return Name.IsNone() ? nullptr : NameIndex.Find(Name);
+}
+
+FComfyUIWorkflowHandle UComfyUIWorkflowManager::FindWorkflow(const FString& WorkflowName) const
+{
+    FComfyUIWorkflowHandle Handle;
+    if (const int32* Found = FindNameIndex(WorkflowName))
     {
-        if (Config.Name == WorkflowName)
-        {
-            return &Config;
-        }
+        Handle.Index = *Found;
+        Handle.Generation = RegistryGeneration;
     }
-    return nullptr;
+    return Handle;
 }
 
-const FWorkflowConfig* UComfyUIWorkflowManager::FindWorkflowConfigInternal(const FString& WorkflowName) const
+const FWorkflowConfig* UComfyUIWorkflowManager::GetWorkflowConfig(const FComfyUIWorkflowHandle& Handle) const
+{
+    if (Handle.Generation != RegistryGeneration || !CustomWorkflowConfigs.IsValidIndex(Handle.Index) ||
+        RegistryEntries[Handle.Index].bRemoved)
+    {
+        return nullptr;
+    }
+    return &CustomWorkflowConfigs[Handle.Index];
+}
+
+bool UComfyUIWorkflowManager::IsDuplicateWorkflow(const FString& WorkflowName, const FComfyUICompiledTemplate* Compiled, FString& OutError) const
 {
-    for (const FWorkflowConfig& Config : CustomWorkflowConfigs)
+    // "None" 与 NAME_None 相同，注册后无法按名称区分
+    if (FName(*WorkflowName).IsNone())
     {
-        if (Config.Name == WorkflowName)
+        OutError = FString::Printf(TEXT("Invalid workflow name: %s"), *WorkflowName);
+        return true;
+    }
+    
+    if (FindNameIndex(WorkflowName))
+    {
+        OutError = FString::Printf(TEXT("Workflow already exists: %s"), *WorkflowName);
+        return true;
+    }
+    
+    if (Compiled)
+    {
+        if (const int32* Found = ContentHashIndex.Find(Compiled->GetContentHash()))
         {
-            return &Config;
+            OutError = FString::Printf(TEXT("Workflow content is identical to existing workflow: %s"), *CustomWorkflowConfigs[*Found].Name);
+            return true;
         }
     }
-    return nullptr;
+    
+    return false;
+}
+
+FComfyUIWorkflowHandle UComfyUIWorkflowManager::RegisterWorkflow(FWorkflowConfig&& Config, FComfyUIWorkflowEntry&& Entry, FString& OutError)
+{
+    if (IsDuplicateWorkflow(Config.Name, Entry.Compiled.Get(), OutError))
+    {
+        return FComfyUIWorkflowHandle();
+    }
+    
+    const FName Name(*Config.Name);
+    const int32 Index = CustomWorkflowConfigs.Add(MoveTemp(Config));
+    NameIndex.Add(Name, Index);
+    if (Entry.Compiled.IsValid())
+    {
+        ContentHashIndex.Add(Entry.Compiled->GetContentHash(), Index);
+    }
+    RegistryEntries.Add(MoveTemp(Entry));
+    
+    FComfyUIWorkflowHandle Handle;
+    Handle.Index = Index;
+    Handle.Generation = RegistryGeneration;
+    return Handle;
+}
+
+bool UComfyUIWorkflowManager::RegisterTemplateFile(const FComfyUIWorkflowFileStamp& Stamp, FString&& Content, TSharedPtr<const FComfyUICompiledTemplate> Compiled)
+{
+    // 创建工作流配置，输入输出在第一次选中时再分析
+    FWorkflowConfig NewWorkflow;
+    FString FileName = FPaths::GetBaseFilename(Stamp.Path);
+    NewWorkflow.Name = FileName;
+    NewWorkflow.Type = TEXT("custom");
+    NewWorkflow.Description = FString::Printf(TEXT("Custom workflow loaded from %s"), *FileName);
+    NewWorkflow.JsonTemplate = MoveTemp(Content);
+    NewWorkflow.TemplateFile = Stamp.Path;
+    NewWorkflow.bIsValid = true;
+    
+    FComfyUIWorkflowEntry Entry;
+    Entry.Compiled = MoveTemp(Compiled);
+    Entry.FileStamp = Stamp;
+    
+    // 内容未变的模板直接使用缓存的分析结果
+    if (const FComfyUIWorkflowAnalysis* Cached = GetAnalysisCache().Find(Entry.Compiled->GetContentHash()))
+    {
+        Cached->ApplyTo(NewWorkflow);
+        Entry.bAnalyzed = true;
+    }
+    
+    FString RegisterError;
+    if (!RegisterWorkflow(MoveTemp(NewWorkflow), MoveTemp(Entry), RegisterError).IsValid())
+        LOG_AND_RETURN(Warning, false, "LoadCustomWorkflowFromFile: Skipped %s: %s", *Stamp.Path, *RegisterError);
+    
+    UE_LOG(LogTemp, Verbose, TEXT("LoadCustomWorkflowFromFile: Successfully loaded workflow: %s"), *FileName);
+    return true;
+}
+
+bool UComfyUIWorkflowManager::EnsureWorkflowAnalyzed(const FComfyUIWorkflowHandle& Handle)
+{
+    if (!GetWorkflowConfig(Handle))
+    {
+        return false;
+    }
+    
+    FComfyUIWorkflowEntry& Entry = RegistryEntries[Handle.Index];
+    if (Entry.bAnalyzed)
+    {
+        return true;
+    }
+    
+    FWorkflowConfig& Config = CustomWorkflowConfigs[Handle.Index];
+    TSharedPtr<FJsonObject> WorkflowJson;
+    if (!UComfyUIFileManager::ParseJsonString(Config.JsonTemplate, WorkflowJson))
+        LOG_AND_RETURN(Error, false, "EnsureWorkflowAnalyzed: Invalid JSON in workflow template: %s", *Config.Name);
+    
+    AnalyzeWorkflowConfig(WorkflowJson, Config);
+    Entry.bAnalyzed = true;
+    CacheWorkflowAnalysis(Handle.Index);
+    return true;
+}
+
+void UComfyUIWorkflowManager::ResetRegistry()
+{
+    CustomWorkflowConfigs.Empty();
+    RegistryEntries.Empty();
+    NameIndex.Empty();
+    ContentHashIndex.Empty();
+    ++RegistryGeneration;
+}
+
+void UComfyUIWorkflowManager::AnalyzeWorkflowConfig(TSharedPtr<FJsonObject> WorkflowJson, FWorkflowConfig& OutConfig)
+{
+    AnalyzeWorkflowNodes(WorkflowJson, OutConfig);
+    
+    // 查找输入和输出节点（保留旧方法作为后备）
+    if (!FindWorkflowInputs(WorkflowJson, OutConfig.RequiredInputs))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: No input nodes found"));
+    }
+    
+    if (!FindWorkflowOutputs(WorkflowJson, OutConfig.OutputNodes))
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: No output nodes found"));
+    }
+    
+    // 使用新的节点分析器来分析工作流输入输出
+    UComfyUINodeAnalyzer* Analyzer = GetNodeAnalyzer();
+    TArray<FWorkflowInputInfo> Inputs;
+    TArray<FWorkflowOutputInfo> Outputs;
+    
+    if (Analyzer->AnalyzeWorkflow(WorkflowJson, Inputs, Outputs))
+    {
+        OutConfig.DetectedType = Analyzer->DetermineWorkflowType(Inputs, Outputs);
+        OutConfig.WorkflowInputs = MoveTemp(Inputs);
+        OutConfig.WorkflowOutputs = MoveTemp(Outputs);
+        
+        UE_LOG(LogTemp, Log, TEXT("ValidateWorkflowJson: Node analysis successful. Found %d workflow inputs and %d outputs"), 
+               OutConfig.WorkflowInputs.Num(), OutConfig.WorkflowOutputs.Num());
+    }
+    else
+    {
+        UE_LOG(LogTemp, Warning, TEXT("ValidateWorkflowJson: Node analysis failed, using legacy method"));
+        OutConfig.DetectedType = EComfyUIWorkflowType::Unknown;
+    }
+}
+
+UComfyUINodeAnalyzer* UComfyUIWorkflowManager::GetNodeAnalyzer()
+{
+    if (!NodeAnalyzer)
+    {
+        NodeAnalyzer = NewObject<UComfyUINodeAnalyzer>(this);
+    }
+    return NodeAnalyzer;
+}
+
+FComfyUIWorkflowAnalysisCache& UComfyUIWorkflowManager::GetAnalysisCache()
+{
+    if (!AnalysisCache.IsValid())
+    {
+        AnalysisCache = MakeShared<FComfyUIWorkflowAnalysisCache>(UComfyUIFileManager::GetCacheDirectory() / TEXT("WorkflowAnalysis.bin"));
+        AnalysisCache->Load();
+    }
+    return *AnalysisCache;
+}
+
+void UComfyUIWorkflowManager::CacheWorkflowAnalysis(int32 Index)
+{
+    const TSharedPtr<const FComfyUICompiledTemplate>& Compiled = RegistryEntries[Index].Compiled;
+    if (!Compiled.IsValid())
+    {
+        return;
+    }
+    
+    FComfyUIWorkflowAnalysisCache& Cache = GetAnalysisCache();
+    Cache.Add(Compiled->GetContentHash(), FComfyUIWorkflowAnalysis::FromConfig(CustomWorkflowConfigs[Index]));
+    Cache.Save();
 }
 
 // ========== 工作流类型检测 ==========
@@ -550,6 +1150,13 @@ EComfyUIWorkflowType UComfyUIWorkflowManager::DetectWorkflowType(const FString&
     
     if (WorkflowName.IsEmpty()) return DetectedType;
     
+    // 已注册的工作流在第一次选中时做完整的节点分析，之后直接返回结果
+    const FComfyUIWorkflowHandle Handle = FindWorkflow(WorkflowName);
+    if (EnsureWorkflowAnalyzed(Handle))
+    {
+        return CustomWorkflowConfigs[Handle.Index].DetectedType;
+    }
+    
     // 构建工作流文件路径
     FString TemplatesDir = FPaths::ProjectPluginsDir() / TEXT("ComfyUIIntegration/Config/Templates");
     FString WorkflowFile = TemplatesDir / (WorkflowName + TEXT(".json"));
@@ -595,7 +1202,7 @@ EComfyUIWorkflowType UComfyUIWorkflowManager::DetectWorkflowType(const FString&
 EComfyUIWorkflowType UComfyUIWorkflowManager::AnalyzEComfyUIWorkflowTypeFromConfig(const FWorkflowConfig& Config)
 {
     // 使用新的节点分析器来分析工作流类型
-    UComfyUINodeAnalyzer* NodeAnalyzer = NewObject<UComfyUINodeAnalyzer>();
+    UComfyUINodeAnalyzer* Analyzer = GetNodeAnalyzer();
     
     // 解析工作流JSON
     TSharedPtr<FJsonObject> WorkflowJson;
@@ -611,14 +1218,14 @@ EComfyUIWorkflowType UComfyUIWorkflowManager::AnalyzEComfyUIWorkflowTypeFromConf
     TArray<FWorkflowInputInfo> Inputs;
     TArray<FWorkflowOutputInfo> Outputs;
     
-    if (!NodeAnalyzer->AnalyzeWorkflow(WorkflowJson, Inputs, Outputs))
+    if (!Analyzer->AnalyzeWorkflow(WorkflowJson, Inputs, Outputs))
     {
         UE_LOG(LogTemp, Error, TEXT("AnalyzEComfyUIWorkflowTypeFromConfig: Failed to analyze workflow for config: %s"), *Config.Name);
         return EComfyUIWorkflowType::Unknown;
     }
     
     // 确定工作流类型
-    EComfyUIWorkflowType DetectedType = NodeAnalyzer->DetermineWorkflowType(Inputs, Outputs);
+    EComfyUIWorkflowType DetectedType = Analyzer->DetermineWorkflowType(Inputs, Outputs);
     
     UE_LOG(LogTemp, Log, TEXT("AnalyzEComfyUIWorkflowTypeFromConfig: Analyzed workflow '%s' - Found %d inputs, %d outputs, Type: %d"), 
            *Config.Name, Inputs.Num(), Outputs.Num(), (int32)DetectedType);
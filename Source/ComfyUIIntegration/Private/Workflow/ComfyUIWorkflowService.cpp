@@ -49,8 +49,9 @@ void UComfyUIWorkflowService::Initialize()
     {
         WorkflowManager->AddToRoot(); // 防止被垃圾回收
         WorkflowManager->SetFlags(RF_Transient); // 设置为临时对象，避免在编辑器中保存时被序列化
-        // 加载工作流配置
+        // 加载工作流配置，之后模板目录中的修改自动重新加载
         WorkflowManager->LoadWorkflowConfigs();
+        WorkflowManager->StartWatchingTemplates();
         bInitialized = true;
         
         UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowService: Successfully initialized"));
@@ -70,6 +71,11 @@ void UComfyUIWorkflowService::Shutdown()
     
     UE_LOG(LogTemp, Log, TEXT("UComfyUIWorkflowService: Shutting down workflow service"));
     
+    if (WorkflowManager)
+    {
+        WorkflowManager->StopWatchingTemplates();
+    }
+    
     // if (WorkflowManager)
     // {
     //     WorkflowManager->ClearWorkflowConfigs();
@@ -126,44 +132,73 @@ bool UComfyUIWorkflowService::ImportWorkflow(const FString& FilePath, const FStr
 
 // ========== JSON构建接口 ==========
 
-#pragma optimize("", off)
-
 FString UComfyUIWorkflowService::BuildWorkflowJson(const FString& WorkflowName, 
                                                    const FComfyUIWorkflowInput& Input)
+{
+    const FComfyUIWorkflowTemplate Template = GetWorkflowTemplate(WorkflowName);
+    if (!Template.IsValid())
+        LOG_AND_RETURN(Error, FString(), "BuildWorkflowJson: No valid template for workflow: %s", *WorkflowName);
+    
+    // 构建并返回工作流JSON
+    return Template.BuildRequest(MakeBindings(Input));
+}
+
+FComfyUIWorkflowTemplate UComfyUIWorkflowService::GetWorkflowTemplate(const FString& WorkflowName)
 {
     if (!WorkflowManager)
-        LOG_AND_RETURN(Error, FString(), "BuildWorkflowJson: WorkflowManager is null");
+        LOG_AND_RETURN(Error, FComfyUIWorkflowTemplate(), "GetWorkflowTemplate: WorkflowManager is null");
     
-    // 添加文本参数
-    for (const auto& Param : Input.TextParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, Param.Value);
+    return WorkflowManager->GetWorkflowTemplate(WorkflowName);
+}
+
+FComfyUIWorkflowTemplate UComfyUIWorkflowService::GetWorkflowTemplate(const FComfyUIWorkflowHandle& Handle)
+{
+    if (!WorkflowManager)
+        LOG_AND_RETURN(Error, FComfyUIWorkflowTemplate(), "GetWorkflowTemplate: WorkflowManager is null");
     
-    // 添加图像参数
-    for (const auto& Param : Input.ImageParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, Param.Value);
+    return WorkflowManager->GetWorkflowTemplate(Handle);
+}
+
+FComfyUIWorkflowHandle UComfyUIWorkflowService::FindWorkflow(const FString& WorkflowName) const
+{
+    if (!WorkflowManager)
+        LOG_AND_RETURN(Error, FComfyUIWorkflowHandle(), "FindWorkflow: WorkflowManager is null");
     
-    // 添加网格参数
+    return WorkflowManager->FindWorkflow(WorkflowName);
+}
+
+FOnComfyUIWorkflowsChanged& UComfyUIWorkflowService::OnWorkflowsChanged()
+{
+    check(WorkflowManager);
+    return WorkflowManager->OnWorkflowsChanged;
+}
+
+FComfyUITemplateBindings UComfyUIWorkflowService::MakeBindings(const FComfyUIWorkflowInput& Input)
+{
+    FComfyUITemplateBindings Bindings;
+    Bindings.Reserve(Input.TextParameters.Num() + Input.ImageParameters.Num() + Input.MeshParameters.Num() +
+                     Input.NumericParameters.Num() + Input.BooleanParameters.Num() + Input.ChoiceParameters.Num());
+    
+    // 文本、图像、网格和选择参数
+    for (const auto& Param : Input.TextParameters)
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
+    for (const auto& Param : Input.ImageParameters)
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
     for (const auto& Param : Input.MeshParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, Param.Value);
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
     
-    // 添加数值参数（转换为字符串）
+    // 数值和布尔参数按类型绑定，占位符是整个值时写为 JSON 数字和布尔值
     for (const auto& Param : Input.NumericParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, FString::SanitizeFloat(Param.Value));
-    
-    // 添加布尔参数（转换为字符串）
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeNumber(Param.Value));
     for (const auto& Param : Input.BooleanParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, Param.Value ? TEXT("true") : TEXT("false"));
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeBoolean(Param.Value));
     
-    // 添加选择参数
     for (const auto& Param : Input.ChoiceParameters)
-        WorkflowManager->SetWorkflowParameter(WorkflowName, Param.Key, Param.Value);
+        Bindings.Add(Param.Key.ToUpper(), FComfyUITemplateValue::MakeString(Param.Value));
     
-    // 构建并返回工作流JSON
-    return WorkflowManager->BuildWorkflowJson(WorkflowName);
+    return Bindings;
 }
 
-#pragma optimize("", on)
-
 // ========== 参数管理接口 ==========
 
 bool UComfyUIWorkflowService::SetWorkflowParameter(const FString& WorkflowName, const FString& ParameterName, const FString& Value)
@@ -182,6 +217,14 @@ FString UComfyUIWorkflowService::GetWorkflowParameter(const FString& WorkflowNam
     return WorkflowManager->GetWorkflowParameter(WorkflowName, ParameterName);
 }
 
+bool UComfyUIWorkflowService::SetWorkflowGraphOptimization(const FString& WorkflowName, bool bEnabled)
+{
+    if (!WorkflowManager)
+        LOG_AND_RETURN(Error, false, "SetWorkflowGraphOptimization: WorkflowManager is null");
+    
+    return WorkflowManager->SetWorkflowGraphOptimization(WorkflowName, bEnabled);
+}
+
 // ========== 便捷接口 ==========
 
 EComfyUIWorkflowType UComfyUIWorkflowService::DetectWorkflowType(const FString &WorkflowName)
@@ -63,6 +63,10 @@ public:
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|3D")
     static UStaticMesh* CreateStaticMeshFromGLTF(const TArray<uint8>& GLTFData);
 
+    /** 从磁盘上的模型文件创建静态网格，格式为空时按扩展名判断 */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|3D")
+    static UStaticMesh* CreateStaticMeshFromFile(const FString& FilePath, const FString& ModelFormat = TEXT(""));
+
     /** 保存3D模型到项目资产 */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|3D")
     static bool Save3DModelToProject(UStaticMesh* StaticMesh, const FString& AssetName, const FString& PackagePath = TEXT("/Game/ComfyUI/Generated/Models"));
@@ -85,6 +89,10 @@ public:
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|3D")
     static bool SaveOriginalModelData(const TArray<uint8>& OriginalData, const FString& FilePath);
 
+    /** 复制原始glTF/GLB文件到目标路径 */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|3D")
+    static bool CopyOriginalModelFile(const FString& SourceFilePath, const FString& FilePath);
+
     // === 材质和纹理处理 ===
     
     /** 为3D模型创建材质 */
@@ -120,6 +128,7 @@ private:
     static UStaticMesh* CreateStaticMeshFromVertices(const TArray<FVector>& Vertices, const TArray<int32>& Indices, const TArray<FVector2D>& UVs);
     static bool ParseOBJData(const TArray<uint8>& OBJData, TArray<FVector>& OutVertices, TArray<int32>& OutIndices, TArray<FVector2D>& OutUVs);
     static FString GenerateUniqueAssetName(const FString& BaseName, const FString& PackagePath);
+    static UStaticMesh* ImportGLTFFile(const FString& FilePath, const FString& DestinationName);
     static UStaticMesh* CreateFallbackMeshFromGLTF(const TArray<uint8>& GLTFData);
     static UStaticMesh* ParseGLBData(const TArray<uint8>& GLBData);
     static UStaticMesh* ParseGLTFJson(const FString& JsonContent);
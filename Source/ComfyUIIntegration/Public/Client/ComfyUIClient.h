@@ -8,6 +8,13 @@
 #include "ComfyUITypes.h"
 #include "Workflow/ComfyUIWorkflowConfig.h"
 #include "Network/ComfyUINetworkManager.h"
+#include "Network/ComfyUIWebSocketChannel.h"
+#include "Network/ComfyUIStatusEngine.h"
+#include "Network/ComfyUIUploadCache.h"
+#include "Network/ComfyUIServerPool.h"
+#include "Client/ComfyUIJob.h"
+#include "Client/ComfyUIResultCache.h"
+#include "Client/ComfyUITimerWheel.h"
 #include "ComfyUIExecutionTypes.h"
 
 #include "ComfyUIClient.generated.h"
@@ -32,34 +39,81 @@ public:
     /** 销毁单例实例 - 仅在插件关闭时调用 */
     static void DestroyInstance();
 
-    /** 设置ComfyUI服务器URL */
+    /** 设置ComfyUI服务器URL（只使用一台服务器） */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI")
     void SetServerUrl(const FString& Url);
 
-    /** 取消当前生成任务 */
+    /** 设置服务器池，新任务分配到负载最低的可用服务器 */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI")
+    void SetServerUrls(const TArray<FString>& Urls);
+
+    /** 为新任务选择服务器。调用方应把同一任务的上传和执行都指向返回的服务器 */
+    FString SelectServer();
+
+    /** 服务器池当前状态 */
+    const TArray<FComfyUIServerStatus>& GetServerStatuses() const;
+
+    /** 启动后台健康监控：立即检查一次服务器池（同时建立连接），之后定期刷新健康快照 */
+    void StartHealthMonitor();
+
+    /** 是否有服务器在健康快照有效期内确认过可用，可用时提交前无需再测试连接 */
+    bool HasHealthyServer() const;
+
+    /** 取消所有进行中的生成任务 */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI")
     void CancelCurrentGeneration();
+
+    /** 取消指定 prompt_id 的生成任务，找不到该任务时返回 false */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI")
+    bool CancelGeneration(const FString& PromptId);
+
+    /** 指定 prompt_id 的任务是否仍在进行，可以用 CancelGeneration 取消 */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI")
+    bool IsGenerationActive(const FString& PromptId) const;
+
+    /** 当前进行中的任务数量（包括尚未拿到 prompt_id 的任务） */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI")
+    int32 GetActiveJobCount() const;
     
-    /** 执行工作流 */
+    /**
+     * 执行工作流
+     * ResultCacheKey 不为空时先查找结果缓存，命中时直接交付缓存的输出，不提交到服务器；成功的结果按该键保存
+     */
     void ExecuteWorkflow(const FString& WorkflowJson, 
                         const FOnGenerationStarted& OnStarted = FOnGenerationStarted(),
                         const FOnGenerationProgress& OnProgress = FOnGenerationProgress(),
                         const FOnImageGenerated& OnImageGenerated = FOnImageGenerated(),
                         const FOnMeshGenerated& OnMeshGenerated = FOnMeshGenerated(),
                         const FOnGenerationFailed& OnFailed = FOnGenerationFailed(),
-                        const FOnGenerationCompleted& OnCompleted = FOnGenerationCompleted());
+                        const FOnGenerationCompleted& OnCompleted = FOnGenerationCompleted(),
+                        const FString& TargetServerUrl = FString(),
+                        const FOnComfyUIWorkflowCompleted& OnWorkflowCompleted = FOnComfyUIWorkflowCompleted(),
+                        const FString& ResultCacheKey = FString());
     
-    /** 上传图像并获取图像名称 */
-    void UploadImage(const TArray<uint8>& ImageData, const FString& FileName, 
-                    TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback);
+    /** 结果缓存中是否有该键的结果，有时调用方可以跳过输入上传 */
+    bool HasCachedResult(const FString& ResultCacheKey);
     
-    /** 上传3D模型并获取模型名称 */
-    void UploadModel(const TArray<uint8>& ModelData, const FString& FileName, 
-                    TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback);
+    /** 计算本地输入文件的内容哈希（与上传缓存共用），未修改的文件不会重新读取。读取失败返回空字符串 */
+    FString HashInputFile(const FString& FilePath);
     
-    /** 下载3D模型数据 */
+    /** 上传图像并获取图像名称（相同内容已上传到该服务器时直接复用）。TargetServerUrl 为空时使用主服务器；传入右值可避免复制数据 */
+    void UploadImage(TArray<uint8> ImageData, const FString& FileName, 
+                    TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback,
+                    const FString& TargetServerUrl = FString());
+    
+    /** 上传3D模型并获取模型名称（相同内容已上传到该服务器时直接复用） */
+    void UploadModel(TArray<uint8> ModelData, const FString& FileName, 
+                    TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback,
+                    const FString& TargetServerUrl = FString());
+    
+    /** 从磁盘流式上传3D模型并获取模型名称（不把整个文件读入内存） */
+    void UploadModelFile(const FString& FilePath, const FString& FileName, 
+                        TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback,
+                        const FString& TargetServerUrl = FString());
+    
+    /** 下载3D模型数据，ModelData 直接引用 HTTP 响应体，需要长期保存时再拷贝 */
     void DownloadModel(const FString& Url, 
-                      TFunction<void(const TArray<uint8>& ModelData, bool bSuccess)> Callback);
+                      TFunction<void(const FComfyUIHttpPayload& ModelData, bool bSuccess)> Callback);
     
     /** 测试服务器连接 - 带回调，C++专用 */
     void TestServerConnection(const FOnConnectionTested& OnComplete);
@@ -67,104 +121,201 @@ public:
     /** 从图像数据创建纹理 */
     UTexture2D* CreateTextureFromImageData(const TArray<uint8>& ImageData);
 
+    /** 获取本客户端的 clientId（提交 prompt 和 WebSocket 连接共用） */
+    const FString& GetClientId() const { return ClientId; }
+
+    /** 到指定服务器（为空时为主服务器）的事件通道是否已连接（未连接时使用 HTTP 轮询） */
+    bool IsEventChannelConnected(const FString& InServerUrl = FString()) const;
+
 private:
     /** 网络通信管理器，封装 HTTP 请求 */
     UPROPERTY()
     UComfyUINetworkManager* NetworkManager;
 
-    /** ComfyUI服务器URL */
+    /** 主服务器URL（服务器池中的第一台），用于连接测试和未指定服务器的上传 */
     FString ServerUrl;
 
+    /** 服务器池，负责健康检查和任务分配 */
+    TSharedPtr<FComfyUIServerPool> ServerPool;
+    FComfyUIServerPool& GetServerPool();
+
     /** HTTP模块引用 */
     FHttpModule* HttpModule;
 
-    /** 当前请求 */
-    TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> CurrentRequest;
-
-    /** 生成完成回调 */
-    FOnImageGenerated OnImageGeneratedCallback;
-    FOnMeshGenerated OnMeshGeneratedCallback;
-    FOnGenerationFailed OnGenerationFailedCallback;
-    FOnRetryAttempt OnRetryAttemptCallback;
-    FOnGenerationProgress OnGenerationProgressCallback;
-    FOnGenerationStarted OnGenerationStartedCallback;
-    FOnGenerationCompleted OnGenerationCompletedCallback;
-
-    /** 重试配置 */
+    /** 重试配置：第 N 次重试的基础延迟为 RetryDelaySeconds * 2^(N-1)，不超过 MaxRetryDelaySeconds，并加随机抖动 */
     int32 MaxRetryAttempts = 3;
     float RetryDelaySeconds = 2.0f;
+    float MaxRetryDelaySeconds = 30.0f;
     float RequestTimeoutSeconds = 30.0f;
 
-    /** 当前请求状态 */
-    int32 CurrentRetryCount = 0;
-    FString LastErrorMessage;
-    EComfyUIErrorType LastErrorType = EComfyUIErrorType::None;
+    /** 基础轮询间隔（事件通道断开时使用），实际间隔按任务状态自适应 */
+    float PollInterval = 2.0f;
+
+    /** 自适应轮询间隔的上下限 */
+    float MinPollInterval = 0.5f;
+    float MaxPollInterval = 20.0f;
 
-    /** 当前操作的上下文信息 */
-    FString CurrentPrompt;
-    FString CurrentNegativePrompt;
-    EComfyUIWorkflowType CurrentWorkflowType;
-    FString CurrentCustomWorkflowName;
+    /** 执行时间估计的滑动平均权重 */
+    double ExecutionEstimateWeight = 0.3;
 
-    /** 使用 NetworkManager 发送 Prompt 请求后的回调处理 */
-    void OnPromptResponse(const FString& ResponseContent, bool bWasSuccessful);
+    /** 批量查询历史记录的最小窗口 */
+    int32 MinHistoryWindow = 32;
+
+    /** 任务提交与响应处理 */
+    void SubmitJob(const TSharedPtr<FComfyUIJob>& Job);
+    void OnPromptResponse(const TSharedPtr<FComfyUIJob>& Job, const FString& ResponseContent, bool bWasSuccessful);
 
     /** HTTP响应处理 */
-    void OnImageDownloaded(const TArray<uint8>& ImageData, bool bWasSuccessful);
-    void On3DModelDownloaded(const TArray<uint8>& ModelData, bool bWasSuccessful, const FString& Filename);
-    void OnQueueStatusChecked(const FString& ResponseContent, bool bWasSuccessful);
+    void OnImageDownloaded(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output, const FComfyUIHttpPayload& ImageData, bool bWasSuccessful, TFunction<void()> RetryDownload);
+    void On3DModelDownloaded(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output, const FString& FilePath, bool bWasSuccessful, TFunction<void()> RetryDownload);
+    void OnQueueStatusChecked(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHttpPayload& ResponseContent, bool bWasSuccessful);
+    void OnJobHistoryParsed(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry* PromptHistory);
 
     /** 错误处理和重试机制 */
-    void HandleRequestError(const FComfyUIError& Error, TFunction<void()> RetryFunction);
-    void RetryCurrentOperation();
-    void ResetRetryState();
+    /** Output 不为空时为该输出的下载错误，按输出单独计数和安排重试 */
+    void HandleRequestError(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIError& Error, TFunction<void()> RetryFunction,
+                            const FComfyUIOutputRef* Output = nullptr);
+    float ComputeRetryDelay(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIError& Error, int32 RetryCount) const;
+    void RetryJob(const TSharedPtr<FComfyUIJob>& Job);
     FString GetUserFriendlyErrorMessage(const FComfyUIError& Error);
 
     /** 工具函数 */
-    void PollGenerationStatus();
-    void PollGenerationStatus(const FString& PromptId);
-    void DownloadGeneratedImage(const FString& Filename, const FString& Subfolder, const FString& Type);
-    void DownloadGenerated3DModel(const FString& Filename, const FString& Subfolder);
-    FComfyUIProgressInfo ParseQueueStatus(const FString& ResponseContent);
+    void PollGenerationStatus(const TSharedPtr<FComfyUIJob>& Job);
+    void DownloadGeneratedImage(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output);
+    void DownloadGenerated3DModel(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIOutputRef& Output);
+    static FComfyUIProgressInfo MakeQueueProgress(int32 QueuePosition);
+
+    /** 处理某个 prompt 的历史记录：检查执行状态并下载输出 */
+    void ProcessHistoryEntry(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry& PromptHistory);
+
+    /** 批量状态查询：每台服务器一轮 /queue + /history，分发给该服务器上所有轮询中或等待补查的任务 */
+    void RunStatusCycle(const FString& InServerUrl);
+    void OnStatusBatch(const FComfyUIStatusBatch& Batch, bool bSuccess, FString BatchServerUrl);
+
+    /** 按该服务器上轮询中的任务安排下一轮状态查询，没有轮询中的任务时不安排 */
+    void ScheduleStatusCycle(const FString& InServerUrl);
+
+    /** 单个任务期望的轮询间隔：执行中按估计的剩余时间，排队中按位置退避 */
+    float ComputeJobPollDelay(const FComfyUIJob& Job, double Now) const;
+
+    /** 任务完成时更新同类工作流的执行时间估计 */
+    void RecordExecutionTime(const TSharedPtr<FComfyUIJob>& Job, const FComfyUIHistoryEntry& PromptHistory);
+
+    /** 按工作流中的节点类型生成签名 */
+    static FString MakeWorkflowKey(const FString& WorkflowJson);
+
+    /** 一个输出处理完毕（成功或最终失败），全部处理完后结束任务 */
+    void OnJobOutputFinished(const TSharedPtr<FComfyUIJob>& Job);
+
+    /** 把处理好的输出加入任务结果，资产在结果交付前保持引用 */
+    void AddJobOutput(const TSharedPtr<FComfyUIJob>& Job, FComfyUIOutputItem&& Item);
+
+    /** 已生成但尚未交付的输出资产，防止在任务完成前被垃圾回收 */
+    UPROPERTY()
+    TArray<UObject*> RetainedOutputAssets;
+
+    /** 结束任务：交付完整结果，停止计时器、取消任务尚未结束的请求并从任务表移除 */
+    void FinishJob(const TSharedPtr<FComfyUIJob>& Job);
+
+    /** 取消任务：本地结束任务，并让服务器删除或中断对应的 prompt */
+    void CancelJob(const TSharedPtr<FComfyUIJob>& Job);
+
+    /** 服务器端取消：删除排队中的 prompt，之后确认；可能已在执行时立即查询 /queue，确认正在执行后才发送 /interrupt */
+    void CancelOnServer(const FString& InServerUrl, const FString& PromptId, bool bMayBeExecuting);
+    void SendCancelInterrupt(const FString& PromptId);
+    void ScheduleCancelVerify(const FString& PromptId);
+
+    /** 查询 /queue 确认取消：已不在队列中时确认，等待中时重新删除，正在执行时中断；查询进行中时忽略 */
+    void VerifyServerCancel(const FString& PromptId);
+    void ConfirmServerCancel(const FString& PromptId, const TCHAR* Reason);
+
+    /** 事件属于等待确认取消的 prompt 时处理并返回 true */
+    bool HandlePendingCancelEvent(const FComfyUIServerEvent& Event);
+
+    /** 等待服务器确认取消的 prompt，按 prompt_id 索引 */
+    TMap<FString, FComfyUIPendingCancel> PendingCancels;
+
+    /** 取消后等待事件通道确认的时间，超时后通过 /queue 确认，最多确认 MaxCancelVerifyAttempts 次 */
+    float CancelVerifyDelay = 3.0f;
+    int32 MaxCancelVerifyAttempts = 3;
+
+    /** 选择服务器并提交已在 SubmittingJobs 中的任务 */
+    void StartJobOnServer(const TSharedPtr<FComfyUIJob>& Job, const FString& TargetServerUrl);
+
+    /** 按 prompt_id 查找任务 */
+    TSharedPtr<FComfyUIJob> FindJob(const FString& PromptId) const;
     
     /** 确保NetworkManager被正确初始化 */
     void EnsureNetworkManagerInitialized();
 
+    /** 按内容哈希查找上传缓存，命中且服务器上文件仍存在时直接返回，否则调用 DoUpload 上传并记录 */
+    void UploadWithCache(const FString& TargetServerUrl, const FString& ContentHash, int64 Size,
+                         TFunction<void(TFunction<void(const FString& UploadedName, bool bSuccess)>)> DoUpload,
+                         TFunction<void(const FString& UploadedName, bool bSuccess)> Callback);
+    FComfyUIUploadCache& GetUploadCache();
+
+    /**
+     * 按结果缓存完成任务：在工作线程读取文件和解码图像，游戏线程只创建纹理和网格并交付
+     * 缓存未命中时返回 false；文件无法加载时删除该条目并改为提交到服务器
+     */
+    bool CompleteJobFromResultCache(const TSharedPtr<FComfyUIJob>& Job, const FString& TargetServerUrl);
+    FComfyUIResultCache& GetResultCache();
+
+    /** WebSocket 事件通道，每台服务器一个 */
+    void EnsureEventChannel(const FString& InServerUrl);
+    void CloseEventChannels();
+    void HandleServerEvent(const FComfyUIServerEvent& Event);
+    void HandleEventChannelStateChanged(bool bConnected, FString ChannelServerUrl);
+
+    /** 将本客户端的 clientId 写入提交的请求JSON，使服务器把事件推送到本连接 */
+    FString InjectClientId(const FString& WorkflowJson) const;
+
     /** 获取当前有效的世界上下文 */
     UWorld* GetCurrentWorld() const;
 
-    /** 异步轮询相关方法 */
-    void StartAsyncPolling();
-    void StopAsyncPolling();
-    bool HandleAsyncPoll(float DeltaTime);
-    
-    /** 异步重试相关方法 */
-    void StartAsyncRetry(TFunction<void()> RetryFunction, float DelaySeconds);
-    void StopAsyncRetry();
-    bool HandleAsyncRetry(float DeltaTime);
+    /** 任务计时器（轮询与重试），所有任务共用一个计时器轮，ticker 只在最早的计时器到期时触发 */
+    void StartJobPolling(const TSharedPtr<FComfyUIJob>& Job);
+    void StopJobPolling(const TSharedPtr<FComfyUIJob>& Job);
+    /** OutputKey 为空时使用任务的重试计时器，否则使用该输出的计时器；StopJobRetry 停止任务的所有重试计时器 */
+    void StartJobRetry(const TSharedPtr<FComfyUIJob>& Job, TFunction<void()> RetryFunction, float DelaySeconds, const FString& OutputKey = FString());
+    void StopJobRetry(const TSharedPtr<FComfyUIJob>& Job);
+    void UpdateJobTicker();
+    bool HandleJobTimers(float DeltaTime);
 
-    /** 当前生成的提示ID */
-    FString CurrentPromptId;
+    /** 已拿到 prompt_id 的任务，按 prompt_id 索引 */
+    TMap<FString, TSharedPtr<FComfyUIJob>> Jobs;
 
-    /** 轮询计时器 */
-    UPROPERTY()
-    FTimerHandle StatusPollTimer;
-    UPROPERTY()
-    FTimerHandle RetryTimerHandle;
-    
-    /** 异步轮询相关 */
-    FTSTicker::FDelegateHandle TickerHandle;
-    float LastPollTime = 0.0f;
-    float PollInterval = 2.0f;
-    bool bIsPolling = false;
-    
-    /** 异步重试相关 */
-    FTSTicker::FDelegateHandle RetryTickerHandle;
-    float RetryStartTime = 0.0f;
-    TFunction<void()> PendingRetryFunction;
-    
-    /** 当前生成任务是否被取消 */
-    bool bIsCancelled = false;
+    /** 已发出但尚未拿到 prompt_id 的任务 */
+    TArray<TSharedPtr<FComfyUIJob>> SubmittingJobs;
+
+    /** 任务计时器 */
+    FComfyUITimerWheel JobTimers;
+    FTSTicker::FDelegateHandle JobTickerHandle;
+    double JobTickerDeadline = -1.0;
+
+    /** 批量状态查询，按服务器索引 */
+    TMap<FString, TSharedPtr<FComfyUIStatusEngine>> StatusEngines;
+    TMap<FString, FComfyUITimerWheel::FHandle> StatusCycleTimers;
+
+    /** 后台健康监控，间隔小于服务器池的快照有效期，使快照在空闲时也保持有效 */
+    void RunHealthMonitor();
+    FComfyUITimerWheel::FHandle HealthMonitorTimer = 0;
+    float HealthMonitorInterval = 15.0f;
+
+    /** 各类工作流的执行时间估计（秒），按 WorkflowKey 索引 */
+    TMap<FString, double> ExecutionTimeEstimates;
+
+    /** 客户端唯一ID，用于 /ws?clientId= 与 /prompt 的 client_id */
+    FString ClientId;
+
+    /** WebSocket 事件通道，按服务器索引，断开时回退到轮询 */
+    TMap<FString, TSharedPtr<FComfyUIWebSocketChannel>> EventChannels;
+
+    /** 按内容哈希索引的上传缓存，首次使用时从磁盘加载 */
+    TSharedPtr<FComfyUIUploadCache> UploadCache;
+
+    /** 按最终 prompt 哈希索引的结果缓存，首次使用时从磁盘加载 */
+    TSharedPtr<FComfyUIResultCache> ResultCache;
 
     /** 单例实例 */
     static UComfyUIClient* Instance;
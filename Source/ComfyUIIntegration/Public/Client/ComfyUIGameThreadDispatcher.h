@@ -0,0 +1,35 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "Containers/Ticker.h"
+#include <atomic>
+
+/**
+ * 工作线程到游戏线程的任务队列
+ * 响应解析、图像解码等在工作线程完成后，只把最后需要游戏线程的部分（创建 UObject、触发回调）放入队列。
+ * 队列为无锁的多生产者单消费者队列，游戏线程每帧取一次，单帧处理时间超过 FrameBudgetSeconds 时剩余的留到下一帧。
+ * 模块启动时 Initialize，关闭时 Shutdown；未初始化时回退到 AsyncTask(GameThread)。
+ */
+class COMFYUIINTEGRATION_API FComfyUIGameThreadDispatcher
+{
+public:
+    static void Initialize();
+    static void Shutdown();
+
+    /** 放入一个在游戏线程执行的任务，可在任意线程调用 */
+    static void Enqueue(TFunction<void()> Task);
+
+    /** 在任务图的工作线程执行 Work，完成后在游戏线程执行 OnGameThread */
+    static void RunAsync(TFunction<void()> Work, TFunction<void()> OnGameThread);
+
+    /** 单帧处理队列的时间上限 */
+    static double FrameBudgetSeconds;
+
+private:
+    static bool Drain(float DeltaTime);
+
+    static TQueue<TFunction<void()>, EQueueMode::Mpsc> Tasks;
+    static FTSTicker::FDelegateHandle TickerHandle;
+    static std::atomic<bool> bInitialized;
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ComfyUIDelegates.h"
+#include "ComfyUITypes.h"
+#include "ComfyUIExecutionTypes.h"
+
+/**
+ * 历史记录中的一个输出文件
+ */
+struct COMFYUIINTEGRATION_API FComfyUIOutputRef
+{
+    EComfyUINodeOutputType Type = EComfyUINodeOutputType::Unknown;
+
+    /** 输出节点ID及其在该节点输出数组中的索引 */
+    FString NodeId;
+    int32 OutputIndex = 0;
+
+    /** /view 参数 */
+    FString Filename;
+    FString Subfolder;
+    FString FolderType;
+
+    /** 在任务内唯一标识该输出，用于按输出记录重试状态 */
+    FString GetKey() const { return FString::Printf(TEXT("%s:%d"), *NodeId, OutputIndex); }
+};
+
+/**
+ * 单个输出下载的重试状态
+ * 各输出同时下载、独立重试，一个输出失败或成功不影响其他输出的重试计时和次数
+ */
+struct COMFYUIINTEGRATION_API FComfyUIOutputRetry
+{
+    int32 RetryCount = 0;
+    uint64 RetryTimer = 0;
+};
+
+/**
+ * 单个生成任务的运行时状态
+ * 每个任务持有自己的回调、重试状态、计时器和取消标记，
+ * 客户端通过 prompt_id 索引任务表，从而可以同时驱动多个任务
+ */
+struct COMFYUIINTEGRATION_API FComfyUIJob : public TSharedFromThis<FComfyUIJob>
+{
+    /** 本地任务ID（提交成功之前 PromptId 为空） */
+    FGuid JobId = FGuid::NewGuid();
+
+    /** 服务器返回的 prompt_id */
+    FString PromptId;
+
+    /** 提交的请求JSON，用于提交失败时重新提交 */
+    FString RequestJson;
+
+    /** 任务所在的服务器，提交、状态查询和下载都发往这台服务器 */
+    FString ServerUrl;
+
+    /** 工作流的节点类型签名，相同签名的任务共享执行时间估计 */
+    FString WorkflowKey;
+
+    /** 结果缓存的键，为空时不查找也不保存结果 */
+    FString ResultCacheKey;
+
+    /** 任务回调 */
+    FOnGenerationStarted OnStarted;
+    FOnGenerationProgress OnProgress;
+    FOnImageGenerated OnImageGenerated;
+    FOnMeshGenerated OnMeshGenerated;
+    FOnGenerationFailed OnFailed;
+    FOnGenerationCompleted OnCompleted;
+    FOnRetryAttempt OnRetryAttempt;
+
+    /** 所有输出处理完毕（或任务失败）时交付完整结果 */
+    FOnComfyUIWorkflowCompleted OnWorkflowCompleted;
+
+    /** 已处理的输出，每个图像、模型和文本输出一项 */
+    FComfyUIWorkflowResult Result;
+
+    /** 重试状态（提交和状态查询） */
+    int32 RetryCount = 0;
+    FComfyUIError LastError;
+    uint64 RetryTimer = 0;
+
+    /** 输出下载的重试状态，按 FComfyUIOutputRef::GetKey() 索引 */
+    TMap<FString, FComfyUIOutputRetry> OutputRetries;
+
+    /** 是否参与批量状态轮询 */
+    bool bIsPolling = false;
+
+    /** 事件通道恢复后补查一次状态（不继续轮询）：等待下一轮批量查询 / 已包含在正在进行的一轮中 */
+    bool bStatusCheckPending = false;
+    bool bStatusCheckInCycle = false;
+
+    /** 最近一次查询到的队列位置：0 为正在执行，INDEX_NONE 为未知 */
+    int32 QueuePosition = INDEX_NONE;
+
+    /** 队列位置未变化的连续轮询次数，用于退避 */
+    int32 PollBackoffLevel = 0;
+
+    /** 开始执行的时间（FPlatformTime::Seconds），尚未执行时为 0 */
+    double ExecutionStartTime = 0.0;
+
+    /** 服务器已报告执行结束，正在下载输出 */
+    bool bOutputsReceived = false;
+
+    /** 尚未完成的输出下载数量 */
+    int32 PendingDownloads = 0;
+
+    /** 任务是否已被取消 */
+    bool bIsCancelled = false;
+
+    /** 任务是否已结束（成功、失败或取消），结束后忽略所有迟到的回调 */
+    bool bIsFinished = false;
+
+    /** 是否还需要处理回调 */
+    bool IsActive() const { return !bIsCancelled && !bIsFinished; }
+
+    /** 任务的状态查询和下载请求所在的请求组，任务结束时一起取消 */
+    FString GetRequestGroup() const { return JobId.ToString(); }
+
+    void ResetRetryState()
+    {
+        RetryCount = 0;
+        LastError = FComfyUIError();
+    }
+};
+
+/**
+ * 已在本地取消、等待服务器确认的 prompt
+ * 排队中的从 /queue 删除；只有新取得的 /queue 快照显示该 prompt 正在执行时才发送 /interrupt
+ * （旧版本服务器忽略 prompt_id，会中断当前执行的任何 prompt）。事件通道报告中断或结束，或 /queue 中已查不到时确认
+ */
+struct COMFYUIINTEGRATION_API FComfyUIPendingCancel
+{
+    FString ServerUrl;
+
+    /** 已对该 prompt 发送过 /interrupt */
+    bool bInterruptSent = false;
+
+    /** 通过 /queue 确认的次数 */
+    int32 VerifyAttempts = 0;
+    uint64 VerifyTimer = 0;
+
+    /** /queue 查询进行中 */
+    bool bVerifyInFlight = false;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ComfyUIExecutionTypes.h"
+
+/**
+ * 结果缓存中的一个输出
+ */
+struct COMFYUIINTEGRATION_API FComfyUIResultCacheOutput
+{
+    EComfyUINodeOutputType Type = EComfyUINodeOutputType::Unknown;
+    FString NodeId;
+    int32 OutputIndex = 0;
+
+    /** 服务器上的原始文件名 */
+    FString FileName;
+
+    /** 记录目录中保存的文件名（图像、模型），文本输出为空 */
+    FString CachedFile;
+
+    /** 文本输出内容 */
+    FString Text;
+};
+
+/**
+ * 结果缓存的一条记录：一次成功执行的全部输出
+ */
+struct COMFYUIINTEGRATION_API FComfyUIResultCacheEntry
+{
+    TArray<FComfyUIResultCacheOutput> Outputs;
+
+    /** 记录目录中文件的总大小，按总大小淘汰 */
+    int64 Size = 0;
+
+    /** 最近一次使用的时间，超出容量时淘汰最久未用的记录 */
+    FDateTime LastUsed;
+};
+
+/**
+ * 本地结果缓存
+ * 以最终 prompt JSON（上传的输入按内容哈希绑定）的哈希为键，保存成功执行的输出文件和文本。
+ * 相同的请求再次执行时直接交付缓存的结果，不再上传输入、排队和下载输出。
+ * 输出文件保存在 Saved/ComfyUI/ResultCache/<键>/，索引持久化到同目录的 Index.json；
+ * 文件总大小超出 MaxTotalSize 时淘汰最久未用的记录。
+ */
+class COMFYUIINTEGRATION_API FComfyUIResultCache : public TSharedFromThis<FComfyUIResultCache>
+{
+public:
+    explicit FComfyUIResultCache(const FString& InCacheDirectory);
+
+    /** 由最终 prompt JSON 计算缓存键 */
+    static FString MakeKey(const FString& PromptJson);
+
+    /** 查找结果，找到时更新使用时间；缓存的文件已被删除时移除记录并返回 nullptr */
+    const FComfyUIResultCacheEntry* Find(const FString& Key);
+
+    /** 记录中缓存文件的完整路径 */
+    FString GetCachedFilePath(const FString& Key, const FComfyUIResultCacheOutput& Output) const;
+
+    /**
+     * 保存一次成功执行的结果
+     * 文件在工作线程写入，完成后在游戏线程登记、淘汰并保存索引；没有可缓存的输出时不保存
+     */
+    void Store(const FString& Key, const FComfyUIWorkflowResult& Result);
+
+    /** 移除记录并删除其文件 */
+    void Remove(const FString& Key);
+
+    /** 从磁盘加载 / 保存到磁盘 */
+    void Load();
+    void Save() const;
+
+private:
+    FString GetEntryDirectory(const FString& Key) const;
+
+    /** 文件写入完成后登记记录 */
+    void AddEntry(const FString& Key, FComfyUIResultCacheEntry&& Entry);
+
+    /** 超出容量时淘汰最久未用的记录 */
+    void Prune();
+
+    FString CacheDirectory;
+    FString IndexFilePath;
+    TMap<FString, FComfyUIResultCacheEntry> Entries;
+
+    /** 正在工作线程写入文件的键 */
+    TSet<FString> PendingKeys;
+
+    /** 所有记录的文件总大小 */
+    int64 TotalSize = 0;
+
+    int64 MaxTotalSize = 2048ll * 1024 * 1024;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 客户端计时器轮
+ * 计时器按到期时间散列到固定数量的槽中，推进时只访问经过的槽，添加和取消都是 O(1)。
+ * 超出一圈的计时器留在槽中，直到真正到期才触发。
+ * 轮本身不驱动时间：调用方在 GetNextDeadline() 到达时调用 Advance()，没有计时器时不需要任何 tick。
+ * 只在游戏线程使用。
+ */
+class COMFYUIINTEGRATION_API FComfyUITimerWheel
+{
+public:
+    /** 0 表示无效句柄 */
+    using FHandle = uint64;
+
+    explicit FComfyUITimerWheel(double InResolution = 0.05, int32 InNumSlots = 512);
+
+    /** 在 Now + DelaySeconds 时触发 Callback */
+    FHandle Schedule(double Now, double DelaySeconds, TFunction<void()> Callback);
+
+    /** 取消计时器，已触发或不存在时返回 false */
+    bool Cancel(FHandle Handle);
+
+    bool IsScheduled(FHandle Handle) const { return Locations.Contains(Handle); }
+
+    /** 计时器的到期时间，不存在时返回 -1 */
+    double GetDeadline(FHandle Handle) const;
+
+    /** 触发所有到期的计时器，返回触发的数量。回调中可以添加或取消计时器 */
+    int32 Advance(double Now);
+
+    /** 最早的到期时间，没有计时器时返回 -1 */
+    double GetNextDeadline() const;
+
+    int32 Num() const { return Locations.Num(); }
+    bool IsEmpty() const { return Locations.Num() == 0; }
+
+    /** 丢弃所有计时器（不触发） */
+    void Reset();
+
+private:
+    struct FTimer
+    {
+        FHandle Handle = 0;
+        double Deadline = 0.0;
+        TFunction<void()> Callback;
+    };
+
+    struct FLocation
+    {
+        int32 Slot = 0;
+        double Deadline = 0.0;
+    };
+
+    int64 ToTick(double Time) const { return (int64)FMath::FloorToDouble(Time / Resolution); }
+    int32 ToSlot(int64 Tick) const { return (int32)(Tick % Slots.Num()); }
+
+    double Resolution;
+    TArray<TArray<FTimer>> Slots;
+
+    /** 句柄所在的槽，用于取消和查询 */
+    TMap<FHandle, FLocation> Locations;
+
+    /** 上次推进到的 tick，INDEX_NONE 表示尚未推进 */
+    int64 CurrentTick = INDEX_NONE;
+    FHandle NextHandle = 1;
+};
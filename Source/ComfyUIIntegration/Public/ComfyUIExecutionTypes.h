@@ -101,6 +101,14 @@ struct COMFYUIINTEGRATION_API FComfyUIOutputItem
     UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
     FString FileName;
     
+    // 本地文件路径（3D模型等直接下载到磁盘的输出）
+    UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
+    FString LocalFilePath;
+    
+    // 文本输出内容
+    UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
+    FString Text;
+    
     // 原始数据（图像、3D模型等的二进制数据）
     UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
     TArray<uint8> RawData;
@@ -45,6 +45,10 @@ struct COMFYUIINTEGRATION_API FComfyUIError
     UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
     bool bCanRetry = false;
 
+    /** 服务器通过 Retry-After 要求的等待时间（秒），0 表示未指定 */
+    UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
+    float RetryAfterSeconds = 0.0f;
+
     FComfyUIError() = default;
     
     FComfyUIError(EComfyUIErrorType Type, const FString& Message, int32 StatusCode = 0, const FString& Solution = TEXT(""), bool CanRetry = false)
@@ -79,6 +83,13 @@ struct COMFYUIINTEGRATION_API FComfyUIProgressInfo
     UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
     bool bIsExecuting = false;
 
+    /** 输出下载进度（字节），总大小未知时为 -1 */
+    UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
+    int64 BytesReceived = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "ComfyUI")
+    int64 BytesTotal = -1;
+
     FComfyUIProgressInfo()
     {
         QueuePosition = 0;
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpResponse.h"
+
+/**
+ * 端点熔断状态
+ */
+enum class EComfyUICircuitState : uint8
+{
+    Closed,     // 正常放行
+    Open,       // 已知不可用，请求直接失败
+    HalfOpen    // 冷却结束，放行一个探测请求
+};
+
+/**
+ * 单个端点的熔断统计
+ */
+struct COMFYUIINTEGRATION_API FComfyUIEndpointHealth
+{
+    EComfyUICircuitState State = EComfyUICircuitState::Closed;
+
+    /** 连续失败次数 */
+    int32 ConsecutiveFailures = 0;
+
+    /** 连续熔断次数，决定下次冷却时长 */
+    int32 TripCount = 0;
+
+    /** 冷却结束时间（FPlatformTime::Seconds） */
+    double OpenUntil = 0.0;
+
+    /** 服务器通过 Retry-After 要求的最早重试时间 */
+    double RetryAfterUntil = 0.0;
+
+    /** 半开状态下探测请求是否已发出 */
+    bool bProbeInFlight = false;
+    double ProbeStartTime = 0.0;
+};
+
+/**
+ * 按端点（scheme://host:port/path）的熔断器
+ * 连续失败达到 FailureThreshold 后熔断，冷却期内该端点的请求直接失败，不再打到正在重启的服务器；
+ * 冷却结束后半开，只放行一个探测请求，成功则恢复，失败则以加倍的冷却时间重新熔断。
+ * 冷却时间带随机抖动，避免多个客户端在同一时刻一起探测。
+ * 连接失败、超时、5xx 和 429 计为失败，其他响应说明服务器在线，计为成功。
+ * 只在游戏线程使用。
+ */
+class COMFYUIINTEGRATION_API FComfyUICircuitBreaker
+{
+public:
+    /** 是否放行请求，半开时只放行一个探测请求 */
+    bool AllowRequest(const FString& Url);
+
+    /** 记录请求结果 */
+    void RecordResult(const FString& Url, FHttpResponsePtr Response, bool bWasSuccessful);
+
+    /** 请求在本地被取消：不计入结果，若是半开状态的探测请求则允许下一个请求探测 */
+    void RecordCancelled(const FString& Url);
+
+    /** 端点当前状态 */
+    EComfyUICircuitState GetState(const FString& Url) const;
+
+    /** 该服务器上任一端点要求的剩余等待时间（熔断冷却或 Retry-After），没有时返回 0 */
+    double GetRetryDelay(const FString& ServerUrl) const;
+
+    void Reset() { Endpoints.Reset(); }
+
+    /** 解析 Retry-After 响应头（秒数或 HTTP 日期），没有或无法解析时返回 0 */
+    static double ParseRetryAfter(FHttpResponsePtr Response);
+
+    /** 端点键：scheme://host:port 加第一段路径 */
+    static FString GetEndpointKey(const FString& Url);
+
+    /** 熔断阈值与冷却时间 */
+    int32 FailureThreshold = 3;
+    double BaseOpenSeconds = 5.0;
+    double MaxOpenSeconds = 60.0;
+
+private:
+    static bool IsFailure(FHttpResponsePtr Response, bool bWasSuccessful);
+
+    void Trip(FComfyUIEndpointHealth& Health, double Now);
+
+    TMap<FString, FComfyUIEndpointHealth> Endpoints;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 历史记录中的一个输出文件（/view 参数）
+ */
+struct COMFYUIINTEGRATION_API FComfyUIHistoryFile
+{
+    FString Filename;
+    FString Subfolder;
+    FString FolderType;
+};
+
+/**
+ * 一个输出节点的输出
+ */
+struct COMFYUIINTEGRATION_API FComfyUIHistoryNodeOutput
+{
+    FString NodeId;
+
+    /** images 数组 */
+    TArray<FComfyUIHistoryFile> Images;
+
+    /** text 数组（ShowText 等节点） */
+    TArray<FString> Texts;
+
+    /** gltf/glb/meshes/mesh 数组，按出现顺序 */
+    TArray<FComfyUIHistoryFile> Meshes;
+};
+
+/**
+ * 一个 prompt 的历史记录中客户端需要的部分
+ */
+struct COMFYUIINTEGRATION_API FComfyUIHistoryEntry
+{
+    FString PromptId;
+
+    /** status.status_str，例如 success / error */
+    FString StatusStr;
+    bool bCompleted = false;
+
+    /** status.messages 中 execution_start / execution_success 的时间戳（毫秒），没有时为 0 */
+    double ExecutionStartTimestamp = 0.0;
+    double ExecutionEndTimestamp = 0.0;
+
+    TArray<FComfyUIHistoryNodeOutput> Outputs;
+
+    bool IsError() const { return StatusStr == TEXT("error"); }
+};
+
+/**
+ * /history 响应的流式扫描器
+ * 直接在 UTF-8 响应字节上扫描，只提取 status、outputs.*.images/text 和模型字段，
+ * 其他内容（prompt、extra_data、meta 等）跳过而不解码，不构建 JSON DOM，也不先把整个响应转换为 TCHAR。
+ * 可在任意线程调用。
+ */
+class COMFYUIINTEGRATION_API FComfyUIHistoryScanner
+{
+public:
+    /**
+     * 扫描 /history 或 /history/{prompt_id} 的响应（顶层对象按 prompt_id 索引）
+     * OnlyPromptId 不为空时只提取该 prompt，其余条目直接跳过。格式错误时返回 false
+     */
+    static bool Scan(TArrayView<const uint8> Utf8Content, TMap<FString, FComfyUIHistoryEntry>& OutEntries,
+                     const FString& OnlyPromptId = FString());
+};
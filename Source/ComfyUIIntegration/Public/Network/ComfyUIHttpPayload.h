@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpResponse.h"
+
+/**
+ * HTTP 响应体的共享只读引用
+ * 持有响应对象本身而不拷贝响应体，可以在线程间传递；最后一个引用释放时响应体随响应对象一起释放。
+ * 用于图片、模型和较大的 JSON 响应，从 HTTP 层到解码/解析都不产生整块拷贝。
+ */
+struct COMFYUIINTEGRATION_API FComfyUIHttpPayload
+{
+    FComfyUIHttpPayload() = default;
+    explicit FComfyUIHttpPayload(FHttpResponsePtr InResponse) : Response(MoveTemp(InResponse)) {}
+
+    /** 响应体，没有响应时为空数组 */
+    const TArray<uint8>& GetData() const;
+
+    TArrayView<const uint8> GetView() const { return GetData(); }
+    int32 Num() const { return GetData().Num(); }
+    bool IsEmpty() const { return Num() == 0; }
+
+    /** 需要长期单独持有数据时拷贝一份 */
+    TArray<uint8> CopyData() const { return GetData(); }
+
+    /** 提前释放对响应的引用 */
+    void Reset() { Response.Reset(); }
+
+private:
+    FHttpResponsePtr Response;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+
+/**
+ * multipart/form-data 请求体的流式读取器
+ * 请求体由若干段组成：字段和分隔符是内存中的小段，文件内容在 HTTP 线程读取时才按块从磁盘读入，
+ * 上传大模型时不需要先把整个文件读进内存，也不会再拷贝一份完整的请求体。
+ * 通过 IHttpRequest::SetContentFromStream 使用，Content-Length 由 TotalSize() 给出。
+ */
+class COMFYUIINTEGRATION_API FComfyUIMultipartFormStream : public FArchive
+{
+public:
+    FComfyUIMultipartFormStream();
+    virtual ~FComfyUIMultipartFormStream() override;
+
+    /** 添加普通文本字段 */
+    void AddField(const FString& Name, const FString& Value);
+
+    /** 添加磁盘文件，文件内容在发送时才读取。文件不存在返回 false */
+    bool AddFile(const FString& FieldName, const FString& FileName, const FString& ContentType, const FString& FilePath);
+
+    /** 添加内存中的文件数据 */
+    void AddFileData(const FString& FieldName, const FString& FileName, const FString& ContentType, TArray<uint8>&& Data);
+
+    /** 写入结束分隔符，之后不能再添加字段 */
+    void Finalize();
+
+    /** 请求头 Content-Type 的值 */
+    FString GetContentType() const;
+
+    /** 根据扩展名推断上传文件的 Content-Type */
+    static FString GetContentTypeForFile(const FString& FileName);
+
+    // FArchive 接口
+    virtual void Serialize(void* Data, int64 Length) override;
+    virtual int64 Tell() override { return Position; }
+    virtual int64 TotalSize() override { return TotalBytes; }
+    virtual void Seek(int64 InPos) override;
+    virtual bool Close() override;
+    virtual FString GetArchiveName() const override { return TEXT("FComfyUIMultipartFormStream"); }
+
+private:
+    /** 请求体的一段：内存数据或磁盘文件 */
+    struct FSegment
+    {
+        int64 Offset = 0;
+        int64 Size = 0;
+        TArray<uint8> Bytes;
+        FString FilePath;
+
+        /** 小的文本段可以合并；文件段和大数据段保持独立 */
+        bool bMergeable = true;
+
+        bool IsFile() const { return !FilePath.IsEmpty(); }
+    };
+
+    void AppendText(const FString& Text);
+    void AppendSegment(FSegment&& Segment);
+
+    /** 找到包含指定位置的段 */
+    int32 FindSegment(int64 InPos) const;
+
+    /** 打开文件段（按需），切换到其他文件段时关闭上一个 */
+    FArchive* OpenFileSegment(int32 SegmentIndex);
+
+    FString Boundary;
+    TArray<FSegment> Segments;
+    int64 TotalBytes = 0;
+    int64 Position = 0;
+    bool bFinalized = false;
+
+    /** 当前打开的文件段 */
+    TUniquePtr<FArchive> FileReader;
+    int32 OpenSegmentIndex = INDEX_NONE;
+};
@@ -4,6 +4,9 @@
 #include "UObject/NoExportTypes.h"
 #include "Http.h"
 #include "ComfyUITypes.h"
+#include "Network/ComfyUIRequestScheduler.h"
+#include "Network/ComfyUICircuitBreaker.h"
+#include "Network/ComfyUIHttpPayload.h"
 #include "ComfyUINetworkManager.generated.h"
 
 // NetworkManager需要反射系统支持，因为它继承自UObject
@@ -19,27 +22,65 @@ public:
     void SendRequest(const FString& Url, const FString& Payload, TFunction<void(const FString& Response, bool bSuccess)> Callback);
     
     // GET请求（用于轮询状态、测试连接等）
-    void SendGetRequest(const FString& Url, TFunction<void(const FString& Response, bool bSuccess)> Callback, float TimeoutSeconds = 10.0f);
+    void SendGetRequest(const FString& Url, TFunction<void(const FString& Response, bool bSuccess)> Callback, float TimeoutSeconds = 10.0f,
+                        EComfyUIRequestPriority Priority = EComfyUIRequestPriority::Status);
     
-    // 图片下载请求
-    void DownloadImage(const FString& Url, TFunction<void(const TArray<uint8>& ImageData, bool bSuccess)> Callback);
+    // GET请求，响应体以原始 UTF-8 字节返回，不转换为 FString 也不拷贝（用于较大的 JSON 响应）
+    void SendGetRequestRaw(const FString& Url, TFunction<void(const FComfyUIHttpPayload& Content, bool bSuccess)> Callback, float TimeoutSeconds = 10.0f,
+                           EComfyUIRequestPriority Priority = EComfyUIRequestPriority::Status);
+    
+    // 图片下载请求，图像数据直接引用 HTTP 响应体，不拷贝
+    void DownloadImage(const FString& Url, TFunction<void(const FComfyUIHttpPayload& ImageData, bool bSuccess)> Callback);
     
     // 图片上传请求
-    void UploadImage(const FString& ServerUrl, const TArray<uint8>& ImageData, const FString& FileName, TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback);
+    void UploadImage(const FString& ServerUrl, TArray<uint8> ImageData, const FString& FileName, TFunction<void(const FString& UploadedImageName, bool bSuccess)> Callback);
     
     // 3D模型上传请求（使用ComfyUI的通用上传端点）
-    void UploadModel(const FString& ServerUrl, const TArray<uint8>& ModelData, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback);
+    void UploadModel(const FString& ServerUrl, TArray<uint8> ModelData, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback);
+    
+    // 3D模型上传请求，直接从磁盘流式读取文件，不把整个文件读入内存
+    void UploadModelFile(const FString& ServerUrl, const FString& FilePath, const FString& FileName, TFunction<void(const FString& UploadedModelName, bool bSuccess)> Callback);
+    
+    // 检查 input 目录中是否存在已上传的文件（HEAD /view?type=input），用于复用上传缓存
+    void CheckInputExists(const FString& ServerUrl, const FString& UploadedName, TFunction<void(bool bExists)> Callback);
+    
+    // 3D模型下载请求，模型数据直接引用 HTTP 响应体，不拷贝
+    void DownloadModel(const FString& Url, TFunction<void(const FComfyUIHttpPayload& ModelData, bool bSuccess)> Callback);
+    
+    // 下载到文件：响应体边接收边写入 Intermediate 下的部分文件，完成后移动到 DestFilePath
+    // 失败时保留已下载的部分，同一 URL 和目标路径再次下载时通过 Range 请求从断点继续
+    // OnProgress 在游戏线程触发，包含已续传的部分，BytesTotal 未知时为 -1
+    void DownloadToFile(const FString& Url, const FString& DestFilePath,
+                        TFunction<void(int64 BytesReceived, int64 BytesTotal)> OnProgress,
+                        TFunction<void(const FString& FilePath, bool bSuccess)> Callback,
+                        float TimeoutSeconds = 600.0f);
+    
+    // 轮询状态请求（/history/{prompt_id}，响应为 UTF-8 字节，用 FComfyUIHistoryScanner 解析）
+    void PollQueueStatus(const FString& ServerUrl, const FString& PromptId, TFunction<void(const FComfyUIHttpPayload& Response, bool bSuccess)> Callback);
+    
+    // 获取服务器队列（/queue，包含 queue_running 与 queue_pending）
+    void FetchQueue(const FString& ServerUrl, TFunction<void(const FString& Response, bool bSuccess)> Callback);
     
-    // 3D模型下载请求
-    void DownloadModel(const FString& Url, TFunction<void(const TArray<uint8>& ModelData, bool bSuccess)> Callback);
+    // 获取最近的历史记录（/history?max_items=N，响应为 UTF-8 字节）
+    void FetchHistory(const FString& ServerUrl, int32 MaxItems, TFunction<void(const FComfyUIHttpPayload& Response, bool bSuccess)> Callback);
     
-    // 轮询状态请求
-    void PollQueueStatus(const FString& ServerUrl, const FString& PromptId, TFunction<void(const FString& Response, bool bSuccess)> Callback);
+    // 从等待队列中删除 prompt（POST /queue {"delete": [...]}），已开始执行的 prompt 不受影响
+    void DeleteQueuedPrompts(const FString& ServerUrl, const TArray<FString>& PromptIds, TFunction<void(bool bSuccess)> Callback);
+    
+    // 中断正在执行的 prompt（POST /interrupt {"prompt_id": ...}）
+    // 旧版本服务器忽略 prompt_id，中断当前执行的任何 prompt，因此只在确认该 prompt 正在执行时调用
+    void InterruptPrompt(const FString& ServerUrl, const FString& PromptId, TFunction<void(bool bSuccess)> Callback);
+    
+    // 取消请求组中的所有请求：排队中的直接丢弃（不触发回调），已发出的中止（回调以失败结束）
+    void CancelRequestGroup(const FString& Group);
+    
+    // 获取服务器系统信息（/system_stats，包含各设备的显存）
+    void FetchSystemStats(const FString& ServerUrl, TFunction<void(const FString& Response, bool bSuccess)> Callback);
     
     // 测试服务器连接
     void TestServerConnection(const FString& ServerUrl, TFunction<void(bool bSuccess, const FString& ErrorMessage)> Callback);
     
-    // 错误处理和分析
+    // 错误处理和分析：只根据状态码和响应头分类，成功的响应不读取响应体
     FComfyUIError AnalyzeHttpError(FHttpRequestPtr Request, FHttpResponsePtr Response, bool bWasSuccessful);
     
     // 重试机制
@@ -48,7 +89,67 @@ public:
     // 用户友好的错误消息
     FString GetUserFriendlyErrorMessage(const FComfyUIError& Error);
     
+    // 请求调度统计（排队深度、并发数、平均等待时间）
+    FComfyUIRequestSchedulerStats GetSchedulerStats(const FString& ServerUrl) const;
+    
+    // 该服务器要求的剩余等待时间（熔断冷却或 Retry-After），重试前至少等待这么久
+    double GetRetryDelay(const FString& ServerUrl) const;
+    
 private:
+    friend class FComfyUIRequestGroupScope;
+    
+    // 通过熔断器和调度器发出请求（完成回调需已绑定）
+    void ProcessRequest(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request, EComfyUIRequestPriority Priority);
+    
+    // 当前请求组，ProcessRequest 把请求登记到该组
+    FString CurrentRequestGroup;
+    
+    // 各请求组中尚未结束的请求
+    TMap<FString, TArray<TWeakPtr<IHttpRequest, ESPMode::ThreadSafe>>> RequestGroups;
+    
+    // 由 CancelRequestGroup 中止的请求，完成时不计入熔断器
+    TSet<const IHttpRequest*> CancelledRequests;
+    
+
+    // 发送 multipart 上传请求到 /upload/image，并解析返回的文件名
+    void SendMultipartUpload(const FString& ServerUrl, TSharedRef<class FComfyUIMultipartFormStream, ESPMode::ThreadSafe> FormStream, float TimeoutSeconds, const FString& Label, TFunction<void(const FString& UploadedName, bool bSuccess)> Callback);
+    
     // HTTP模块引用
     FHttpModule* HttpModule;
+    
+    // 请求调度器，按服务器限制并发并按优先级排队
+    TSharedPtr<FComfyUIRequestScheduler> Scheduler;
+    
+    // 按端点的熔断器，已知不可用的端点直接失败
+    TSharedPtr<FComfyUICircuitBreaker> CircuitBreaker;
+};
+
+/**
+ * 请求组作用域：作用域内通过 NetworkManager 发出的请求归入 Group，之后可以用 CancelRequestGroup 一起取消
+ * 析构时恢复之前的请求组
+ */
+class FComfyUIRequestGroupScope
+{
+public:
+    FComfyUIRequestGroupScope(UComfyUINetworkManager* InManager, const FString& Group)
+        : Manager(InManager)
+    {
+        if (Manager)
+        {
+            PreviousGroup = Manager->CurrentRequestGroup;
+            Manager->CurrentRequestGroup = Group;
+        }
+    }
+
+    ~FComfyUIRequestGroupScope()
+    {
+        if (Manager)
+        {
+            Manager->CurrentRequestGroup = PreviousGroup;
+        }
+    }
+
+private:
+    UComfyUINetworkManager* Manager;
+    FString PreviousGroup;
 };
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include <atomic>
+
+/**
+ * 可续传下载的部分文件
+ * 未完成的下载保存在 Intermediate/ComfyUI/Downloads 下，同一 URL 和目标路径的下一次下载从已写入的位置继续，
+ * 通过 Range 请求剩余部分，If-Range 携带上次响应的 ETag/Last-Modified，文件在服务器上变化时服务器会返回完整内容。
+ */
+struct COMFYUIINTEGRATION_API FComfyUIPartialDownload
+{
+    /** 部分文件路径 */
+    FString PartFilePath;
+
+    /** 已写入的字节数，从这里继续下载 */
+    int64 ResumeOffset = 0;
+
+    /** 上次响应的校验值，用作 If-Range */
+    FString Validator;
+
+    /** 查找 Url 下载到 DestFilePath 的部分文件 */
+    static FComfyUIPartialDownload Find(const FString& Url, const FString& DestFilePath);
+
+    /** 为请求设置 Range 与 If-Range 头，没有可续传的内容时不设置 */
+    void ApplyToRequest(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request) const;
+
+    /** 保存响应中的校验值，供下次续传使用 */
+    void SaveValidator(FHttpResponsePtr Response) const;
+
+    /** 删除部分文件及其校验值 */
+    void Discard() const;
+
+    /** 解析 Content-Range（"bytes 0-99/1000" 或 "bytes *\/1000"），返回起始位置和总大小，未知的部分为 -1 */
+    static bool ParseContentRange(const FString& Header, int64& OutStart, int64& OutTotal);
+
+    /** 部分文件所在目录 */
+    static FString GetPartialDirectory();
+};
+
+/**
+ * 续传下载的响应体写入器
+ * 通过 IHttpRequest::SetResponseBodyReceiveStream 使用。收到第一段响应体时才打开文件：
+ * 服务器返回 206 且起始位置与已写入的位置一致时追加，返回 200 时从头覆盖，其他状态码的响应体丢弃，不破坏已下载的部分。
+ * Serialize 在 HTTP 线程调用。
+ */
+class COMFYUIINTEGRATION_API FComfyUIRangeFileWriter : public FArchive
+{
+public:
+    FComfyUIRangeFileWriter(const FString& InFilePath, int64 InResumeOffset);
+    virtual ~FComfyUIRangeFileWriter() override;
+
+    /** 写入器需要读取响应状态码决定写入方式，在发出请求前设置 */
+    void SetRequest(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& InRequest) { Request = InRequest; }
+
+    /** 本次响应体在文件中的起始位置：续传时为 ResumeOffset，从头下载时为 0。尚未收到响应体时为 -1 */
+    int64 GetStartOffset() const { return StartOffset.load(); }
+
+    // FArchive 接口
+    virtual void Serialize(void* Data, int64 Length) override;
+    virtual int64 Tell() override { return Position; }
+    virtual int64 TotalSize() override { return Position; }
+    virtual bool Close() override;
+    virtual FString GetArchiveName() const override { return TEXT("FComfyUIRangeFileWriter"); }
+
+private:
+    /** 按响应状态码打开文件 */
+    void OpenForResponse();
+
+    FString FilePath;
+    int64 ResumeOffset = 0;
+    int64 Position = 0;
+
+    TWeakPtr<IHttpRequest, ESPMode::ThreadSafe> Request;
+    TUniquePtr<FArchive> FileWriter;
+    bool bOpened = false;
+    bool bDiscardBody = false;
+    std::atomic<int64> StartOffset { -1 };
+};
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Interfaces/IHttpRequest.h"
+
+/**
+ * 请求优先级，数值越小优先级越高
+ */
+enum class EComfyUIRequestPriority : uint8
+{
+    Submit = 0,     // 提交 prompt
+    Status,         // 状态查询、连接测试
+    Download,       // 下载输出
+    Upload,         // 上传输入
+    Count
+};
+
+/**
+ * 单个服务器的调度统计
+ */
+struct COMFYUIINTEGRATION_API FComfyUIRequestSchedulerStats
+{
+    /** 正在执行的请求数（总数 / 下载与上传） */
+    int32 InFlight = 0;
+    int32 BulkInFlight = 0;
+
+    /** 各优先级排队中的请求数 */
+    int32 Queued[(int32)EComfyUIRequestPriority::Count] = {};
+
+    /** 历史最大排队深度 */
+    int32 PeakQueueDepth = 0;
+
+    /** 已发出的请求总数 */
+    int64 TotalDispatched = 0;
+
+    /** 排队等待时间（秒）的滑动平均 */
+    double AverageWaitSeconds = 0.0;
+
+    int32 GetQueueDepth() const
+    {
+        int32 Depth = 0;
+        for (int32 Count : Queued)
+        {
+            Depth += Count;
+        }
+        return Depth;
+    }
+};
+
+/**
+ * HTTP 请求调度器
+ * 按服务器（scheme://host:port）限制并发数，排队的请求按优先级发出：提交 > 状态 > 下载 > 上传。
+ * 下载和上传另有并发上限，为提交和状态查询保留连接，长时间的传输不会挡住轮询。
+ * 低优先级请求排队超过 StarvationSeconds 后按等待时间优先发出，避免在持续负载下饿死。
+ * 所有方法都在游戏线程调用（HTTP 完成回调默认派发到游戏线程）。
+ */
+class COMFYUIINTEGRATION_API FComfyUIRequestScheduler : public TSharedFromThis<FComfyUIRequestScheduler>
+{
+public:
+    /** 请求的完成回调必须在调用前绑定，调度器在完成时释放并发名额后再转发给原回调；未能发出的请求在下一帧以失败回调 */
+    void Enqueue(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request, EComfyUIRequestPriority Priority);
+
+    /** 某个服务器的统计，没有请求过时返回空统计 */
+    FComfyUIRequestSchedulerStats GetStats(const FString& Url) const;
+
+    /** 所有服务器排队中的请求总数 */
+    int32 GetTotalQueueDepth() const;
+
+    /** 从队列中移除尚未发出的请求（不会触发其回调），请求不在队列中时返回 false */
+    bool Remove(const TSharedRef<IHttpRequest, ESPMode::ThreadSafe>& Request);
+
+    /** 丢弃所有排队中的请求（不会触发其回调） */
+    void Reset();
+
+    /** 每个服务器的最大并发请求数 */
+    int32 MaxConcurrentPerHost = 6;
+
+    /** 其中下载和上传最多占用的并发数 */
+    int32 MaxBulkPerHost = 4;
+
+    /** 排队超过该时间的请求不再按优先级让路 */
+    double StarvationSeconds = 10.0;
+
+    /** 从 URL 中取出 scheme://host:port 作为服务器键 */
+    static FString GetHostKey(const FString& Url);
+
+private:
+    struct FQueuedRequest
+    {
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> Request;
+        EComfyUIRequestPriority Priority;
+        double EnqueueTime;
+    };
+
+    struct FHostState
+    {
+        TArray<FQueuedRequest> Queues[(int32)EComfyUIRequestPriority::Count];
+        FComfyUIRequestSchedulerStats Stats;
+    };
+
+    static bool IsBulk(EComfyUIRequestPriority Priority)
+    {
+        return Priority == EComfyUIRequestPriority::Download || Priority == EComfyUIRequestPriority::Upload;
+    }
+
+    /** 在名额允许时发出该服务器排队中的请求 */
+    void Pump(const FString& HostKey);
+
+    /** 选出下一个要发出的优先级队列，没有可发出的返回 INDEX_NONE */
+    int32 PickQueue(const FHostState& Host, double Now) const;
+
+    void Dispatch(const FString& HostKey, FHostState& Host, FQueuedRequest&& Item, double Now);
+    void OnRequestFinished(const FString& HostKey, EComfyUIRequestPriority Priority);
+
+    TMap<FString, FHostState> Hosts;
+};
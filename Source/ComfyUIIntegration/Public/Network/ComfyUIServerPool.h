@@ -0,0 +1,125 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+
+class UComfyUINetworkManager;
+struct FComfyUIQueueSnapshot;
+
+/**
+ * 选择服务器的策略
+ */
+enum class EComfyUIServerSelectionPolicy : uint8
+{
+    ShortestQueue,  // 有效队列最短，相同时选显存空闲最多的
+    MostFreeVram    // 显存空闲最多，相同时选队列最短的
+};
+
+/**
+ * 服务器池中一台服务器的健康状态
+ */
+struct COMFYUIINTEGRATION_API FComfyUIServerStatus
+{
+    FString Url;
+
+    /** 是否可用（尚未检查过的服务器视为可用） */
+    bool bHealthy = true;
+    bool bChecked = false;
+
+    /** 最近一次检查时的队列长度 */
+    int32 QueueRunning = 0;
+    int32 QueuePending = 0;
+
+    /** 上次检查之后分配到这台服务器的任务数，尚未反映在队列快照中 */
+    int32 AssignedSinceCheck = 0;
+
+    /** 所有设备的显存合计（字节），未知时为 -1 */
+    int64 VramFree = -1;
+    int64 VramTotal = -1;
+
+    /** 服务器能力（/system_stats），未知时为空 */
+    FString ComfyUIVersion;
+    FString DeviceName;
+
+    int32 ConsecutiveFailures = 0;
+
+    /** 最近一次确认服务器状态的时间（健康检查或队列查询），失败时清零使快照失效 */
+    double LastCheckTime = 0.0;
+
+    /** 用于比较负载的有效队列长度 */
+    int32 GetEffectiveQueue() const { return QueueRunning + QueuePending + AssignedSinceCheck; }
+};
+
+/**
+ * ComfyUI 服务器池
+ * 通过 /system_stats 和 /queue 检查每台服务器的健康状态与负载，新任务分配到负载最低的可用服务器。
+ * 任务一旦分配就固定在该服务器上：输入上传、提交、状态查询和 /view 下载都发往同一台服务器。
+ * 只配置一台服务器时行为与单服务器完全相同。
+ */
+class COMFYUIINTEGRATION_API FComfyUIServerPool : public TSharedFromThis<FComfyUIServerPool>
+{
+public:
+    explicit FComfyUIServerPool(UComfyUINetworkManager* InNetworkManager);
+
+    /** 设置服务器列表（去重并去掉末尾的 /），列表变化时清空健康状态 */
+    void SetServers(const TArray<FString>& Urls);
+
+    const TArray<FComfyUIServerStatus>& GetServers() const { return Servers; }
+    bool IsEmpty() const { return Servers.Num() == 0; }
+
+    /** 列表中的第一台服务器 */
+    FString GetPrimaryServer() const;
+
+    /** 为新任务选择服务器，并计入该服务器的待处理任务数。健康状态过期时在后台刷新 */
+    FString PickServer();
+
+    /** 请求失败时标记服务器不可用，下次检查时恢复 */
+    void ReportFailure(const FString& Url);
+
+    /** 批量状态查询拿到的队列快照也用于更新负载 */
+    void UpdateQueue(const FString& Url, const FComfyUIQueueSnapshot& Snapshot);
+
+    /** 检查所有服务器，全部完成后调用 OnComplete */
+    void RefreshHealth(TFunction<void()> OnComplete = nullptr);
+
+    /** 距离上次检查超过 HealthCheckInterval 时刷新 */
+    void RefreshIfStale();
+
+    /** 服务器在 HealthSnapshotTTL 内确认过可用 */
+    bool IsHealthyFresh(const FString& Url) const;
+
+    /** 池中是否有服务器在 HealthSnapshotTTL 内确认过可用，可用时无需再测试连接 */
+    bool HasFreshHealthyServer() const;
+
+    /** 使服务器的健康快照失效（例如事件通道断开），下次使用前重新检查，但不标记为不可用 */
+    void Invalidate(const FString& Url);
+
+    /** 解析 /system_stats 响应中的显存和版本信息 */
+    static bool ParseSystemStats(const FString& ResponseContent, FComfyUIServerStatus& OutStatus);
+
+    /** 规范化服务器地址，用于比较 */
+    static FString NormalizeUrl(const FString& Url);
+
+    EComfyUIServerSelectionPolicy Policy = EComfyUIServerSelectionPolicy::ShortestQueue;
+    double HealthCheckInterval = 5.0;
+
+    /** 健康快照的有效期 */
+    double HealthSnapshotTTL = 30.0;
+
+private:
+    FComfyUIServerStatus* FindServer(const FString& Url);
+
+    void CheckServer(const FString& Url);
+    void OnServerChecked(const FString& Url, bool bHealthy);
+
+    /** a 是否比 b 更适合接收新任务 */
+    bool IsBetterCandidate(const FComfyUIServerStatus& A, const FComfyUIServerStatus& B) const;
+
+    TWeakObjectPtr<UComfyUINetworkManager> NetworkManager;
+    TArray<FComfyUIServerStatus> Servers;
+
+    /** 正在进行的检查 */
+    int32 PendingChecks = 0;
+    double LastRefreshTime = -1.0;
+    TArray<TFunction<void()>> RefreshCallbacks;
+};
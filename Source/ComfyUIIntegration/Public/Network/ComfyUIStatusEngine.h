@@ -0,0 +1,81 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include "Network/ComfyUIHistoryScanner.h"
+#include "Network/ComfyUIHttpPayload.h"
+
+class UComfyUINetworkManager;
+
+/**
+ * /queue 响应的快照
+ * 记录每个 prompt_id 在队列中的位置：0 表示正在执行，>=1 表示等待队列中的位置
+ */
+struct COMFYUIINTEGRATION_API FComfyUIQueueSnapshot
+{
+    TMap<FString, int32> Positions;
+    int32 RunningCount = 0;
+    int32 PendingCount = 0;
+
+    /** 返回 prompt 在队列中的位置，不在队列中返回 INDEX_NONE */
+    int32 GetPosition(const FString& PromptId) const
+    {
+        const int32* Found = Positions.Find(PromptId);
+        return Found ? *Found : INDEX_NONE;
+    }
+};
+
+/**
+ * 一次批量状态查询的结果
+ */
+struct COMFYUIINTEGRATION_API FComfyUIStatusBatch
+{
+    FComfyUIQueueSnapshot Queue;
+
+    /** /history?max_items= 的响应，按 prompt_id 索引 */
+    TMap<FString, FComfyUIHistoryEntry> History;
+
+    /** 本轮请求的历史记录窗口大小 */
+    int32 HistoryWindow = 0;
+
+    /** 取出某个 prompt 的历史记录，不在窗口内返回空 */
+    const FComfyUIHistoryEntry* FindHistoryEntry(const FString& PromptId) const;
+};
+
+DECLARE_DELEGATE_TwoParams(FOnComfyUIStatusBatch, const FComfyUIStatusBatch& /* Batch */, bool /* bSuccess */)
+
+/**
+ * 批量状态查询
+ * 每轮只发出一次 /queue 和一次 /history?max_items=，结果由调用方分发给所有进行中的任务，
+ * 状态请求数量与任务数量无关。/queue 先于 /history 请求：
+ * 不在队列快照里的 prompt 一定在随后的历史记录中（除非超出窗口，由调用方单独补查）。
+ * 响应在工作线程解析，结果回到游戏线程后再交给调用方。
+ */
+class COMFYUIINTEGRATION_API FComfyUIStatusEngine : public TSharedFromThis<FComfyUIStatusEngine>
+{
+public:
+    explicit FComfyUIStatusEngine(UComfyUINetworkManager* InNetworkManager);
+
+    /** 发起一轮查询，上一轮未结束时忽略并返回 false */
+    bool RunCycle(const FString& ServerUrl, int32 HistoryWindow, const FOnComfyUIStatusBatch& OnComplete);
+
+    /** 是否有正在进行的查询 */
+    bool IsCycleInFlight() const { return bCycleInFlight; }
+
+    /** 解析 /queue 响应（队列项为数组：[number, prompt_id, prompt, extra_data, outputs_to_execute]） */
+    static bool ParseQueueSnapshot(const FString& ResponseContent, FComfyUIQueueSnapshot& OutSnapshot);
+
+private:
+    void OnQueueFetched(const FString& ResponseContent, bool bSuccess);
+    void OnQueueParsed(FComfyUIQueueSnapshot&& Snapshot, bool bParsed);
+    void OnHistoryFetched(const FComfyUIHttpPayload& ResponseContent, bool bSuccess);
+    void CompleteCycle(bool bSuccess);
+
+    TWeakObjectPtr<UComfyUINetworkManager> NetworkManager;
+
+    /** 当前轮次的状态 */
+    bool bCycleInFlight = false;
+    FString CycleServerUrl;
+    FComfyUIStatusBatch PendingBatch;
+    FOnComfyUIStatusBatch PendingCallback;
+};
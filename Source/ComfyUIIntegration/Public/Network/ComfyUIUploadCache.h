@@ -0,0 +1,76 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * 上传缓存的一条记录：某个服务器上已上传内容的文件名
+ */
+struct COMFYUIINTEGRATION_API FComfyUIUploadCacheEntry
+{
+    /** /upload/image 返回的名称（包含子目录），工作流中直接引用 */
+    FString UploadedName;
+
+    /** 内容大小，用于日志和统计 */
+    int64 Size = 0;
+
+    /** 最近一次使用的时间，超出容量时淘汰最久未用的记录 */
+    FDateTime LastUsed;
+
+    /** 本次会话中最近一次确认服务器上文件存在的时间（不持久化） */
+    double LastVerifiedTime = -1.0;
+};
+
+/**
+ * 按内容哈希索引的上传缓存
+ * 以 (服务器, 内容的 xxHash64) 为键记录服务器端的文件名，相同内容再次上传时直接复用。
+ * 缓存持久化到 Saved/ComfyUI/UploadCache.json，跨会话有效；复用前由调用方确认文件仍在服务器上。
+ * 本地文件的哈希按 (路径, 大小, 修改时间) 缓存，未修改的模型文件不需要重新读取计算。
+ */
+class COMFYUIINTEGRATION_API FComfyUIUploadCache
+{
+public:
+    explicit FComfyUIUploadCache(const FString& InCacheFilePath);
+
+    /** 计算内存数据的内容哈希 */
+    static FString HashData(const TArray<uint8>& Data);
+
+    /** 计算文件的内容哈希（分块读取），文件未修改时直接返回缓存的结果。读取失败返回空字符串 */
+    FString HashFile(const FString& FilePath);
+
+    /** 查找已上传的记录，找到时更新使用时间 */
+    FComfyUIUploadCacheEntry* Find(const FString& ServerUrl, const FString& ContentHash);
+
+    /** 记录一次成功的上传 */
+    void Add(const FString& ServerUrl, const FString& ContentHash, const FString& UploadedName, int64 Size);
+
+    /** 服务器上的文件已不存在时移除记录 */
+    void Remove(const FString& ServerUrl, const FString& ContentHash);
+
+    /** 从磁盘加载 / 保存到磁盘 */
+    void Load();
+    void Save() const;
+
+    /** 已确认存在的记录在这段时间内复用时不再检查服务器 */
+    static constexpr double VerifyIntervalSeconds = 60.0;
+
+private:
+    /** 服务器地址规范化后与哈希拼接为键 */
+    static FString MakeKey(const FString& ServerUrl, const FString& ContentHash);
+
+    /** 超出容量时淘汰最久未用的记录 */
+    void Prune();
+
+    /** 本地文件哈希缓存的记录 */
+    struct FFileHashEntry
+    {
+        int64 Size = 0;
+        FDateTime Timestamp;
+        FString Hash;
+    };
+
+    FString CacheFilePath;
+    TMap<FString, FComfyUIUploadCacheEntry> Entries;
+    TMap<FString, FFileHashEntry> FileHashes;
+
+    int32 MaxEntries = 1024;
+};
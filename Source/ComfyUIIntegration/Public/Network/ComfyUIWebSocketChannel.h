@@ -0,0 +1,121 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+
+class IWebSocket;
+class FJsonObject;
+
+/**
+ * ComfyUI 服务器推送事件类型（对应 /ws 消息的 type 字段）
+ */
+enum class EComfyUIServerEventType : uint8
+{
+    Status,            // 队列状态变化
+    ExecutionStart,    // 开始执行某个 prompt
+    ExecutionCached,   // 部分节点命中缓存
+    Executing,         // 正在执行某个节点（node 为空表示该 prompt 执行结束）
+    Progress,          // 节点内部进度（如采样步数）
+    Executed,          // 某个节点执行完成并产生输出
+    ExecutionSuccess,  // prompt 执行成功
+    ExecutionError,    // prompt 执行出错
+    ExecutionInterrupted, // prompt 被中断
+    Unknown
+};
+
+/**
+ * 从 WebSocket 解析出的单条服务器事件
+ */
+struct COMFYUIINTEGRATION_API FComfyUIServerEvent
+{
+    EComfyUIServerEventType Type = EComfyUIServerEventType::Unknown;
+
+    /** 事件所属的 prompt_id（status 事件为空） */
+    FString PromptId;
+
+    /** 当前节点ID（executing/progress/executed） */
+    FString NodeId;
+
+    /** progress 事件的当前值与最大值 */
+    int32 ProgressValue = 0;
+    int32 ProgressMax = 0;
+
+    /** status 事件中的剩余队列长度 */
+    int32 QueueRemaining = -1;
+
+    /** executed 事件的输出，execution_error 事件的完整数据 */
+    TSharedPtr<FJsonObject> Data;
+
+    /** execution_error 事件的错误描述 */
+    FString ErrorMessage;
+
+    /** executing 事件且 node 为空时为 true，表示该 prompt 已执行完毕 */
+    bool IsPromptFinished() const
+    {
+        return Type == EComfyUIServerEventType::ExecutionSuccess
+            || (Type == EComfyUIServerEventType::Executing && !PromptId.IsEmpty() && NodeId.IsEmpty());
+    }
+};
+
+DECLARE_DELEGATE_OneParam(FOnComfyUIServerEvent, const FComfyUIServerEvent& /* Event */)
+DECLARE_DELEGATE_OneParam(FOnComfyUIChannelStateChanged, bool /* bConnected */)
+
+/**
+ * ComfyUI WebSocket 事件通道
+ * 维持到 /ws?clientId= 的长连接，把服务器推送的事件转发给客户端；
+ * 断线后按固定间隔自动重连，期间由客户端回退到 HTTP 轮询
+ */
+class COMFYUIINTEGRATION_API FComfyUIWebSocketChannel : public TSharedFromThis<FComfyUIWebSocketChannel>
+{
+public:
+    FComfyUIWebSocketChannel(const FString& InServerUrl, const FString& InClientId);
+    ~FComfyUIWebSocketChannel();
+
+    /** 建立连接（已连接或正在连接时忽略） */
+    void Connect();
+
+    /** 关闭连接并停止自动重连 */
+    void Close();
+
+    /** 当前是否已连接 */
+    bool IsConnected() const;
+
+    const FString& GetServerUrl() const { return ServerUrl; }
+    const FString& GetClientId() const { return ClientId; }
+
+    /** 事件回调（在游戏线程触发） */
+    FOnComfyUIServerEvent OnServerEvent;
+    FOnComfyUIChannelStateChanged OnStateChanged;
+
+    /** 由 HTTP 地址构建 WebSocket 地址：http://host:port -> ws://host:port/ws?clientId=xxx */
+    static FString BuildWebSocketUrl(const FString& HttpUrl, const FString& ClientId);
+
+    /** 解析单条文本消息，失败返回 false */
+    static bool ParseServerMessage(const FString& Message, FComfyUIServerEvent& OutEvent);
+
+private:
+    void HandleConnected();
+    void HandleConnectionError(const FString& Error);
+    void HandleClosed(int32 StatusCode, const FString& Reason, bool bWasClean);
+    void HandleMessage(const FString& Message);
+
+    /** 安排一次延迟重连 */
+    void ScheduleReconnect();
+    bool HandleReconnect(float DeltaTime);
+
+    void SetConnected(bool bNewConnected);
+
+    /** 解绑并在下一帧释放当前连接 */
+    void ReleaseWebSocket();
+
+    FString ServerUrl;
+    FString ClientId;
+
+    TSharedPtr<IWebSocket> WebSocket;
+    bool bConnected = false;
+    bool bWantConnection = false;
+
+    /** 重连配置 */
+    float ReconnectDelaySeconds = 5.0f;
+    FTSTicker::FDelegateHandle ReconnectTickerHandle;
+};
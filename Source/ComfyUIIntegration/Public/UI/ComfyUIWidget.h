@@ -70,6 +70,9 @@ private:
     UPROPERTY()
     UComfyUIClient* CurrentClient;
 
+    /** 当前任务的 prompt_id（用于只取消本窗口发起的任务） */
+    FString CurrentPromptId;
+
     /** UI组件 */
     UPROPERTY()
     TSharedPtr<SMultiLineEditableTextBox> PromptTextBox;
@@ -142,9 +145,9 @@ private:
     UPROPERTY()
     UStaticMesh* GeneratedMesh;
     
-    /** 生成的3D模型原始数据（用于保存为原格式） */
+    /** 生成的3D模型下载到本地的原始文件（用于保存为原格式） */
     UPROPERTY()
-    TArray<uint8> GeneratedMeshOriginalData;
+    FString GeneratedMeshSourcePath;
     UPROPERTY()
     FString GeneratedMeshOriginalFormat; // "gltf", "glb", "obj", etc.
     
@@ -188,6 +191,9 @@ private:
     FText GetCustomWorkflowText(TSharedPtr<FString> InOption) const;
     void OnCustomWorkflowChanged(TSharedPtr<FString> NewSelection, ESelectInfo::Type SelectInfo);
     
+    /** 模板热重载后刷新列表，保留当前选择并重新检测类型 */
+    void OnCustomWorkflowsReloaded();
+    
     /** 工具函数 */
     void RefreshCustomWorkflowList();
     void UpdateWorkflowVisibility();
@@ -207,6 +213,7 @@ private:
     EVisibility GetPromptInputVisibility() const;
     EVisibility GetProgressVisibility() const;
     EVisibility GetCancelButtonVisibility() const;
+    bool IsCancelButtonEnabled() const;
     FText GetCurrentWorkflowTypeText() const;
     FText GetDetectedWorkflowTypeText() const;
     
@@ -225,7 +232,7 @@ private:
     
     /** 内容生成回调 */
     void OnImageGenerationComplete(UTexture2D* GeneratedImage);
-    void OnMeshGenerationComplete(UStaticMesh* InGeneratedMesh, const TArray<uint8>& OriginalData, const FString& OriginalFormat);
+    void OnMeshGenerationComplete(UStaticMesh* InGeneratedMesh, const FString& SourceFilePath, const FString& OriginalFormat);
     void OnGenerationProgressUpdate(const FComfyUIProgressInfo& ProgressInfo);
     void OnGenerationStarted(const FString& PromptId);
     void OnGenerationCompleted();
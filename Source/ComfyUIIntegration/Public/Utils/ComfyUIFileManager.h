@@ -37,6 +37,12 @@ public:
     // 创建纹理从图像数据
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
     static UTexture2D* CreateTextureFromImageData(const TArray<uint8>& ImageData);
+
+    // 把压缩图像（PNG/JPEG/BMP/EXR）解码为 BGRA8 像素，可在任意线程调用（ImageWrapper 模块需已在游戏线程加载）
+    static bool DecodeImageData(const TArray<uint8>& ImageData, TArray<uint8>& OutBGRA, int32& OutWidth, int32& OutHeight);
+
+    // 用解码后的 BGRA8 像素创建临时纹理，只能在游戏线程调用
+    static UTexture2D* CreateTextureFromBGRA(const TArray<uint8>& BGRA, int32 Width, int32 Height);
     
     // 从纹理提取图像数据
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
@@ -96,6 +102,16 @@ public:
     static FString GetTemplatesDirectory();
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
     static FString GetConfigDirectory();
+    
+    // 插件在 Intermediate 下的工作目录（下载的模型、临时文件）
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
+    static FString GetIntermediateDirectory();
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
+    static FString GetDownloadsDirectory();
+    
+    // 插件在 Saved 下的持久化缓存目录（跨会话保留）
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|File")
+    static FString GetCacheDirectory();
 
     // === 工作流模板操作 ===
     // 导入工作流模板
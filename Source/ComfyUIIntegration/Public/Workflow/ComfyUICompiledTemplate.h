@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+/**
+ * 绑定到模板占位符的值
+ */
+struct COMFYUIINTEGRATION_API FComfyUITemplateValue
+{
+    enum class EType : uint8
+    {
+        String,
+        Number,
+        Boolean
+    };
+
+    EType Type = EType::String;
+    FString String;
+    double Number = 0.0;
+    bool bBoolean = false;
+
+    static FComfyUITemplateValue MakeString(const FString& Value);
+    static FComfyUITemplateValue MakeNumber(double Value);
+    static FComfyUITemplateValue MakeBoolean(bool Value);
+
+    /** 嵌在字符串中时的文本形式 */
+    FString ToText() const;
+};
+
+/** 占位符名（大写，不含大括号）到值的绑定 */
+using FComfyUITemplateBindings = TMap<FString, FComfyUITemplateValue>;
+
+/**
+ * 编译后的工作流模板
+ * 加载时把模板 JSON 压缩并切分为字面量片段和占位符槽位，构建请求时单遍写出，不再逐个参数替换整个模板，
+ * 也不再解析和重新序列化结果：
+ * - 整个字符串值就是占位符（"{POSITIVE_PROMPT}"）的槽位按绑定的类型写出，数值写为 JSON 数字，布尔写为 true/false，字符串转义
+ * - 嵌在字符串中的占位符（"a photo of {SUBJECT}"）写入转义后的文本
+ * - 没有绑定的占位符保留原文
+ * 占位符与 ReplaceWorkflowPlaceholders 相同：大括号中的大写字母、数字和下划线。编译后不可变，可以在线程间共享。
+ */
+class COMFYUIINTEGRATION_API FComfyUICompiledTemplate
+{
+public:
+    /** 编译模板，模板不是合法的 JSON 对象时返回空；OutParsed 取回验证时解析出的对象，调用方不必再解析一次 */
+    static TSharedPtr<const FComfyUICompiledTemplate> Compile(const FString& TemplateJson, FString* OutError = nullptr, TSharedPtr<FJsonObject>* OutParsed = nullptr);
+
+    /** 把绑定后的工作流 JSON 追加到 Out，Bindings 中没有的占位符再到 Defaults 中查找 */
+    void Write(const FComfyUITemplateBindings& Bindings, FString& Out, const FComfyUITemplateBindings* Defaults = nullptr) const;
+
+    /** 构建 /prompt 请求体：{"client_id":...,"prompt":<工作流>} */
+    FString BuildRequest(const FComfyUITemplateBindings& Bindings, const FString& ClientId, const FComfyUITemplateBindings* Defaults = nullptr) const;
+
+    /** 模板中出现的占位符名，按首次出现的顺序 */
+    const TArray<FString>& GetPlaceholderNames() const { return PlaceholderNames; }
+
+    /** 模板内容的哈希（忽略字符串之外的空白），用于识别重复的工作流 */
+    uint64 GetContentHash() const { return ContentHash; }
+
+    /** 把字符串转义后追加到 Out（不含引号） */
+    static void AppendEscaped(FString& Out, const FString& Value);
+
+    /** 追加 JSON 数字，整数值不带小数点 */
+    static void AppendNumber(FString& Out, double Value);
+
+private:
+    struct FSlot
+    {
+        /** 槽位之前的字面量 */
+        FString Literal;
+
+        /** 占位符名 */
+        FString Name;
+
+        /** 占位符是整个字符串值（引号不在字面量中） */
+        bool bWholeValue = false;
+    };
+
+    /** 编译一个字符串字面量的内容（转义形式，不含引号） */
+    void CompileString(const TCHAR* Content, int32 Num, FString& Literal);
+    void AddSlot(FString& Literal, FString&& Name, bool bWholeValue);
+
+    TArray<FSlot> Slots;
+    FString TrailingLiteral;
+    TArray<FString> PlaceholderNames;
+
+    /** 所有字面量的总长度，用于预分配输出 */
+    int32 LiteralLength = 0;
+
+    uint64 ContentHash = 0;
+};
+
+/**
+ * 工作流模板句柄
+ * 持有编译后的模板和取句柄时工作流上已设置参数的快照，两者都不可变。
+ * 构建请求只读取句柄和调用方传入的绑定，不修改任何共享状态，同一句柄可以在任意线程同时构建多个请求。
+ */
+struct COMFYUIINTEGRATION_API FComfyUIWorkflowTemplate
+{
+    FString WorkflowName;
+    TSharedPtr<const FComfyUICompiledTemplate> Compiled;
+
+    /** 工作流上已设置的参数（键为大写占位符名），优先级低于构建时传入的绑定 */
+    TSharedPtr<const FComfyUITemplateBindings> Defaults;
+
+    bool IsValid() const { return Compiled.IsValid(); }
+
+    /** 构建 /prompt 请求体，句柄无效时返回空字符串 */
+    FString BuildRequest(const FComfyUITemplateBindings& Bindings, const FString& ClientId = TEXT("unreal_engine_plugin")) const;
+};
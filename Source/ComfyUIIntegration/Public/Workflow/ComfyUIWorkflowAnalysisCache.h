@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ComfyUIWorkflowConfig.h"
+
+/**
+ * 一个工作流模板的节点分析结果，即 FWorkflowConfig 中由分析得到的部分
+ */
+struct COMFYUIINTEGRATION_API FComfyUIWorkflowAnalysis
+{
+    TArray<FString> RequiredInputs;
+    TArray<FString> OutputNodes;
+    EComfyUIWorkflowType DetectedType = EComfyUIWorkflowType::Unknown;
+    TArray<FWorkflowParameterDef> ParameterDefinitions;
+    TArray<FWorkflowInputInfo> WorkflowInputs;
+    TArray<FWorkflowOutputInfo> WorkflowOutputs;
+
+    static FComfyUIWorkflowAnalysis FromConfig(const FWorkflowConfig& Config);
+    void ApplyTo(FWorkflowConfig& Config) const;
+
+    void Serialize(FArchive& Ar);
+};
+
+/**
+ * 工作流分析结果的磁盘缓存
+ * 以模板内容哈希为键，保存在 Saved/ComfyUI/WorkflowAnalysis.bin（紧凑的二进制格式）。
+ * 文件头记录分析器版本，节点分析逻辑变化后旧缓存整体失效；未修改的模板启动时不再解析和分析 JSON。
+ */
+class COMFYUIINTEGRATION_API FComfyUIWorkflowAnalysisCache
+{
+public:
+    explicit FComfyUIWorkflowAnalysisCache(const FString& InCacheFilePath);
+
+    /** 查找分析结果，没有时返回空 */
+    const FComfyUIWorkflowAnalysis* Find(uint64 ContentHash);
+
+    /** 记录一次分析的结果 */
+    void Add(uint64 ContentHash, FComfyUIWorkflowAnalysis&& Analysis);
+
+    /** 从磁盘加载 / 保存到磁盘 */
+    void Load();
+    void Save();
+
+    /**
+     * 分析器版本，UComfyUINodeAnalyzer 或 UComfyUIWorkflowManager 的节点分析逻辑、
+     * 以及上面几个结构的字段变化时递增
+     */
+    static constexpr uint32 AnalyzerVersion = 1;
+
+private:
+    struct FCachedAnalysis
+    {
+        FComfyUIWorkflowAnalysis Analysis;
+
+        /** 本次会话中是否用到，超出容量时只保留用到的记录 */
+        bool bUsed = false;
+    };
+
+    FString CacheFilePath;
+    TMap<uint64, FCachedAnalysis> Entries;
+
+    int32 MaxEntries = 4096;
+};
@@ -36,6 +36,7 @@ enum class EComfyUINodeOutputType : uint8
     Material    UMETA(DisplayName = "材质"),
     Video       UMETA(DisplayName = "视频"),
     Audio       UMETA(DisplayName = "音频"),
+    Text        UMETA(DisplayName = "文本"),
     Unknown     UMETA(DisplayName = "未知")
 };
 
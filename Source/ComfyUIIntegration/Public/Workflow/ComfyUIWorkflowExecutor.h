@@ -23,6 +23,17 @@ struct COMFYUIINTEGRATION_API FComfyUIWorkflowExecutorParams
     UPROPERTY(BlueprintReadWrite, Category = "ComfyUI")
     FComfyUIWorkflowInput Input;
 
+    // 执行任务的服务器，为空时由客户端从服务器池中选择。输入上传和提交使用同一台服务器
+    UPROPERTY(BlueprintReadWrite, Category = "ComfyUI")
+    FString ServerUrl;
+
+    // 相同请求（模板、参数和输入内容都相同）已有缓存的结果时直接交付，不提交到服务器
+    UPROPERTY(BlueprintReadWrite, Category = "ComfyUI")
+    bool bUseResultCache = true;
+
+    // 上传输入的内容哈希（参数名 -> 哈希），结果缓存的键按内容而不是服务器上的文件名计算
+    TMap<FString, FString> InputContentHashes;
+
     // 回调委托（C++专用，不暴露给蓝图）
     FOnImageGenerated OnImageGenerated;
     FOnMeshGenerated OnMeshGenerated;
@@ -30,6 +41,9 @@ struct COMFYUIINTEGRATION_API FComfyUIWorkflowExecutorParams
     FOnGenerationStarted OnStarted;
     FOnGenerationFailed OnFailed;
     FOnGenerationCompleted OnCompleted;
+
+    // 所有输出处理完毕后交付完整结果（多图批量输出、文本输出等）
+    FOnComfyUIWorkflowCompleted OnWorkflowCompleted;
 };
 
 class FComfyUIWorkflowExecutor
@@ -59,4 +73,7 @@ private:
     
     // 内部实现函数
     static FString GetWorkflowNameFromType(EComfyUIWorkflowType WorkflowType);
+    
+    // 结果缓存的键：上传的输入按内容哈希绑定，不使用结果缓存或模板不可用时返回空字符串
+    static FString MakeResultCacheKey(const FComfyUIWorkflowExecutorParams& Params);
 };
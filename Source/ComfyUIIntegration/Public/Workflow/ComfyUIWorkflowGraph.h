@@ -0,0 +1,93 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FJsonObject;
+
+/**
+ * 一次图优化的统计
+ */
+struct COMFYUIINTEGRATION_API FComfyUIGraphOptimizeStats
+{
+    int32 NodesBefore = 0;
+    int32 NodesAfter = 0;
+
+    /** 从输出节点不可达、被删除的节点 */
+    TArray<FString> PrunedNodes;
+
+    /** 与保存节点显示同一输出、被删除的预览节点 */
+    TArray<FString> PrunedPreviews;
+
+    /** 被合并的重复加载节点 -> 保留的节点 */
+    TMap<FString, FString> MergedNodes;
+
+    /** 拓扑深度：最长依赖链上的节点数 */
+    int32 MaxDepth = 0;
+
+    bool HasChanges() const { return NodesAfter != NodesBefore; }
+
+    FString ToString() const;
+};
+
+/**
+ * API 格式工作流的节点依赖图
+ * 节点之间的链接是 inputs 中形如 ["节点ID", 整数输出槽] 的两元素数组。
+ * 可在任意线程使用。
+ */
+class COMFYUIINTEGRATION_API FComfyUIWorkflowGraph
+{
+public:
+    /** 构建依赖图，节点格式错误、链接指向不存在的节点或存在环时返回 false */
+    bool Build(const TSharedPtr<FJsonObject>& Workflow, FString* OutError = nullptr);
+
+    /** 按拓扑顺序（依赖在前）的节点ID */
+    const TArray<FString>& GetTopologicalOrder() const { return TopologicalOrder; }
+
+    /** 节点的拓扑深度（没有依赖的节点为 1），节点不存在时返回 0 */
+    int32 GetDepth(const FString& NodeId) const;
+    int32 GetMaxDepth() const { return MaxDepth; }
+
+    /**
+     * 在工作流 JSON 上原地优化，提交前去掉不会影响输出的节点：
+     * - 合并 class_type 和输入完全相同的加载节点，链接改为指向保留的节点
+     * - 删除与保存节点显示同一输出的 PreviewImage
+     * - 删除从输出节点不可达的分支
+     * 依赖图无法构建时不做修改并返回 false
+     */
+    static bool Optimize(const TSharedPtr<FJsonObject>& Workflow, FComfyUIGraphOptimizeStats& OutStats, FString* OutError = nullptr);
+
+    /**
+     * 在 JSON 文本上执行 Optimize，接受 {"prompt": {节点}} 或直接的节点表（包括含占位符的模板）
+     * 只删除节点并改写指向被合并节点的链接（恰好两个元素、第二个是整数的数组），其余文本原样保留，数值不经过 double。
+     * 按类名判断输出节点，可能误删有副作用的自定义节点，由工作流管理器按模板启用，在编译时执行一次。
+     * 没有可优化的节点或依赖图无法构建时不修改并返回 false
+     */
+    static bool OptimizeRequest(FString& RequestJson, FComfyUIGraphOptimizeStats& OutStats, FString* OutError = nullptr);
+
+    /** 按 ComfyUI 的命名习惯判断输出节点（Save/Preview/Show/Export/Output） */
+    static bool IsOutputNode(const FString& ClassType);
+
+    /** 没有链接输入的加载节点，输入相同时结果相同 */
+    static bool IsLoaderNode(const FString& ClassType);
+
+    /** 已知的中间节点，没有下游时不会产生任何输出 */
+    static bool IsIntermediateNode(const FString& ClassType);
+
+private:
+    struct FNode
+    {
+        FString ClassType;
+
+        /** 链接到的上游节点（可能重复） */
+        TArray<FString> Dependencies;
+
+        /** 被多少个下游链接引用 */
+        int32 ConsumerCount = 0;
+
+        int32 Depth = 0;
+    };
+
+    TMap<FString, FNode> Nodes;
+    TArray<FString> TopologicalOrder;
+    int32 MaxDepth = 0;
+};
@@ -3,9 +3,63 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "ComfyUIWorkflowConfig.h"
+#include "Workflow/ComfyUICompiledTemplate.h"
+#include "Workflow/ComfyUIWorkflowAnalysisCache.h"
 #include "ComfyUIWorkflowManager.generated.h"
 
 class FJsonObject;
+class UComfyUINodeAnalyzer;
+struct FFileChangeData;
+
+/** 热重载改变了工作流列表或模板内容 */
+DECLARE_MULTICAST_DELEGATE(FOnComfyUIWorkflowsChanged);
+
+/**
+ * 已注册工作流的句柄
+ * 调用方按名称解析一次后用句柄访问工作流，不再逐次按名称查找。
+ * 重新加载或清空工作流配置后旧句柄失效，解析结果为空。
+ */
+struct COMFYUIINTEGRATION_API FComfyUIWorkflowHandle
+{
+    int32 Index = INDEX_NONE;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != INDEX_NONE; }
+};
+
+/**
+ * 模板文件的索引信息，启动时只读取目录项，不读取内容
+ */
+struct COMFYUIINTEGRATION_API FComfyUIWorkflowFileStamp
+{
+    FString Path;
+    int64 Size = INDEX_NONE;
+    FDateTime ModificationTime;
+};
+
+/**
+ * 注册表中每个工作流的加载状态
+ */
+struct COMFYUIINTEGRATION_API FComfyUIWorkflowEntry
+{
+    /** 编译后的模板，尚未编译时为空 */
+    TSharedPtr<const FComfyUICompiledTemplate> Compiled;
+
+    /** 模板文件的索引信息，不是从文件加载的工作流为空 */
+    FComfyUIWorkflowFileStamp FileStamp;
+
+    /** 是否已完成节点分析（输入输出和工作流类型），启动加载时推迟到第一次选中 */
+    bool bAnalyzed = false;
+
+    /** 模板文件已删除，下标保留以免其他句柄指向错误的工作流 */
+    bool bRemoved = false;
+
+    /** 是否在编译时优化节点图，默认关闭：按类名判断输出节点可能误删有副作用的自定义节点 */
+    bool bOptimizeGraph = false;
+
+    /** 优化节点图后重新编译的模板，启用优化后第一次取模板时生成，模板替换时清空 */
+    TSharedPtr<const FComfyUICompiledTemplate> OptimizedCompiled;
+};
 
 /**
  * ComfyUI工作流管理器
@@ -36,6 +90,27 @@ public:
     /** 获取所有可用工作流名称 */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|Workflow")
     TArray<FString> GetAvailableWorkflowNames() const;
+    
+    /** 按名称解析工作流句柄，不存在时返回无效句柄 */
+    FComfyUIWorkflowHandle FindWorkflow(const FString& WorkflowName) const;
+    
+    /** 按句柄获取工作流配置，句柄无效或已过期时返回空 */
+    const FWorkflowConfig* GetWorkflowConfig(const FComfyUIWorkflowHandle& Handle) const;
+    
+    /** 完成工作流的节点分析（输入输出和工作流类型），已分析过时直接返回 */
+    bool EnsureWorkflowAnalyzed(const FComfyUIWorkflowHandle& Handle);
+
+    // ========== 模板热重载 ==========
+    
+    /** 监视模板目录，文件变化时只重新加载变化的模板 */
+    void StartWatchingTemplates();
+    void StopWatchingTemplates();
+    
+    /** 重新加载指定的模板文件：新增的注册，修改的替换编译结果（保留已设置的参数），已删除的注销 */
+    void ReloadTemplateFiles(const TArray<FString>& AddedOrModified, const TArray<FString>& Removed);
+    
+    /** 热重载改变了工作流列表或模板内容时广播（游戏线程） */
+    FOnComfyUIWorkflowsChanged OnWorkflowsChanged;
 
     // ========== 工作流验证 ==========
     
@@ -69,6 +144,13 @@ public:
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|Workflow")
     FString BuildWorkflowJson(const FString& CustomWorkflowName);
     
+    /** 用类型化的绑定构建 /prompt 请求JSON，Bindings 覆盖工作流中已设置的参数 */
+    FString BuildWorkflowRequest(const FString& WorkflowName, const FComfyUITemplateBindings& Bindings);
+    
+    /** 获取工作流模板句柄（编译模板和当前参数的快照），工作流不存在或模板无效时返回无效句柄 */
+    FComfyUIWorkflowTemplate GetWorkflowTemplate(const FString& WorkflowName);
+    FComfyUIWorkflowTemplate GetWorkflowTemplate(const FComfyUIWorkflowHandle& Handle);
+    
     /** 替换工作流模板中的占位符 */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|Workflow")
     FString ReplaceWorkflowPlaceholders(const FString& WorkflowTemplate, 
@@ -83,6 +165,13 @@ public:
     /** 获取工作流参数 */
     UFUNCTION(BlueprintCallable, Category = "ComfyUI|Workflow")
     FString GetWorkflowParameter(const FString& WorkflowName, const FString& ParameterName) const;
+    
+    /**
+     * 启用或关闭工作流的节点图优化（合并重复的加载节点、删除多余的预览和不可达的分支）
+     * 优化在模板编译时执行一次，之后取出的模板句柄使用优化后的模板；已取出的句柄不受影响
+     */
+    UFUNCTION(BlueprintCallable, Category = "ComfyUI|Workflow")
+    bool SetWorkflowGraphOptimization(const FString& WorkflowName, bool bEnabled);
 
     // ========== 工具函数 ==========
     
@@ -110,7 +199,72 @@ private:
     /** 清理工作流名称 */
     FString SanitizeWorkflowName(const FString& Name) const;
     
+    /** 分析工作流节点，填写配置中的输入输出和工作流类型 */
+    void AnalyzeWorkflowConfig(TSharedPtr<FJsonObject> WorkflowJson, FWorkflowConfig& OutConfig);
+    
+    /** 共用的节点分析器，只在游戏线程使用 */
+    UComfyUINodeAnalyzer* GetNodeAnalyzer();
+    
+    /** 分析结果的磁盘缓存，第一次使用时加载 */
+    FComfyUIWorkflowAnalysisCache& GetAnalysisCache();
+    
+    /** 把工作流的分析结果写入磁盘缓存 */
+    void CacheWorkflowAnalysis(int32 Index);
+    
+    /** 注册已读取和编译的模板文件，节点分析推迟到第一次选中 */
+    bool RegisterTemplateFile(const FComfyUIWorkflowFileStamp& Stamp, FString&& Content, TSharedPtr<const FComfyUICompiledTemplate> Compiled);
+    
+    /** 获取工作流的编译模板，尚未编译时加载模板并编译 */
+    TSharedPtr<const FComfyUICompiledTemplate> GetCompiledTemplate(int32 Index);
+    
+    /** 获取优化节点图后的编译模板，第一次调用时优化并编译，没有可优化的节点时沿用原模板 */
+    TSharedPtr<const FComfyUICompiledTemplate> GetOptimizedTemplate(int32 Index);
+    
+    // ========== 工作流注册表 ==========
+    
+    /** 按名称查找注册表下标，未注册的名称返回 nullptr */
+    const int32* FindNameIndex(const FString& WorkflowName) const;
+    
+    /** 名称或内容与已注册的工作流重复时返回 true 并给出原因 */
+    bool IsDuplicateWorkflow(const FString& WorkflowName, const FComfyUICompiledTemplate* Compiled, FString& OutError) const;
+    
+    /** 注册工作流并建立索引，重复时拒绝 */
+    FComfyUIWorkflowHandle RegisterWorkflow(FWorkflowConfig&& Config, FComfyUIWorkflowEntry&& Entry, FString& OutError);
+    
+    /** 清空注册表，已发出的句柄随之失效 */
+    void ResetRegistry();
+    
+    /** 用重新编译的模板替换已注册的工作流，内容没有变化时只更新文件信息并返回 false */
+    bool ReplaceTemplateFile(int32 Index, const FComfyUIWorkflowFileStamp& Stamp, FString&& Content, TSharedPtr<const FComfyUICompiledTemplate> Compiled);
+    
+    /** 注销工作流，下标不再复用 */
+    void UnregisterWorkflow(int32 Index);
+    
+    /** 模板目录的变化通知 */
+    void OnTemplateDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+    
     /** 根据名称查找工作流配置的内部版本 */
     FWorkflowConfig* FindWorkflowConfigInternal(const FString& WorkflowName);
     const FWorkflowConfig* FindWorkflowConfigInternal(const FString& WorkflowName) const;
+    
+    /** 每个工作流的加载状态，与 CustomWorkflowConfigs 下标对应 */
+    TArray<FComfyUIWorkflowEntry> RegistryEntries;
+    
+    /** 名称（不区分大小写）到 CustomWorkflowConfigs 下标 */
+    TMap<FName, int32> NameIndex;
+    
+    /** 模板内容哈希到 CustomWorkflowConfigs 下标，用于拒绝重复导入 */
+    TMap<uint64, int32> ContentHashIndex;
+    
+    /** 注册表的代数，每次清空后递增 */
+    uint32 RegistryGeneration = 1;
+    
+    UPROPERTY()
+    TObjectPtr<UComfyUINodeAnalyzer> NodeAnalyzer;
+    
+    TSharedPtr<FComfyUIWorkflowAnalysisCache> AnalysisCache;
+    
+    /** 模板目录监视 */
+    FString WatchedTemplatesDirectory;
+    FDelegateHandle TemplateWatcherHandle;
 };
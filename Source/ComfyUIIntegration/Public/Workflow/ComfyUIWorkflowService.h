@@ -4,9 +4,10 @@
 #include "UObject/NoExportTypes.h"
 #include "ComfyUIWorkflowConfig.h"
 #include "ComfyUIExecutionTypes.h"
+#include "Workflow/ComfyUICompiledTemplate.h"
+#include "Workflow/ComfyUIWorkflowManager.h"
 #include "ComfyUIWorkflowService.generated.h"
 
-class UComfyUIWorkflowManager;
 class FJsonObject;
 
 /**
@@ -54,9 +55,22 @@ public:
 
     // ========== JSON构建接口 ==========
     
-    /** 构建工作流JSON - 使用完整的FComfyUIWorkflowInput参数 */
+    /** 构建工作流JSON - 使用完整的FComfyUIWorkflowInput参数，输入只用于本次构建，不写入工作流配置 */
     FString BuildWorkflowJson(const FString& WorkflowName, 
                              const FComfyUIWorkflowInput& Input);
+    
+    /** 获取工作流模板句柄，句柄可以在任意线程用不同的绑定构建请求 */
+    FComfyUIWorkflowTemplate GetWorkflowTemplate(const FString& WorkflowName);
+    FComfyUIWorkflowTemplate GetWorkflowTemplate(const FComfyUIWorkflowHandle& Handle);
+    
+    /** 按名称解析工作流句柄，批量构建时解析一次后复用 */
+    FComfyUIWorkflowHandle FindWorkflow(const FString& WorkflowName) const;
+    
+    /** 模板热重载改变了工作流列表或模板内容时广播 */
+    FOnComfyUIWorkflowsChanged& OnWorkflowsChanged();
+    
+    /** 把工作流输入转换为模板绑定：键转为大写，数值和布尔保留类型 */
+    static FComfyUITemplateBindings MakeBindings(const FComfyUIWorkflowInput& Input);
 
     // ========== 参数管理接口 ==========
     
@@ -65,6 +79,9 @@ public:
     
     /** 获取工作流参数值 */
     FString GetWorkflowParameter(const FString& WorkflowName, const FString& ParameterName) const;
+    
+    /** 启用或关闭工作流的节点图优化，在模板编译时执行一次 */
+    bool SetWorkflowGraphOptimization(const FString& WorkflowName, bool bEnabled);
 
     // ========== 便捷接口 ==========
     